@@ -8,6 +8,8 @@
 #include <ostream>
 
 #include <typeinfo>
+#include <utility>
+#include <vector>
 
 #if SAAM_BORROW_CHECKING_MODE == 1
 #include <stacktrace>
@@ -25,24 +27,44 @@ void dangling_reference_panic(const std::type_info &var_type, void *var_instance
               << std::flush;
 }
 #elif SAAM_BORROW_CHECKING_MODE == 1
-// Tracked mode panic
+// Tracked mode panic, it is called once per creation site of the dangling references
 void dangling_reference_panic(const std::type_info &var_type,
                               void *var_instance,
                               const std::stacktrace &var_destruction_stack,
-                              std::size_t dangling_ref_index,
-                              const std::stacktrace &dangling_ref_creation_stack) noexcept
+                              std::size_t num_dangling_references,
+                              const saam::raw_stacktrace &dangling_ref_creation_stack) noexcept
 {
-    if (dangling_ref_index == 0)
+    // The destruction is reported only on the first call for the var
+    static const void *reported_var_instance = nullptr;
+    if (std::exchange(reported_var_instance, var_instance) != var_instance)
     {
         std::cerr << "Panic: saam::var of type <" << var_type.name() << "> at " << var_instance
                   << " destroyed with dangling references. saam::var destroyed at:\n"
                   << var_destruction_stack << std::flush;
     }
-    std::cerr << "\n---------- Dangling Reference #" << dangling_ref_index
-              << " creation stack --------------------------------------------\n"
+    std::cerr << "\n---------- " << num_dangling_references
+              << " references created at: --------------------------------------------\n"
               << dangling_ref_creation_stack << '\n'
               << std::flush;
 }
+#elif SAAM_BORROW_CHECKING_MODE == 3
+// Sampled mode panic
+void dangling_reference_panic(const std::type_info &var_type,
+                              void *var_instance,
+                              std::size_t num_dangling_references,
+                              const std::vector<saam::raw_stacktrace> &sampled_ref_creation_stacks) noexcept
+{
+    std::cerr << "Panic: saam::var of type <" << var_type.name() << "> at " << var_instance << " destroyed with " << num_dangling_references
+              << " dangling references\n"
+              << std::flush;
+    for (std::size_t i = 0; i < sampled_ref_creation_stacks.size(); i++)
+    {
+        std::cerr << "\n---------- Sampled Dangling Reference #" << i
+                  << " creation stack --------------------------------------------\n"
+                  << sampled_ref_creation_stacks[i] << '\n'
+                  << std::flush;
+    }
+}
 #endif
 
 }  // namespace saam
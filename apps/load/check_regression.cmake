@@ -0,0 +1,58 @@
+# SPDX-FileCopyrightText: Leica Geosystems AG
+#
+# SPDX-License-Identifier: MIT
+
+# Runs the load generator of a mode and the unchecked one, and compares the overhead of the mode with its saved baseline.
+# The overhead is the throughput of the unchecked mode divided by the throughput of the mode, in percent.
+# Usage: cmake -DMODE_NAME=<mode> -DLOAD_GENERATOR=<path> -DREFERENCE_LOAD_GENERATOR=<path> -DLOAD_ARGUMENTS=<list>
+#              -DBASELINE_FILE=<path> -DTOLERANCE_PERCENT=<percent> [-DUPDATE_BASELINE=ON] -P check_regression.cmake
+
+foreach(REQUIRED_VARIABLE MODE_NAME LOAD_GENERATOR REFERENCE_LOAD_GENERATOR BASELINE_FILE TOLERANCE_PERCENT)
+    if (NOT DEFINED ${REQUIRED_VARIABLE})
+        message(FATAL_ERROR "${REQUIRED_VARIABLE} is not defined")
+    endif()
+endforeach()
+
+function(run_load_generator EXECUTABLE RESULT_VARIABLE)
+    execute_process(
+        COMMAND ${EXECUTABLE} ${LOAD_ARGUMENTS}
+        OUTPUT_VARIABLE OUTPUT
+        ERROR_VARIABLE ERROR
+        RESULT_VARIABLE EXIT_CODE
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+    )
+    if (NOT EXIT_CODE EQUAL 0)
+        message(FATAL_ERROR "${EXECUTABLE} failed with ${EXIT_CODE}:\n${OUTPUT}\n${ERROR}")
+    endif()
+
+    message(STATUS "${OUTPUT}")
+    if (NOT OUTPUT MATCHES "ops_per_second=([0-9]+)" OR CMAKE_MATCH_1 EQUAL 0)
+        message(FATAL_ERROR "No throughput is reported by ${EXECUTABLE}")
+    endif()
+    set(${RESULT_VARIABLE} ${CMAKE_MATCH_1} PARENT_SCOPE)
+endfunction()
+
+run_load_generator(${REFERENCE_LOAD_GENERATOR} REFERENCE_OPS_PER_SECOND)
+run_load_generator(${LOAD_GENERATOR} OPS_PER_SECOND)
+
+math(EXPR OVERHEAD_PERCENT "${REFERENCE_OPS_PER_SECOND} * 100 / ${OPS_PER_SECOND}")
+message(STATUS "Overhead of the ${MODE_NAME} mode: ${OVERHEAD_PERCENT}% of the unchecked mode")
+
+if (UPDATE_BASELINE)
+    file(WRITE ${BASELINE_FILE} "${OVERHEAD_PERCENT}\n")
+    message(STATUS "Baseline saved to ${BASELINE_FILE}")
+    return()
+endif()
+
+if (NOT EXISTS ${BASELINE_FILE})
+    message(FATAL_ERROR "No baseline at ${BASELINE_FILE}, save one with -DSAAM_LOAD_UPDATE_BASELINES=ON")
+endif()
+
+file(READ ${BASELINE_FILE} BASELINE_PERCENT)
+string(STRIP "${BASELINE_PERCENT}" BASELINE_PERCENT)
+math(EXPR LIMIT_PERCENT "${BASELINE_PERCENT} * (100 + ${TOLERANCE_PERCENT}) / 100")
+if (OVERHEAD_PERCENT GREATER LIMIT_PERCENT)
+    message(FATAL_ERROR "The ${MODE_NAME} mode regressed: its overhead is ${OVERHEAD_PERCENT}%, "
+                        "the baseline is ${BASELINE_PERCENT}% with a tolerance up to ${LIMIT_PERCENT}%")
+endif()
+message(STATUS "The overhead is within the limit of ${LIMIT_PERCENT}% (baseline ${BASELINE_PERCENT}%)")
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/any_ptr.hpp>
+#include <saam/safe_ref.hpp>
+#include <saam/synchronized.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace load
+{
+
+// The part of a component, which is written by the threads
+struct component_state
+{
+    std::uint64_t total = 0;
+    std::uint64_t num_writes = 0;
+};
+
+class component
+{
+  public:
+    explicit component(std::uint64_t id) :
+        id_(id),
+        state_(std::make_unique<saam::synchronized<component_state>>())
+    {
+    }
+
+    // Like in the demo, a component uses its peer, but cannot destroy it
+    void connect(saam::any_ptr<component> peer)
+    {
+        peer_ = std::move(peer);
+    }
+
+    // The peers refer to each other, so they must be disconnected before any of them is destroyed
+    void disconnect()
+    {
+        peer_.reset();
+    }
+
+    [[nodiscard]] std::uint64_t id() const noexcept
+    {
+        return id_;
+    }
+
+    [[nodiscard]] std::uint64_t peer_id() const
+    {
+        return peer_->id();
+    }
+
+    [[nodiscard]] std::uint64_t read_total() const
+    {
+        return state_->commence()->total;
+    }
+
+    void add(std::uint64_t value)
+    {
+        auto state = state_->commence_mut();
+        state->total += value;
+        state->num_writes++;
+    }
+
+  private:
+    std::uint64_t id_;
+    saam::any_ptr<component> peer_;
+    // The synchronized is allocated, so the component stays nothrow movable, as the var requires
+    std::unique_ptr<saam::synchronized<component_state>> state_;
+};
+
+}  // namespace load
@@ -0,0 +1,258 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "component.hpp"
+
+#include <saam/any_ptr.hpp>
+#include <saam/safe_ref.hpp>
+#include <saam/synchronized.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <numeric>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace load
+{
+
+// The operations of the mix
+enum class operation : std::uint8_t
+{
+    // Call of the component through var::operator->
+    arrow,
+    // Borrow of the component, the ref is parked for another thread, which destroys it
+    handoff,
+    // Call of the peer component through the any_ptr of the component
+    any_ptr_call,
+    // Shared critical section of the synchronized state of the component
+    read,
+    // Exclusive critical section of the synchronized state of the component
+    write,
+};
+
+inline constexpr std::size_t num_operations = 5;
+inline constexpr std::array<std::string_view, num_operations> operation_names{"arrow", "handoff", "any_ptr", "read", "write"};
+
+struct load_options
+{
+    std::size_t num_threads = 4;
+    std::size_t num_components = 64;
+    std::chrono::milliseconds duration{300};
+    // The repetition with the best throughput is reported
+    std::size_t num_repetitions = 3;
+    // Relative weights of the operations, indexed by the operation
+    std::array<std::uint32_t, num_operations> mix{40, 20, 20, 15, 5};
+    // The latency is measured for one of this many operations, so the clock does not dominate the measured throughput
+    std::uint32_t latency_sampling_period = 64;
+};
+
+struct load_report
+{
+    std::uint64_t num_operations = 0;
+    std::chrono::nanoseconds elapsed{};
+    double operations_per_second = 0;
+    std::chrono::nanoseconds p50_latency{};
+    std::chrono::nanoseconds p99_latency{};
+    std::chrono::nanoseconds p999_latency{};
+};
+
+// Multithreaded load on a system of components: the threads pick an operation by the weights of the mix, on a random component
+class load_generator
+{
+  public:
+    explicit load_generator(const load_options &options) :
+        options_(options)
+    {
+        for (std::size_t index = 0; index < options_.num_components; index++)
+        {
+            components_.emplace_back(std::in_place, static_cast<std::uint64_t>(index));
+            handoff_slots_.emplace_back();
+        }
+
+        // The components form a ring of peers
+        for (std::size_t index = 0; index < options_.num_components; index++)
+        {
+            components_[index]->connect(saam::make_any_ptr(components_[(index + 1) % options_.num_components]));
+        }
+
+        std::partial_sum(options_.mix.begin(), options_.mix.end(), cumulative_mix_.begin());
+    }
+
+    load_generator(const load_generator &other) = delete;
+    load_generator(load_generator &&other) noexcept = delete;
+    load_generator &operator=(const load_generator &other) = delete;
+    load_generator &operator=(load_generator &&other) noexcept = delete;
+
+    ~load_generator()
+    {
+        // The parked refs and the peers are released before the components are destroyed
+        handoff_slots_.clear();
+        for (auto &component : components_)
+        {
+            component->disconnect();
+        }
+    }
+
+    [[nodiscard]] load_report run()
+    {
+        load_report best_report;
+        for (std::size_t repetition = 0; repetition < options_.num_repetitions; repetition++)
+        {
+            auto report = run_once();
+            if (report.operations_per_second > best_report.operations_per_second)
+            {
+                best_report = report;
+            }
+        }
+        return best_report;
+    }
+
+  private:
+    struct worker_result
+    {
+        std::uint64_t num_operations = 0;
+        std::vector<std::chrono::nanoseconds> latencies;
+        // Keeps the results of the operations alive for the optimizer
+        std::uint64_t checksum = 0;
+    };
+
+    load_report run_once()
+    {
+        std::vector<worker_result> results(options_.num_threads);
+        std::atomic<bool> started = false;
+        std::atomic<bool> stopped = false;
+        std::vector<std::jthread> workers;
+        for (std::size_t thread_index = 0; thread_index < options_.num_threads; thread_index++)
+        {
+            workers.emplace_back([this, thread_index, &started, &stopped, &result = results[thread_index]]() {
+                started.wait(false, std::memory_order_acquire);
+                work(thread_index, stopped, result);
+            });
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        started.store(true, std::memory_order_release);
+        started.notify_all();
+        std::this_thread::sleep_for(options_.duration);
+        stopped.store(true, std::memory_order_relaxed);
+        workers.clear();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        load_report report;
+        report.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+        std::vector<std::chrono::nanoseconds> latencies;
+        for (auto &result : results)
+        {
+            report.num_operations += result.num_operations;
+            latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        }
+        report.operations_per_second = static_cast<double>(report.num_operations) / std::chrono::duration<double>(elapsed).count();
+        report.p50_latency = percentile(latencies, 0.5);
+        report.p99_latency = percentile(latencies, 0.99);
+        report.p999_latency = percentile(latencies, 0.999);
+        return report;
+    }
+
+    void work(std::size_t thread_index, const std::atomic<bool> &stopped, worker_result &result)
+    {
+        // xorshift64, each thread has its own sequence
+        std::uint64_t random_state = 0x9E3779B97F4A7C15ULL * (thread_index + 1);
+        const auto next_random = [&random_state]() {
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 7;
+            random_state ^= random_state << 17;
+            return random_state;
+        };
+
+        // The stop flag is checked once per batch
+        constexpr std::size_t batch_size = 256;
+        while (!stopped.load(std::memory_order_relaxed))
+        {
+            for (std::size_t i = 0; i < batch_size; i++)
+            {
+                const auto random = next_random();
+                const auto picked = pick(static_cast<std::uint32_t>(random));
+                const auto index = static_cast<std::size_t>((random >> 32) % options_.num_components);
+
+                if (result.num_operations % options_.latency_sampling_period == 0)
+                {
+                    const auto start = std::chrono::steady_clock::now();
+                    result.checksum += execute(picked, index);
+                    result.latencies.push_back(std::chrono::steady_clock::now() - start);
+                }
+                else
+                {
+                    result.checksum += execute(picked, index);
+                }
+                result.num_operations++;
+            }
+        }
+    }
+
+    [[nodiscard]] operation pick(std::uint32_t random) const noexcept
+    {
+        const auto point = random % cumulative_mix_.back();
+        const auto found = std::upper_bound(cumulative_mix_.begin(), cumulative_mix_.end(), point);
+        return static_cast<operation>(found - cumulative_mix_.begin());
+    }
+
+    std::uint64_t execute(operation picked, std::size_t index)
+    {
+        auto &component = components_[index];
+        switch (picked)
+        {
+        case operation::arrow:
+            return component->id();
+        case operation::handoff: {
+            std::optional<saam::ref<load::component>> fresh_ref(component.borrow());
+            std::optional<saam::ref<load::component>> parked_ref;
+            {
+                auto slot = handoff_slots_[index].commence_mut();
+                parked_ref = std::exchange(*slot, std::move(fresh_ref));
+            }
+            // The parked ref was created by any of the threads, it is destroyed outside of the critical section
+            return parked_ref ? (*parked_ref)->id() : 0;
+        }
+        case operation::any_ptr_call:
+            return component->peer_id();
+        case operation::read:
+            return component->read_total();
+        case operation::write:
+            component->add(index);
+            return 0;
+        }
+        return 0;
+    }
+
+    static std::chrono::nanoseconds percentile(std::vector<std::chrono::nanoseconds> &latencies, double fraction)
+    {
+        if (latencies.empty())
+        {
+            return {};
+        }
+
+        const auto rank = std::min(latencies.size() - 1, static_cast<std::size_t>(fraction * static_cast<double>(latencies.size())));
+        std::nth_element(latencies.begin(), latencies.begin() + static_cast<std::ptrdiff_t>(rank), latencies.end());
+        return latencies[rank];
+    }
+
+    load_options options_;
+    std::array<std::uint32_t, num_operations> cumulative_mix_{};
+    // The system is the owner of the components, the vars are not moved by the growth of the deque
+    std::deque<saam::var<component>> components_;
+    std::deque<saam::synchronized<std::optional<saam::ref<component>>>> handoff_slots_;
+};
+
+}  // namespace load
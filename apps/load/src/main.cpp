@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include "load_generator.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <system_error>
+
+namespace
+{
+
+constexpr std::string_view mode_name()
+{
+#if SAAM_BORROW_CHECKING_MODE == 0
+    return "counted";
+#elif SAAM_BORROW_CHECKING_MODE == 1
+    return "tracked";
+#elif SAAM_BORROW_CHECKING_MODE == 2
+    return "unchecked";
+#elif SAAM_BORROW_CHECKING_MODE == 3
+    return "sampled";
+#else
+    return "unknown";
+#endif
+}
+
+void print_usage(std::ostream &stream)
+{
+    stream << "Usage: saam_load_<mode> [--threads=N] [--components=M] [--duration-ms=D] [--repetitions=R] [--mix=arrow:W,handoff:W,...]\n"
+           << "The weights of the mix are relative, the operations are: arrow, handoff, any_ptr, read, write.\n";
+}
+
+template <typename TNumber>
+std::optional<TNumber> parse_number(std::string_view text)
+{
+    TNumber number{};
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+    if (error != std::errc{} || end != text.data() + text.size())
+    {
+        return std::nullopt;
+    }
+    return number;
+}
+
+// Parses a comma separated list of <operation>:<weight>, the unlisted operations get a weight of 0
+bool parse_mix(std::string_view text, std::array<std::uint32_t, load::num_operations> &mix)
+{
+    mix.fill(0);
+    while (!text.empty())
+    {
+        const auto item = text.substr(0, text.find(','));
+        text.remove_prefix(std::min(text.size(), item.size() + 1));
+
+        const auto separator = item.find(':');
+        if (separator == std::string_view::npos)
+        {
+            return false;
+        }
+        const auto found = std::find(load::operation_names.begin(), load::operation_names.end(), item.substr(0, separator));
+        const auto weight = parse_number<std::uint32_t>(item.substr(separator + 1));
+        if (found == load::operation_names.end() || !weight)
+        {
+            return false;
+        }
+        mix[static_cast<std::size_t>(found - load::operation_names.begin())] = *weight;
+    }
+    return std::any_of(mix.begin(), mix.end(), [](std::uint32_t weight) { return weight != 0; });
+}
+
+bool parse_options(int argc, char **argv, load::load_options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view argument(argv[i]);
+        const auto separator = argument.find('=');
+        if (separator == std::string_view::npos)
+        {
+            return false;
+        }
+
+        const auto name = argument.substr(0, separator);
+        const auto value = argument.substr(separator + 1);
+        if (name == "--mix")
+        {
+            if (!parse_mix(value, options.mix))
+            {
+                return false;
+            }
+            continue;
+        }
+
+        const auto number = parse_number<std::size_t>(value);
+        if (!number || *number == 0)
+        {
+            return false;
+        }
+        if (name == "--threads")
+        {
+            options.num_threads = *number;
+        }
+        else if (name == "--components")
+        {
+            options.num_components = *number;
+        }
+        else if (name == "--duration-ms")
+        {
+            options.duration = std::chrono::milliseconds(*number);
+        }
+        else if (name == "--repetitions")
+        {
+            options.num_repetitions = *number;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    load::load_options options;
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage(std::cerr);
+        return 2;
+    }
+
+    load::load_report report;
+    {
+        load::load_generator generator(options);
+        report = generator.run();
+    }
+
+    // A single line of key=value pairs, check_regression.cmake parses it
+    std::cout << "mode=" << mode_name() << " threads=" << options.num_threads << " components=" << options.num_components << " mix=";
+    for (std::size_t index = 0; index < load::num_operations; index++)
+    {
+        std::cout << (index == 0 ? "" : ",") << load::operation_names[index] << ':' << options.mix[index];
+    }
+    std::cout << " operations=" << report.num_operations << " ops_per_second=" << static_cast<std::uint64_t>(report.operations_per_second)
+              << " p50_ns=" << report.p50_latency.count() << " p99_ns=" << report.p99_latency.count()
+              << " p999_ns=" << report.p999_latency.count() << '\n';
+    return 0;
+}
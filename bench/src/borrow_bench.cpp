@@ -0,0 +1,136 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/any_ptr.hpp>
+#include <saam/safe_ref.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace saam::bench
+{
+
+struct payload
+{
+    std::int64_t value = 0;
+
+    void increment() noexcept
+    {
+        value++;
+    }
+};
+
+void var_borrow(benchmark::State &state)
+{
+    var<payload> instance;
+    for (auto _ : state)
+    {
+        auto instance_ref = instance.borrow();
+        benchmark::DoNotOptimize(instance_ref);
+    }
+}
+BENCHMARK(var_borrow);
+
+void ref_copy(benchmark::State &state)
+{
+    var<payload> instance;
+    const ref<payload> instance_ref = instance.borrow();
+    for (auto _ : state)
+    {
+        ref<payload> copied_ref = instance_ref;
+        benchmark::DoNotOptimize(copied_ref);
+    }
+}
+BENCHMARK(ref_copy);
+
+void ref_move(benchmark::State &state)
+{
+    var<payload> instance;
+    std::optional<ref<payload>> instance_ref = instance.borrow();
+    for (auto _ : state)
+    {
+        ref<payload> moved_ref = std::move(*instance_ref);
+        benchmark::DoNotOptimize(moved_ref);
+        instance_ref = std::move(moved_ref);
+    }
+}
+BENCHMARK(ref_move);
+
+void ref_assign(benchmark::State &state)
+{
+    var<payload> first;
+    var<payload> second;
+    const ref<payload> first_ref = first.borrow();
+    const ref<payload> second_ref = second.borrow();
+    ref<payload> assigned_ref = first.borrow();
+    for (auto _ : state)
+    {
+        assigned_ref = second_ref;
+        assigned_ref = first_ref;
+        benchmark::DoNotOptimize(assigned_ref);
+    }
+}
+BENCHMARK(ref_assign);
+
+void var_member_access(benchmark::State &state)
+{
+    var<payload> instance;
+    for (auto _ : state)
+    {
+        instance->increment();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(var_member_access);
+
+void ref_member_access(benchmark::State &state)
+{
+    var<payload> instance;
+    const ref<payload> instance_ref = instance.borrow();
+    for (auto _ : state)
+    {
+        instance_ref->increment();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(ref_member_access);
+
+// The refs must be released before the var, otherwise the var panics:
+// the lifecycle of a var with N refs is measured, which includes the cost of the destruction of the var
+void var_lifecycle_with_refs(benchmark::State &state)
+{
+    const auto num_refs = static_cast<std::size_t>(state.range(0));
+    std::vector<ref<payload>> refs;
+    refs.reserve(num_refs);
+    for (auto _ : state)
+    {
+        std::optional<var<payload>> instance{std::in_place};
+        for (std::size_t i = 0; i < num_refs; i++)
+        {
+            refs.emplace_back(instance->borrow());
+        }
+        refs.clear();
+        instance.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(var_lifecycle_with_refs)->RangeMultiplier(8)->Range(1, 512);
+
+void any_ptr_dereference(benchmark::State &state)
+{
+    var<payload> instance;
+    const auto instance_ptr = make_any_ptr(instance);
+    for (auto _ : state)
+    {
+        instance_ptr->increment();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(any_ptr_dereference);
+
+}  // namespace saam::bench
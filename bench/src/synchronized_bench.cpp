@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/synchronized.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+namespace saam::bench
+{
+
+// Shared by all the threads of a benchmark
+struct counter
+{
+    std::int64_t value = 0;
+};
+
+synchronized<counter> shared_counter;
+
+void synchronized_commence(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        auto counter_guard = shared_counter.commence();
+        benchmark::DoNotOptimize(counter_guard->value);
+    }
+}
+BENCHMARK(synchronized_commence)->ThreadRange(1, 8)->UseRealTime();
+
+void synchronized_commence_mut(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        auto counter_guard = shared_counter.commence_mut();
+        counter_guard->value++;
+    }
+}
+BENCHMARK(synchronized_commence_mut)->ThreadRange(1, 8)->UseRealTime();
+
+synchronized<counter, seqlock_policy> seqlocked_counter;
+
+void synchronized_snapshot(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        auto counter_copy = seqlocked_counter.snapshot();
+        benchmark::DoNotOptimize(counter_copy.value);
+    }
+}
+BENCHMARK(synchronized_snapshot)->ThreadRange(1, 8)->UseRealTime();
+
+}  // namespace saam::bench
@@ -18,17 +18,21 @@ class SaamPackage(ConanFile):
 
     no_copy_source = True
 
-    exports_sources = "include/*", "CMakeLists.txt", "conanfile.py", "test/*", "test_package/*", "template/*"
+    exports_sources = "include/*", "CMakeLists.txt", "conanfile.py", "test/*", "bench/*", "apps/load/*", "test_package/*", "template/*"
 
     generators = "CMakeDeps", "VirtualRunEnv", "VirtualBuildEnv"
 
     revision_mode = "scm"
 
     options = {
-        "bc_mode": ["unchecked", "counted", "tracked"],
+        "bc_mode": ["unchecked", "counted", "tracked", "sampled"],
+        "benchmarks": [True, False],
+        "load_tests": [True, False],
     }
     default_options = {
-        "bc_mode": "counted"
+        "bc_mode": "counted",
+        "benchmarks": False,
+        "load_tests": False,
     }
 
     def requirements(self):
@@ -36,6 +40,8 @@ class SaamPackage(ConanFile):
 
     def build_requirements(self):
         self.test_requires("gtest/[^1.11.0]@")
+        if self.options.benchmarks:
+            self.test_requires("benchmark/[^1.8.0]@")
 
     def generate(self):
         toolchain = CMakeToolchain(self)
@@ -44,7 +50,9 @@ class SaamPackage(ConanFile):
         v = Version(self.version)
         toolchain.cache_variables["SAAM_VERSION"] = f"{v.major}.{v.minor}.{v.patch}"
         self.output.info(f"BC mode: {self.options.bc_mode}")
-        toolchain.cache_variables["SAAM_BORROW_CHECKING_MODE_CMAKE"] = {"unchecked":"2", "counted":"0", "tracked":"1"}[str(self.options.bc_mode)]
+        toolchain.cache_variables["SAAM_BORROW_CHECKING_MODE_CMAKE"] = {"unchecked":"2", "counted":"0", "tracked":"1", "sampled":"3"}[str(self.options.bc_mode)]
+        toolchain.cache_variables["SAAM_BUILD_BENCHMARKS"] = bool(self.options.benchmarks)
+        toolchain.cache_variables["SAAM_BUILD_LOAD_TESTS"] = bool(self.options.load_tests)
         toolchain.generate()
 
     def build(self):
@@ -6,82 +6,332 @@
 
 #include <saam/safe_ref.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 
-namespace saam
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
+namespace detail
+{
+
+// Type-erased owner of an any_ptr: the captured source (e.g. a shared_ptr or a ref) that keeps the pointee alive.
+// The owners of the make_any_ptr sources are stored inline, so neither the copy nor the move of the any_ptr allocates.
+// The owner of a unique_any_ptr is move-only, it is not copied.
+template <bool TCopyable>
+class basic_any_ptr_owner
+{
+  public:
+    // Size of the inline storage, the owners that do not fit are allocated on the heap
+    static constexpr std::size_t inline_capacity = std::max(sizeof(std::shared_ptr<void>), sizeof(ref<std::byte>));
+
+    template <typename TOwner>
+    static constexpr bool is_stored_inline = sizeof(TOwner) <= inline_capacity && alignof(TOwner) <= alignof(std::max_align_t) &&
+                                             std::is_nothrow_move_constructible_v<TOwner>;
+
+    basic_any_ptr_owner() noexcept = default;
+
+    basic_any_ptr_owner(const basic_any_ptr_owner &other)
+        requires TCopyable
+        : operations_(other.operations_)
+    {
+        if (operations_ != nullptr)
+        {
+            operations_->copy(other.buffer_, buffer_);
+        }
+    }
+
+    basic_any_ptr_owner(basic_any_ptr_owner &&other) noexcept :
+        operations_(std::exchange(other.operations_, nullptr))
+    {
+        if (operations_ != nullptr)
+        {
+            operations_->move_and_destroy(other.buffer_, buffer_);
+        }
+    }
+
+    basic_any_ptr_owner &operator=(const basic_any_ptr_owner &other)
+        requires TCopyable
+    {
+        if (this != &other)
+        {
+            // Copy first, so a throwing copy leaves this intact
+            basic_any_ptr_owner copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    basic_any_ptr_owner &operator=(basic_any_ptr_owner &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            operations_ = std::exchange(other.operations_, nullptr);
+            if (operations_ != nullptr)
+            {
+                operations_->move_and_destroy(other.buffer_, buffer_);
+            }
+        }
+        return *this;
+    }
+
+    ~basic_any_ptr_owner()
+    {
+        reset();
+    }
+
+    // The owners that are not stored inline (or must not move, e.g. a var), are allocated on the heap
+    template <typename TOwner, bool TForceHeap = false, typename... Args>
+        requires(!TCopyable || std::is_copy_constructible_v<TOwner>)
+    TOwner &emplace(Args &&...args)
+    {
+        reset();
+        if constexpr (is_stored_inline<TOwner> && !TForceHeap)
+        {
+            auto *owner = ::new (static_cast<void *>(buffer_)) TOwner(std::forward<Args>(args)...);
+            operations_ = &inline_operations<TOwner>;
+            return *owner;
+        }
+        else
+        {
+            auto *owner = new TOwner(std::forward<Args>(args)...);
+            ::new (static_cast<void *>(buffer_)) TOwner *(owner);
+            operations_ = &heap_operations<TOwner>;
+            return *owner;
+        }
+    }
+
+    [[nodiscard]] bool has_value() const noexcept
+    {
+        return operations_ != nullptr;
+    }
+
+    void reset() noexcept
+    {
+        if (operations_ != nullptr)
+        {
+            std::exchange(operations_, nullptr)->destroy(buffer_);
+        }
+    }
+
+    // The address of the owner, it is stable only until the next move of the any_ptr
+    [[nodiscard]] const void *get() const noexcept
+    {
+        return operations_ == nullptr ? nullptr : operations_->get(buffer_);
+    }
+
+  private:
+    using copy_t = void (*)(const std::byte *source, std::byte *target);
+
+    struct operations
+    {
+        // Not set for the owners of a unique_any_ptr
+        copy_t copy;
+        void (*move_and_destroy)(std::byte *source, std::byte *target) noexcept;
+        void (*destroy)(std::byte *owner) noexcept;
+        const void *(*get)(const std::byte *owner) noexcept;
+    };
+
+    template <typename TOwner>
+    static TOwner *inline_owner(std::byte *buffer) noexcept
+    {
+        return std::launder(reinterpret_cast<TOwner *>(buffer));
+    }
+
+    template <typename TOwner>
+    static TOwner *heap_owner(const std::byte *buffer) noexcept
+    {
+        return *std::launder(reinterpret_cast<TOwner *const *>(buffer));
+    }
+
+    template <typename TOwner>
+    static constexpr operations inline_operations{
+        .copy = []() -> copy_t {
+            if constexpr (TCopyable)
+            {
+                return [](const std::byte *source, std::byte *target) {
+                    ::new (static_cast<void *>(target)) TOwner(*inline_owner<TOwner>(const_cast<std::byte *>(source)));
+                };
+            }
+            return nullptr;
+        }(),
+        .move_and_destroy = [](std::byte *source, std::byte *target) noexcept {
+            auto *source_owner = inline_owner<TOwner>(source);
+            ::new (static_cast<void *>(target)) TOwner(std::move(*source_owner));
+            source_owner->~TOwner();
+        },
+        .destroy = [](std::byte *owner) noexcept { inline_owner<TOwner>(owner)->~TOwner(); },
+        .get = [](const std::byte *owner) noexcept -> const void * { return inline_owner<TOwner>(const_cast<std::byte *>(owner)); },
+    };
+
+    template <typename TOwner>
+    static constexpr operations heap_operations{
+        .copy = []() -> copy_t {
+            if constexpr (TCopyable)
+            {
+                return [](const std::byte *source, std::byte *target) {
+                    ::new (static_cast<void *>(target)) TOwner *(new TOwner(*heap_owner<TOwner>(source)));
+                };
+            }
+            return nullptr;
+        }(),
+        .move_and_destroy = [](std::byte *source, std::byte *target) noexcept {
+            // Only the pointer moves, the owner stays where it is
+            ::new (static_cast<void *>(target)) TOwner *(heap_owner<TOwner>(source));
+        },
+        .destroy = [](std::byte *owner) noexcept { delete heap_owner<TOwner>(owner); },
+        .get = [](const std::byte *owner) noexcept -> const void * { return heap_owner<TOwner>(owner); },
+    };
+
+    alignas(std::max_align_t) std::byte buffer_[std::max(inline_capacity, sizeof(void *))];
+    const operations *operations_ = nullptr;
+};
+
+using any_ptr_owner = basic_any_ptr_owner<true>;
+using unique_any_ptr_owner = basic_any_ptr_owner<false>;
+
+}  // namespace detail
+
+// Type erased pointer: it refers to an instance of T, and keeps alive whatever the instance is borrowed from (a shared_ptr, a ref, ...).
+// The pointer of the make_any_ptr sources is resolved once at the construction, so the access is a plain pointer load.
+// An accessor function (std::function) is called on each access instead, for sources that yield a different pointer over time.
 template <typename T>
 class any_ptr
 {
   private:
-    std::function<T *()> accessor_;
+    // Set only for the accessor sources
+    using accessor_t = T *(*)(const void *owner);
+
+    T *ptr_ = nullptr;
+    accessor_t accessor_ = nullptr;
+    detail::any_ptr_owner owner_;
 
     template <typename U>
     friend class any_ptr;
 
+    template <typename TFunction>
+    void emplace_accessor(TFunction &&function)
+    {
+        using function_t = std::remove_cvref_t<TFunction>;
+        owner_.template emplace<function_t>(std::forward<TFunction>(function));
+        accessor_ = [](const void *owner) -> T * { return (*static_cast<const function_t *>(owner))(); };
+    }
+
   public:
     any_ptr() = default;
 
-    explicit any_ptr(std::function<T *()> accessor) :
-        accessor_(std::move(accessor))
+    // Non-owning, the instance must outlive the any_ptr
+    explicit any_ptr(T *ptr) noexcept :
+        ptr_(ptr)
+    {
+    }
+
+    // The owner keeps the instance alive, e.g. a shared_ptr or a ref to it
+    template <typename TOwner>
+        requires std::is_copy_constructible_v<std::remove_cvref_t<TOwner>>
+    any_ptr(T *ptr, TOwner &&owner) :
+        ptr_(ptr)
     {
+        owner_.template emplace<std::remove_cvref_t<TOwner>>(std::forward<TOwner>(owner));
+    }
+
+    explicit any_ptr(std::function<T *()> accessor)
+    {
+        if (accessor)
+        {
+            emplace_accessor(std::move(accessor));
+        }
     }
 
     template <typename U>
         requires std::is_convertible_v<U *, T *>
     explicit any_ptr(std::function<U *()> accessor) :
-        accessor_(std::move(accessor))
+        any_ptr(std::function<T *()>(std::move(accessor)))
+    {
+    }
+
+    any_ptr(const any_ptr &other) = default;
+
+    any_ptr(any_ptr &&other) noexcept :
+        ptr_(std::exchange(other.ptr_, nullptr)),
+        accessor_(std::exchange(other.accessor_, nullptr)),
+        owner_(std::move(other.owner_))
     {
     }
 
     template <typename U>
         requires std::is_convertible_v<U *, T *>
     any_ptr(const any_ptr<U> &other) :
-        accessor_(other.accessor_)
+        any_ptr(any_ptr<U>(other))
     {
     }
 
     template <typename U>
         requires std::is_convertible_v<U *, T *>
-    any_ptr(any_ptr<U> &&other) :
-        accessor_(std::move(other.accessor_))
+    any_ptr(any_ptr<U> &&other)
     {
+        if (other.accessor_ == nullptr)
+        {
+            ptr_ = std::exchange(other.ptr_, nullptr);
+            owner_ = std::move(other.owner_);
+        }
+        else
+        {
+            // The accessor of U cannot yield a T *, so the other any_ptr is wrapped
+            emplace_accessor([inner = std::move(other)]() -> T * { return inner.operator->(); });
+        }
     }
 
-    // Copy assignment copies the underlying lambda together with the captured variables
+    // Copy assignment copies the owner (e.g. the captured shared_ptr or ref) too
+    any_ptr &operator=(const any_ptr &other) = default;
+
     template <typename U>
         requires std::is_convertible_v<U *, T *>
     any_ptr &operator=(const any_ptr<U> &other)
     {
-        accessor_ = other.accessor_;
+        return *this = any_ptr(other);
+    }
+
+    // Move assignment moves the owner (e.g. the captured shared_ptr or ref) too
+    any_ptr &operator=(any_ptr &&other) noexcept
+    {
+        if (this != &other)
+        {
+            ptr_ = std::exchange(other.ptr_, nullptr);
+            accessor_ = std::exchange(other.accessor_, nullptr);
+            owner_ = std::move(other.owner_);
+        }
         return *this;
     }
 
-    // Move assignment moves the underlying lambda together with the captured variables
     template <typename U>
         requires std::is_convertible_v<U *, T *>
     any_ptr &operator=(any_ptr<U> &&other)
     {
-        accessor_ = std::move(other.accessor_);
-        return *this;
+        return *this = any_ptr(std::move(other));
     }
 
+    ~any_ptr() = default;
+
     T *operator->() const
     {
-        return accessor_();
+        return accessor_ == nullptr ? ptr_ : accessor_(owner_.get());
     }
 
     T &operator*() const
     {
-        return *accessor_();
+        return *operator->();
     }
 
     explicit operator bool() const
     {
-        return static_cast<bool>(accessor_) && accessor_() != nullptr;
+        return operator->() != nullptr;
     }
 
     bool operator!() const
@@ -91,7 +341,9 @@ class any_ptr
 
     void reset()
     {
-        accessor_ = {};
+        ptr_ = nullptr;
+        accessor_ = nullptr;
+        owner_.reset();
     }
 };
 
@@ -99,23 +351,24 @@ class any_ptr
 template <typename T>
 auto make_any_ptr(T &instance)
 {
-    return any_ptr<T>([ptr = &instance]() -> T * { return ptr; });
+    return any_ptr<T>(&instance);
 }
 
 template <typename T>
 auto make_any_ptr(T *ptr)
 {
-    return any_ptr<T>([ptr]() -> T * { return ptr; });
+    return any_ptr<T>(ptr);
 }
 
 // Smart pointer any_ptr factory function
 template <typename T>
 auto make_any_ptr(std::shared_ptr<T> ptr)
 {
-    return any_ptr<T>([ptr = std::move(ptr)]() -> T * { return ptr.get(); });
+    auto *instance = ptr.get();
+    return any_ptr<T>(instance, std::move(ptr));
 }
 
-// unique_ptr cannot be used, otherwise the std::function cannot be copied
+// unique_ptr cannot be used, otherwise the any_ptr cannot be copied
 template <typename T>
 auto make_any_ptr(std::unique_ptr<T> ptr) = delete;
 
@@ -123,13 +376,14 @@ auto make_any_ptr(std::unique_ptr<T> ptr) = delete;
 template <typename T>
 auto make_any_ptr(saam::var<T> &var)
 {
-    return any_ptr<T>([ref = var.borrow()]() -> T * { return &(*ref); });
+    return make_any_ptr(var.borrow());
 }
 
 template <typename T>
 auto make_any_ptr(saam::ref<T> ref)
 {
-    return any_ptr<T>([ref = std::move(ref)]() -> T * { return &(*ref); });
+    auto *instance = &(*ref);
+    return any_ptr<T>(instance, std::move(ref));
 }
 
 }  // namespace saam
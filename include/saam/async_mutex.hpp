@@ -0,0 +1,265 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/lock_policy.hpp>
+
+#include <concepts>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// An executor schedules the resumption of a coroutine, e.g. posts it into the queue of a thread pool
+template <typename TExecutor>
+concept coroutine_executor = std::copy_constructible<TExecutor> && std::invocable<TExecutor &, std::coroutine_handle<>>;
+
+// Resumes the coroutine right away, on the thread that releases the lock
+struct inline_executor
+{
+    void operator()(std::coroutine_handle<> coroutine) const
+    {
+        coroutine.resume();
+    }
+};
+
+namespace detail
+{
+
+// Coroutine waiting in the queue of an async_shared_mutex, it lives in the awaiter in the frame of the coroutine
+struct async_lock_waiter
+{
+    bool exclusive = false;
+    std::coroutine_handle<> coroutine;
+    void (*schedule)(async_lock_waiter &waiter) = nullptr;
+    async_lock_waiter *next = nullptr;
+};
+
+}  // namespace detail
+
+// Reader-writer mutex, that can be awaited by coroutines without blocking their thread.
+// The waiting coroutines are queued, and the lock is handed over to them in their order on each release (one writer, or the readers in a row),
+// then they are resumed by their executors. The blocking lock() and lock_shared() wait for the queued coroutines and the blocked writers first.
+// The lock is not bound to a thread, so a guard may be released on another thread than it was acquired on (after a co_await).
+// A suspended coroutine must not be destroyed until it is resumed, because its awaiter is linked into the queue.
+class async_shared_mutex
+{
+  public:
+    template <coroutine_executor TExecutor>
+    class lock_awaiter : private detail::async_lock_waiter
+    {
+      public:
+        lock_awaiter(async_shared_mutex &mutex, bool exclusive, TExecutor executor) :
+            mutex_(&mutex),
+            executor_(std::move(executor))
+        {
+            this->exclusive = exclusive;
+            this->schedule = [](detail::async_lock_waiter &waiter) {
+                auto &self = static_cast<lock_awaiter &>(waiter);
+                std::invoke(self.executor_, self.coroutine);
+            };
+        }
+
+        [[nodiscard]] bool await_ready()
+        {
+            return exclusive ? mutex_->try_lock() : mutex_->try_lock_shared();
+        }
+
+        // Returns false, when the lock was released in the meantime, so the coroutine is not suspended
+        bool await_suspend(std::coroutine_handle<> coroutine)
+        {
+            this->coroutine = coroutine;
+            return mutex_->enqueue(*this);
+        }
+
+        // The lock is owned by the coroutine
+        void await_resume() const noexcept
+        {
+        }
+
+      private:
+        async_shared_mutex *mutex_;
+        TExecutor executor_;
+    };
+
+    async_shared_mutex() noexcept = default;
+    async_shared_mutex(const async_shared_mutex &) = delete;
+    async_shared_mutex &operator=(const async_shared_mutex &) = delete;
+
+    void lock()
+    {
+        std::unique_lock state_lock(state_mutex_);
+        blocked_writers_++;
+        wait(state_lock, [this]() { return can_lock(); });
+        blocked_writers_--;
+        writer_ = true;
+    }
+
+    bool try_lock()
+    {
+        std::lock_guard state_lock(state_mutex_);
+        if (!can_lock())
+        {
+            return false;
+        }
+        writer_ = true;
+        return true;
+    }
+
+    void unlock()
+    {
+        std::unique_lock state_lock(state_mutex_);
+        writer_ = false;
+        release(state_lock);
+    }
+
+    void lock_shared()
+    {
+        std::unique_lock state_lock(state_mutex_);
+        wait(state_lock, [this]() { return can_lock_shared(); });
+        readers_++;
+    }
+
+    bool try_lock_shared()
+    {
+        std::lock_guard state_lock(state_mutex_);
+        if (!can_lock_shared())
+        {
+            return false;
+        }
+        readers_++;
+        return true;
+    }
+
+    void unlock_shared()
+    {
+        std::unique_lock state_lock(state_mutex_);
+        readers_--;
+        release(state_lock);
+    }
+
+    // co_await mutex.async_lock(executor) owns the exclusive lock afterwards
+    template <coroutine_executor TExecutor>
+    [[nodiscard]] lock_awaiter<TExecutor> async_lock(TExecutor executor)
+    {
+        return lock_awaiter<TExecutor>(*this, true, std::move(executor));
+    }
+
+    template <coroutine_executor TExecutor>
+    [[nodiscard]] lock_awaiter<TExecutor> async_lock_shared(TExecutor executor)
+    {
+        return lock_awaiter<TExecutor>(*this, false, std::move(executor));
+    }
+
+  private:
+    // The state mutex is held by the callers
+
+    [[nodiscard]] bool can_lock() const noexcept
+    {
+        return !writer_ && readers_ == 0 && waiting_ == nullptr;
+    }
+
+    // A blocked writer keeps the new readers out, so the writers do not starve
+    [[nodiscard]] bool can_lock_shared() const noexcept
+    {
+        return !writer_ && blocked_writers_ == 0 && waiting_ == nullptr;
+    }
+
+    void take(bool exclusive) noexcept
+    {
+        if (exclusive)
+        {
+            writer_ = true;
+        }
+        else
+        {
+            readers_++;
+        }
+    }
+
+    template <typename TPredicate>
+    void wait(std::unique_lock<std::mutex> &state_lock, TPredicate predicate)
+    {
+        blocked_++;
+        released_.wait(state_lock, std::move(predicate));
+        blocked_--;
+    }
+
+    bool enqueue(detail::async_lock_waiter &waiter)
+    {
+        std::lock_guard state_lock(state_mutex_);
+        if (waiter.exclusive ? can_lock() : can_lock_shared())
+        {
+            take(waiter.exclusive);
+            return false;
+        }
+
+        waiter.next = nullptr;
+        *(waiting_ == nullptr ? &waiting_ : &last_waiting_->next) = &waiter;
+        last_waiting_ = &waiter;
+        return true;
+    }
+
+    // Hands the released lock over to the queued coroutines, and wakes the blocked threads when nobody is queued
+    void release(std::unique_lock<std::mutex> &state_lock)
+    {
+        detail::async_lock_waiter *granted = nullptr;
+        detail::async_lock_waiter **last_granted = &granted;
+        while (waiting_ != nullptr)
+        {
+            auto &waiter = *waiting_;
+            if (waiter.exclusive ? (writer_ || readers_ != 0) : writer_)
+            {
+                break;
+            }
+            take(waiter.exclusive);
+
+            waiting_ = waiter.next;
+            waiter.next = nullptr;
+            *last_granted = &waiter;
+            last_granted = &waiter.next;
+            if (waiter.exclusive)
+            {
+                break;
+            }
+        }
+
+        const bool notify = waiting_ == nullptr && blocked_ != 0;
+        state_lock.unlock();
+
+        if (notify)
+        {
+            released_.notify_all();
+        }
+
+        // A resumed coroutine may destroy its awaiter right away
+        while (granted != nullptr)
+        {
+            auto &waiter = *std::exchange(granted, granted->next);
+            waiter.schedule(waiter);
+        }
+    }
+
+    std::mutex state_mutex_;
+    std::condition_variable released_;
+    bool writer_ = false;
+    std::size_t readers_ = 0;
+    // Threads blocked in lock() or lock_shared(), and the writers among them
+    std::size_t blocked_ = 0;
+    std::size_t blocked_writers_ = 0;
+    // The queue of the coroutines
+    detail::async_lock_waiter *waiting_ = nullptr;
+    detail::async_lock_waiter *last_waiting_ = nullptr;
+};
+
+// Shared lock for the immutable guards, plus co_await-able guards (see synchronized::async_commence_mut())
+using async_mutex_policy = shared_lock_policy<async_shared_mutex>;
+
+}  // namespace saam
@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/abi.hpp>
+#include <saam/detail/default_borrow_manager.hpp>
+
+#include <type_traits>
+
+#if SAAM_BORROW_STATISTICS
+#include <saam/detail/statistics_borrow_manager.hpp>
+#endif
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// Selects the borrow manager of the vars and refs of a type, when it is not given explicitly.
+// By default it is the manager of the borrow checking mode, but it can be specialized per type, e.g.
+// to switch off the checking for a hot type, or to track a suspect type in a counted build:
+//
+//   template <>
+//   struct saam::borrow_manager_for<hot_type> { using type = saam::unchecked_borrow_manager; };
+//
+// The specialization must be visible before the first use of var<T> or ref<T>, in every translation unit.
+// The const and non-const type shares the same manager, so a ref<const T> can be borrowed from a var<T>.
+template <typename T>
+struct borrow_manager_for
+{
+#if SAAM_BORROW_STATISTICS
+    using type = statistics_borrow_manager<default_borrow_manager_t>;
+#else
+    using type = default_borrow_manager_t;
+#endif
+};
+
+template <typename T>
+using borrow_manager_for_t = typename borrow_manager_for<std::remove_cv_t<T>>::type;
+
+}  // namespace saam
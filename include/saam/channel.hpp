@@ -0,0 +1,116 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/safe_ref.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <typeinfo>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// The user may define this function to handle the destruction of a channel, while some of its messages are still received.
+// After returning from this function, the process will be aborted.
+using channel_destroyed_panic_t = std::function<void(const std::type_info &message_type, std::size_t num_received_messages)>;
+inline channel_destroyed_panic_t channel_destroyed_panic;
+
+// Bounded lock-free multi-producer multi-consumer queue of vars: the messages are constructed in the slots of a ring allocated once,
+// and the producers and consumers synchronize only on the sequence numbers of the slots (no lock, no allocation per message).
+// A consumer either takes the message out of its slot (try_pop), or receives the slot itself (try_receive), and borrows the message in place.
+// The slot of a received message is recycled when the received message is released, with the usual dangling reference check:
+// a ref that outlives its received message panics. A received message occupies its slot meanwhile, so the producers may find the ring full.
+template <underlying_type T, borrow_manager TBorrowManager = borrow_manager_for_t<T>>
+class channel
+{
+    struct slot;
+
+  public:
+    using var_t = var<T, TBorrowManager>;
+
+    // A message owned by a consumer, it lives in its slot until it is released
+    class received_message
+    {
+      public:
+        received_message(const received_message &other) = delete;
+        received_message(received_message &&other) noexcept;
+        received_message &operator=(const received_message &other) = delete;
+        received_message &operator=(received_message &&other) noexcept;
+
+        // Releases the message
+        ~received_message();
+
+        [[nodiscard]] ref<T, TBorrowManager> borrow() const noexcept;
+        [[nodiscard]] ref<T, TBorrowManager> operator->() const noexcept;
+
+        // Destroys the message (with the usual dangling reference check), and hands its slot back to the producers
+        void release() noexcept;
+
+      private:
+        friend class channel;
+
+        received_message(channel &owner, slot &received_slot, std::size_t position) noexcept;
+
+        channel *channel_ = nullptr;
+        slot *slot_ = nullptr;
+        std::size_t position_ = 0;
+    };
+
+    // The capacity is rounded up to a power of two, it is at least 2
+    explicit channel(std::size_t capacity);
+
+    // The slots are referred to by address from the received messages
+    channel(const channel &other) = delete;
+    channel(channel &&other) noexcept = delete;
+    channel &operator=(const channel &other) = delete;
+    channel &operator=(channel &&other) noexcept = delete;
+
+    // Destroys the pending messages, and panics if a message is still received
+    ~channel();
+
+    // In-place construction of a message, returns false if the channel is full
+    template <typename... Args>
+    [[nodiscard]] bool try_emplace(Args &&...args);
+    [[nodiscard]] bool try_push(const T &message);
+    [[nodiscard]] bool try_push(T &&message);
+
+    // Moves the oldest message out of the channel, empty if there is no message
+    [[nodiscard]] std::optional<T> try_pop();
+
+    // Receives the oldest message in its slot, without moving it
+    [[nodiscard]] std::optional<received_message> try_receive();
+
+    [[nodiscard]] std::size_t capacity() const noexcept;
+
+  private:
+    struct slot
+    {
+        // The position of the producer, which may fill the slot next, plus 1 when the slot is filled
+        std::atomic<std::size_t> sequence = 0;
+        alignas(var_t) std::byte storage[sizeof(var_t)];
+
+        var_t &get() noexcept;
+    };
+
+    // Returns the slot and its position, or nullptr if the channel is full
+    [[nodiscard]] slot *claim_for_producer(std::size_t &position) noexcept;
+    // Returns the slot and its position, or nullptr if the channel is empty
+    [[nodiscard]] slot *claim_for_consumer(std::size_t &position) noexcept;
+    void release_to_producers(slot &released_slot, std::size_t position) noexcept;
+
+    std::size_t mask_;
+    std::unique_ptr<slot[]> slots_;
+    // The producers and the consumers do not falsely share their positions
+    alignas(64) std::atomic<std::size_t> enqueue_position_ = 0;
+    alignas(64) std::atomic<std::size_t> dequeue_position_ = 0;
+};
+
+}  // namespace saam
+
+#include <saam/detail/channel.ipp>
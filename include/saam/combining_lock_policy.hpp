@@ -0,0 +1,197 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/lock_policy.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// Maximal number of the batches a combiner executes, before it releases the lock
+#ifndef SAAM_COMBINING_PASSES
+#define SAAM_COMBINING_PASSES 4
+#endif
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+namespace detail
+{
+
+// Operation published by a thread waiting in synchronized::apply(), it lives on the stack of the waiting thread
+struct combining_request
+{
+    void (*execute)(combining_request &request, void *instance) noexcept = nullptr;
+    combining_request *next = nullptr;
+    std::atomic<bool> done = false;
+};
+
+template <typename T, typename TFunction>
+struct typed_combining_request : combining_request
+{
+    using result_t = std::invoke_result_t<TFunction &, T &>;
+    using storage_t = std::conditional_t<std::is_void_v<result_t>, std::nullptr_t, std::optional<result_t>>;
+
+    explicit typed_combining_request(TFunction &function) noexcept :
+        function(function)
+    {
+        this->execute = [](combining_request &request, void *instance) noexcept {
+            auto &self = static_cast<typed_combining_request &>(request);
+            try
+            {
+                if constexpr (std::is_void_v<result_t>)
+                {
+                    std::invoke(self.function, *static_cast<T *>(instance));
+                }
+                else
+                {
+                    self.result.emplace(std::invoke(self.function, *static_cast<T *>(instance)));
+                }
+            }
+            catch (...)
+            {
+                self.error = std::current_exception();
+            }
+        };
+    }
+
+    result_t take_result()
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        if constexpr (!std::is_void_v<result_t>)
+        {
+            return std::move(*result);
+        }
+    }
+
+    TFunction &function;
+    storage_t result{};
+    std::exception_ptr error;
+};
+
+// Publication list of the flat combining: the waiting threads push their requests,
+// and the thread holding the lock executes the pending requests in batches
+class alignas(64) combining_queue
+{
+  public:
+    // The TTryCommence returns an std::optional of a mutable guard
+    template <typename TFunction, typename TTryCommence>
+    auto apply(TFunction &function, TTryCommence try_commence)
+    {
+        using instance_t = std::remove_reference_t<decltype(**try_commence())>;
+        typed_combining_request<instance_t, TFunction> request(function);
+
+        // Without contention, the operation is executed right away
+        if (auto combiner = try_commence())
+        {
+            request.execute(request, &**combiner);
+            combine(&**combiner);
+            return request.take_result();
+        }
+
+        publish(request);
+
+        while (!request.done.load(std::memory_order_acquire))
+        {
+            if (auto combiner = try_commence())
+            {
+                combine(&**combiner);
+                // The own request was pending, so it is executed by now
+                break;
+            }
+            std::this_thread::yield();
+        }
+        return request.take_result();
+    }
+
+  private:
+    void publish(combining_request &request) noexcept
+    {
+        request.next = pending_.load(std::memory_order_relaxed);
+        while (!pending_.compare_exchange_weak(request.next, &request, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // The lock is held
+    void combine(void *instance) noexcept
+    {
+        for (std::size_t pass = 0; pass < SAAM_COMBINING_PASSES; pass++)
+        {
+            combining_request *requests = pending_.exchange(nullptr, std::memory_order_acquire);
+            if (requests == nullptr)
+            {
+                return;
+            }
+
+            // The requests are pushed onto a stack, they are executed in the order of their publication
+            combining_request *in_order = nullptr;
+            while (requests != nullptr)
+            {
+                combining_request *next = requests->next;
+                requests->next = in_order;
+                in_order = requests;
+                requests = next;
+            }
+
+            while (in_order != nullptr)
+            {
+                // The request may be destroyed by its thread right after it is done
+                combining_request *next = in_order->next;
+                in_order->execute(*in_order, instance);
+                in_order->done.store(true, std::memory_order_release);
+                in_order = next;
+            }
+        }
+    }
+
+    std::atomic<combining_request *> pending_ = nullptr;
+};
+
+}  // namespace detail
+
+// The mutex of the wrapped policy, extended with the publication list of synchronized::apply()
+template <typename TMutex>
+class combining_mutex : public TMutex
+{
+  public:
+    using wrapped_mutex_t = TMutex;
+
+    [[nodiscard]] detail::combining_queue &combining_queue() const noexcept
+    {
+        return combining_queue_;
+    }
+
+  private:
+    mutable detail::combining_queue combining_queue_;
+};
+
+// Lock policy with flat combining for synchronized::apply(): a thread that finds the lock held publishes its operation,
+// and the thread holding the lock executes the published operations in batches, so the lock (and the protected instance)
+// does not move between the cores for each operation. The guards work the same way as with the wrapped policy.
+template <lock_policy TLockPolicy>
+struct combining_lock_policy
+{
+    using wrapped_lock_policy_t = TLockPolicy;
+    using mutex_t = combining_mutex<typename TLockPolicy::mutex_t>;
+    using unique_lock_t = std::unique_lock<mutex_t>;
+    using shared_lock_t = std::conditional_t<TLockPolicy::is_shared, std::shared_lock<mutex_t>, std::unique_lock<mutex_t>>;
+
+    static constexpr bool is_shared = TLockPolicy::is_shared;
+};
+
+}  // namespace saam
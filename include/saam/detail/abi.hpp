@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/borrow_checking_mode.hpp>
+
+// Collects borrow statistics for all the types, by wrapping the borrow manager of the mode (see borrow_manager_for.hpp)
+#ifndef SAAM_BORROW_STATISTICS
+#define SAAM_BORROW_STATISTICS 0
+#endif
+
+// Profile the contention of the synchronized instances with the default lock policy (see lock_policy.hpp)
+#ifndef SAAM_LOCK_PROFILING
+#define SAAM_LOCK_PROFILING 0
+#endif
+
+// Verifies the owner thread of the vars with a local_counted_borrow_manager on each borrow, the vars store their owner thread for it
+// (see local_counted_borrow_manager.hpp)
+#ifndef SAAM_LOCAL_COUNTED_THREAD_CHECK
+#define SAAM_LOCAL_COUNTED_THREAD_CHECK 0
+#endif
+
+// The macros above change the layouts of the types per translation unit, e.g. a synchronized<T> contains a var<T> of the mode.
+// They are encoded into the name of an inline namespace around the whole library, so the translation units compiled with different
+// settings do not share the instantiations of the same templates, and a saam type passed between them fails at link time
+// (undefined reference), instead of silently violating the ODR. The MSVC linker also verifies the settings via detect_mismatch.
+// The other sizes of the layouts (slots, stripes, buffers) are fixed constants, they are not configurable per translation unit.
+#if SAAM_BORROW_CHECKING_MODE == 0
+#define SAAM_ABI_MODE_TAG counted
+#elif SAAM_BORROW_CHECKING_MODE == 1
+#define SAAM_ABI_MODE_TAG tracked
+#elif SAAM_BORROW_CHECKING_MODE == 2
+#define SAAM_ABI_MODE_TAG unchecked
+#elif SAAM_BORROW_CHECKING_MODE == 3
+#define SAAM_ABI_MODE_TAG sampled
+#else
+#error "SAAM_BORROW_CHECKING_MODE must be 0 (counted), 1 (tracked), 2 (unchecked) or 3 (sampled)"
+#endif
+
+#if SAAM_BORROW_STATISTICS
+#define SAAM_ABI_STATISTICS_TAG s1
+#else
+#define SAAM_ABI_STATISTICS_TAG s0
+#endif
+
+#if SAAM_LOCK_PROFILING
+#define SAAM_ABI_PROFILING_TAG p1
+#else
+#define SAAM_ABI_PROFILING_TAG p0
+#endif
+
+#if SAAM_LOCAL_COUNTED_THREAD_CHECK
+#define SAAM_ABI_THREAD_CHECK_TAG t1
+#else
+#define SAAM_ABI_THREAD_CHECK_TAG t0
+#endif
+
+#define SAAM_ABI_CONCAT_IMPL(mode, statistics, profiling, thread_check) abi_##mode##_##statistics##_##profiling##_##thread_check
+#define SAAM_ABI_CONCAT(mode, statistics, profiling, thread_check) SAAM_ABI_CONCAT_IMPL(mode, statistics, profiling, thread_check)
+#define SAAM_ABI_STRINGIFY_IMPL(name) #name
+#define SAAM_ABI_STRINGIFY(name) SAAM_ABI_STRINGIFY_IMPL(name)
+
+// The name of the inline namespace, e.g. abi_counted_s0_p0_t0
+#define SAAM_ABI_NAMESPACE SAAM_ABI_CONCAT(SAAM_ABI_MODE_TAG, SAAM_ABI_STATISTICS_TAG, SAAM_ABI_PROFILING_TAG, SAAM_ABI_THREAD_CHECK_TAG)
+
+#ifdef _MSC_VER
+#pragma detect_mismatch("saam_abi", SAAM_ABI_STRINGIFY(SAAM_ABI_NAMESPACE))
+#endif
@@ -4,11 +4,14 @@
 
 #pragma once
 
+#include <saam/detail/abi.hpp>
+
 #include <concepts>
+#include <cstddef>
 #include <type_traits>
 #include <typeinfo>
 
-namespace saam
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
 template <typename TBorrowManager>
@@ -19,6 +22,10 @@ concept borrow_manager = requires(TBorrowManager instance, typename TBorrowManag
     { ref_base.is_managed() } -> std::convertible_to<bool>;
 };
 
+// Wraps a borrow manager to collect borrow statistics, the wrapped borrow managers befriend it
+template <borrow_manager TBorrowManager>
+class statistics_borrow_manager;
+
 template <typename T>
 concept forward_declared = !requires { sizeof(T); };
 
@@ -41,4 +48,22 @@ concept has_noexcept_verify_dangling_references = requires(TBorrowManager instan
     { instance.verify_dangling_references(typeid(int), nullptr) } noexcept;
 };
 
+// The borrow manager is told the type and the address of its var, when the var is constructed
+template <typename TBorrowManager, typename T>
+concept has_bind_var_type = requires(TBorrowManager instance, const void *var_instance) { instance.template bind_var_type<T>(var_instance); };
+
+// The borrow manager can tell the number of the live references of its var
+template <typename TBorrowManager>
+concept has_num_borrows = requires(const TBorrowManager instance) {
+    { instance.num_borrows() } noexcept -> std::convertible_to<std::size_t>;
+};
+
+// The state of the borrow manager does not depend on its address while its var is not borrowed, so the var can be relocated bitwise
+template <typename TBorrowManager>
+concept relocatable_when_unborrowed = requires { requires TBorrowManager::is_relocatable_when_unborrowed; };
+
+// The borrow manager can list the creation sites of the live references of its var
+template <typename TBorrowManager>
+concept has_borrow_census = requires(const TBorrowManager instance) { instance.borrow_census(); };
+
 }  // namespace saam
@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/striped_mutex.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+
+namespace saam::inline SAAM_ABI_NAMESPACE::detail
+{
+
+// Each stripe is on its own cache line, so the stripes do not falsely share
+struct alignas(64) change_notifier_stripe
+{
+    std::atomic<std::size_t> num_waiters = 0;
+    std::condition_variable_any changed;
+};
+
+// Waiting for the modification of synchronized instances.
+// The synchronized instances do not own condition variables, they share a global table of them, selected by the address of the mutex.
+// Each stripe counts its waiters, so the modification does not notify anybody, when nobody waits on the stripe.
+// A waiter may be woken by the modification of another synchronized on the same stripe, so the predicate is always rechecked.
+class change_notifier
+{
+  public:
+    // Number of condition variables in the global table of the synchronized waiters
+    static constexpr std::size_t num_stripes = 64;
+
+    // The lock must own the mutex, the waiter is counted while holding it, so no modification can be missed
+    template <typename TLock, typename TPredicate>
+    static void wait(TLock &lock, TPredicate predicate)
+    {
+        auto &waiters = stripe_of(lock.mutex());
+        const registration counted_waiter(waiters);
+        waiters.changed.wait(lock, std::move(predicate));
+    }
+
+    // Returns the result of the predicate, false if it timed out
+    template <typename TLock, typename TClock, typename TDuration, typename TPredicate>
+    static bool wait_until(TLock &lock, const std::chrono::time_point<TClock, TDuration> &deadline, TPredicate predicate)
+    {
+        auto &waiters = stripe_of(lock.mutex());
+        const registration counted_waiter(waiters);
+        return waiters.changed.wait_until(lock, deadline, std::move(predicate));
+    }
+
+    // Wakes the waiters of the stripe, it is called after the modification, when the mutex is already released
+    static void notify_changed(const void *mutex) noexcept
+    {
+        auto &waiters = stripe_of(mutex);
+        // The waiter was counted under the mutex, the modification was done after it under the same mutex, so the count is visible
+        if (waiters.num_waiters.load(std::memory_order_relaxed) != 0)
+        {
+            waiters.changed.notify_all();
+        }
+    }
+
+  private:
+    using stripe = change_notifier_stripe;
+
+    class registration
+    {
+      public:
+        explicit registration(stripe &waiters) noexcept :
+            waiters_(waiters)
+        {
+            waiters_.num_waiters.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        registration(const registration &) = delete;
+        registration &operator=(const registration &) = delete;
+
+        ~registration()
+        {
+            waiters_.num_waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+      private:
+        stripe &waiters_;
+    };
+
+    static stripe &stripe_of(const void *mutex) noexcept
+    {
+        return stripes_[stripe_index_of<num_stripes>(mutex)];
+    }
+
+    static inline std::array<stripe, num_stripes> stripes_;
+};
+
+}  // namespace saam::detail
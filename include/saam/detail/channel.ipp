@@ -0,0 +1,271 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/channel.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+template <underlying_type T, borrow_manager TBorrowManager>
+channel<T, TBorrowManager>::received_message::received_message(channel &owner, slot &received_slot, std::size_t position) noexcept :
+    channel_(&owner),
+    slot_(&received_slot),
+    position_(position)
+{
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+channel<T, TBorrowManager>::received_message::received_message(received_message &&other) noexcept :
+    channel_(std::exchange(other.channel_, nullptr)),
+    slot_(other.slot_),
+    position_(other.position_)
+{
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+typename channel<T, TBorrowManager>::received_message &channel<T, TBorrowManager>::received_message::operator=(
+    received_message &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        channel_ = std::exchange(other.channel_, nullptr);
+        slot_ = other.slot_;
+        position_ = other.position_;
+    }
+    return *this;
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+channel<T, TBorrowManager>::received_message::~received_message()
+{
+    release();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+ref<T, TBorrowManager> channel<T, TBorrowManager>::received_message::borrow() const noexcept
+{
+    assert(channel_ != nullptr && "The message is already released");
+    return slot_->get().borrow();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+ref<T, TBorrowManager> channel<T, TBorrowManager>::received_message::operator->() const noexcept
+{
+    return borrow();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void channel<T, TBorrowManager>::received_message::release() noexcept
+{
+    if (channel_ == nullptr)
+    {
+        return;
+    }
+
+    // The destruction of the var panics, if a ref to the message is still alive
+    std::destroy_at(&slot_->get());
+    std::exchange(channel_, nullptr)->release_to_producers(*slot_, position_);
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+channel<T, TBorrowManager>::channel(std::size_t capacity) :
+    mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1),
+    slots_(new slot[mask_ + 1])
+{
+    for (std::size_t position = 0; position <= mask_; position++)
+    {
+        slots_[position].sequence.store(position, std::memory_order_relaxed);
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+channel<T, TBorrowManager>::~channel()
+{
+    const auto dequeue_position = dequeue_position_.load(std::memory_order_acquire);
+    std::size_t num_received_messages = 0;
+    for (std::size_t index = 0; index <= mask_; index++)
+    {
+        auto &current_slot = slots_[index];
+        const auto sequence = current_slot.sequence.load(std::memory_order_acquire);
+        // A free slot waits for a producer position of its index, a filled one holds the next position
+        const bool occupied = (sequence & mask_) == ((index + 1) & mask_);
+        if (!occupied)
+        {
+            continue;
+        }
+
+        // The consumers are already past the positions of the received messages
+        if (sequence - 1 < dequeue_position)
+        {
+            num_received_messages++;
+        }
+        else
+        {
+            std::destroy_at(&current_slot.get());
+        }
+    }
+
+    if (num_received_messages != 0)
+    {
+        if (channel_destroyed_panic)
+        {
+            channel_destroyed_panic(typeid(T), num_received_messages);
+        }
+        abort();
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+template <typename... Args>
+bool channel<T, TBorrowManager>::try_emplace(Args &&...args)
+{
+    if constexpr (std::is_nothrow_constructible_v<T, Args...>)
+    {
+        std::size_t position = 0;
+        slot *free_slot = claim_for_producer(position);
+        if (free_slot == nullptr)
+        {
+            return false;
+        }
+
+        ::new (static_cast<void *>(free_slot->storage)) var_t(std::in_place, std::forward<Args>(args)...);
+        free_slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+    else
+    {
+        // A claimed slot must be filled, so a throwing construction is done before the claim
+        return try_emplace(T(std::forward<Args>(args)...));
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+bool channel<T, TBorrowManager>::try_push(const T &message)
+{
+    return try_emplace(message);
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+bool channel<T, TBorrowManager>::try_push(T &&message)
+{
+    return try_emplace(std::move(message));
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+std::optional<T> channel<T, TBorrowManager>::try_pop()
+{
+    std::size_t position = 0;
+    slot *filled_slot = claim_for_consumer(position);
+    if (filled_slot == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    // The message is moved out via a ref, like a var is moved
+    std::optional<T> message(std::move(*filled_slot->get().borrow()));
+    std::destroy_at(&filled_slot->get());
+    release_to_producers(*filled_slot, position);
+    return message;
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+std::optional<typename channel<T, TBorrowManager>::received_message> channel<T, TBorrowManager>::try_receive()
+{
+    std::size_t position = 0;
+    slot *filled_slot = claim_for_consumer(position);
+    if (filled_slot == nullptr)
+    {
+        return std::nullopt;
+    }
+    return received_message(*this, *filled_slot, position);
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+std::size_t channel<T, TBorrowManager>::capacity() const noexcept
+{
+    return mask_ + 1;
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+typename channel<T, TBorrowManager>::var_t &channel<T, TBorrowManager>::slot::get() noexcept
+{
+    return *std::launder(reinterpret_cast<var_t *>(storage));
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+typename channel<T, TBorrowManager>::slot *channel<T, TBorrowManager>::claim_for_producer(std::size_t &position) noexcept
+{
+    position = enqueue_position_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        auto &candidate = slots_[position & mask_];
+        const auto sequence = candidate.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+        if (difference == 0)
+        {
+            // On failure the position is reloaded
+            if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                return &candidate;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The slot still holds the message of the previous round
+            return nullptr;
+        }
+        else
+        {
+            position = enqueue_position_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+typename channel<T, TBorrowManager>::slot *channel<T, TBorrowManager>::claim_for_consumer(std::size_t &position) noexcept
+{
+    position = dequeue_position_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        auto &candidate = slots_[position & mask_];
+        const auto sequence = candidate.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+        if (difference == 0)
+        {
+            if (dequeue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                return &candidate;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The slot is not filled yet
+            return nullptr;
+        }
+        else
+        {
+            position = dequeue_position_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void channel<T, TBorrowManager>::release_to_producers(slot &released_slot, std::size_t position) noexcept
+{
+    // The producer of the next round may fill the slot
+    released_slot.sequence.store(position + mask_ + 1, std::memory_order_release);
+}
+
+}  // namespace saam
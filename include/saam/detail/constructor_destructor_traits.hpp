@@ -10,7 +10,7 @@
 #include <type_traits>
 #include <utility>
 
-namespace saam
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
 template <underlying_type T, borrow_manager TBorrowManager>
@@ -5,26 +5,130 @@
 #pragma once
 
 #include <saam/detail/borrow_manager_traits.hpp>
+#include <saam/detail/striped_mutex.hpp>
 
+#include <array>
 #include <atomic>
 #include <cassert>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <limits>
+#include <mutex>
+#include <type_traits>
 #include <typeinfo>
 
-namespace saam
+// Default bound of the wait of a draining var for its references, before it panics
+#ifndef SAAM_DRAIN_TIMEOUT_MS
+#define SAAM_DRAIN_TIMEOUT_MS 1000
+#endif
+
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
 // The user must define this function to handle the dangling reference situation.
 // After this function, dangling reference(s) exist in the process, so the memory is possibly going to be corrupted soon.
 // Therefore, after returning from this function, the process will be aborted.
-using dangling_reference_panic_t =
+using counted_dangling_reference_panic_t =
     std::function<void(const std::type_info &var_type, void *var_instance, std::size_t num_dangling_references)>;
-inline dangling_reference_panic_t dangling_reference_panic;
+inline counted_dangling_reference_panic_t counted_dangling_reference_panic;
+
+// The user may define this function to handle a new borrow of a var with a draining borrow manager, while the var already waits for its
+// outstanding references at its destruction. After returning from this function, the process will be aborted.
+using draining_borrow_panic_t = std::function<void(std::size_t num_outstanding_references)>;
+inline draining_borrow_panic_t draining_borrow_panic;
+
+namespace detail
+{
 
-class counted_borrow_manager
+// Liveness of an observed var: it is shared by the var and its weak_refs, so it outlives the var
+struct counted_weak_anchor
+{
+    std::mutex mutex;
+    bool alive = true;
+    std::atomic<std::size_t> owners = 1;
+
+    void acquire() noexcept
+    {
+        owners.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() noexcept
+    {
+        if (owners.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+};
+
+// Placeholder of the anchor, when the var cannot be observed
+struct no_weak_anchor
+{
+};
+
+// Each stripe is on its own cache line, so the stripes do not falsely share
+struct alignas(64) drain_stripe
+{
+    std::mutex mutex;
+    std::condition_variable drained;
+};
+
+// The draining vars wait for their last reference on a global table of condition variables, selected by the address of the manager.
+// The last reference notifies only if the var is already waiting for it.
+class drain_notifier
 {
   public:
+    // Number of condition variables in the global table of the draining vars
+    static constexpr std::size_t num_stripes = 16;
+
+    // Returns the result of the predicate, false if it timed out
+    template <typename TPredicate>
+    static bool wait_for(const void *borrow_manager, std::chrono::milliseconds timeout, TPredicate predicate)
+    {
+        auto &waiters = stripe_of(borrow_manager);
+        std::unique_lock lock(waiters.mutex);
+        return waiters.drained.wait_for(lock, timeout, std::move(predicate));
+    }
+
+    static void notify_drained(const void *borrow_manager) noexcept
+    {
+        auto &waiters = stripe_of(borrow_manager);
+        // The waiter checks the counter under the mutex, so the notification cannot slip in between its check and its wait
+        {
+            const std::lock_guard lock(waiters.mutex);
+        }
+        waiters.drained.notify_all();
+    }
+
+  private:
+    static drain_stripe &stripe_of(const void *borrow_manager) noexcept
+    {
+        return stripes_[stripe_index_of<num_stripes>(borrow_manager)];
+    }
+
+    static inline std::array<drain_stripe, num_stripes> stripes_;
+};
+
+}  // namespace detail
+
+// The layout of the counter is chosen by the parameters: its type (density) and its alignment (contention resistance).
+// An observable manager can be observed by weak_refs, its anchor is allocated when the first weak_ref is created.
+// A draining manager (non-zero drain timeout) waits at the destruction of its var for the outstanding references to be released,
+// and panics only if they are not released within the timeout. Meanwhile the var is closed, a new borrow of it panics.
+template <std::unsigned_integral TCounter, std::size_t TAlignment = alignof(std::atomic<TCounter>), bool TObservable = false,
+          std::size_t TDrainTimeoutMs = 0>
+class basic_counted_borrow_manager
+{
+  public:
+    // While not borrowed, only the counter is set, so the var can be relocated bitwise (see relocate.hpp).
+    // The anchor of an observable manager refers to the var's address.
+    static constexpr bool is_relocatable_when_unborrowed = !TObservable;
+
     // For the manager to be able to manage the reference, the reference must derived from this base class.
     // This manager specific base class adds everything to a reference that is needed for its management.
     class ref_base
@@ -36,7 +140,7 @@ class counted_borrow_manager
             return borrow_manager_ != nullptr;
         }
 
-        [[nodiscard]] counted_borrow_manager *borrow_manager() const noexcept
+        [[nodiscard]] basic_counted_borrow_manager *borrow_manager() const noexcept
         {
             return borrow_manager_;
         }
@@ -44,7 +148,7 @@ class counted_borrow_manager
       protected:
         ref_base() = default;
 
-        ref_base(counted_borrow_manager *borrow_manager) :
+        ref_base(basic_counted_borrow_manager *borrow_manager) :
             borrow_manager_(borrow_manager)
         {
             register_self();
@@ -131,43 +235,163 @@ class counted_borrow_manager
         }
 
       private:
-        counted_borrow_manager *borrow_manager_ = nullptr;
+        basic_counted_borrow_manager *borrow_manager_ = nullptr;
     };
 
     // reference counters are not copied/moved, each var counts its own references
-    counted_borrow_manager(const counted_borrow_manager &other) = delete;
-    counted_borrow_manager(counted_borrow_manager &&other) noexcept = delete;
-    counted_borrow_manager &operator=(const counted_borrow_manager &other) = delete;
-    counted_borrow_manager &operator=(counted_borrow_manager &&other) noexcept = delete;
-    ~counted_borrow_manager() = default;
+    basic_counted_borrow_manager(const basic_counted_borrow_manager &other) = delete;
+    basic_counted_borrow_manager(basic_counted_borrow_manager &&other) noexcept = delete;
+    basic_counted_borrow_manager &operator=(const basic_counted_borrow_manager &other) = delete;
+    basic_counted_borrow_manager &operator=(basic_counted_borrow_manager &&other) noexcept = delete;
+
+    ~basic_counted_borrow_manager()
+    {
+        if constexpr (TObservable)
+        {
+            if (auto *anchor = weak_anchor_.load(std::memory_order_acquire); anchor != nullptr)
+            {
+                anchor->release();
+            }
+        }
+    }
+
+    // Exact at the moment of the call, so it is meaningful only when no new references can be created meanwhile
+    [[nodiscard]] bool is_borrowed() const noexcept
+    {
+        return counter_.load(std::memory_order_acquire) != 0;
+    }
+
+    // Number of the live references, a snapshot for diagnostics (e.g. to find the refs that pin a var)
+    [[nodiscard]] std::size_t num_borrows() const noexcept
+    {
+        auto num_references = counter_.load(std::memory_order_relaxed);
+        if constexpr (is_draining)
+        {
+            num_references &= static_cast<TCounter>(~draining_flag);
+        }
+        return static_cast<std::size_t>(num_references);
+    }
 
     void verify_dangling_references(const std::type_info &var_type, void *var_instance) const noexcept
     {
-        std::size_t prev_value = 0;
-        const bool destroyed_with_active_references =
-            !counter_.compare_exchange_strong(prev_value, std::numeric_limits<std::size_t>::max());
-        if (destroyed_with_active_references)
+        if constexpr (TObservable)
         {
-            const auto num_dangling_references = counter_.load();
-            if (dangling_reference_panic)
+            // The weak_refs upgrade under the lock of the anchor, so the upgrades before this are counted, and the later ones fail
+            if (auto *anchor = weak_anchor_.load(std::memory_order_acquire); anchor != nullptr)
             {
-                dangling_reference_panic(var_type, var_instance, num_dangling_references);
+                const std::lock_guard lock(anchor->mutex);
+                anchor->alive = false;
             }
-            abort();
         }
+        TCounter unborrowed_value = 0;
+        if constexpr (is_draining)
+        {
+            unborrowed_value = drain();
+        }
+        close_or_panic(unborrowed_value, var_type, var_instance);
+    }
+
+    // The anchor of the weak_refs, the caller shares its ownership
+    [[nodiscard]] detail::counted_weak_anchor *acquire_weak_anchor() const
+        requires TObservable
+    {
+        auto *anchor = weak_anchor_.load(std::memory_order_acquire);
+        if (anchor == nullptr)
+        {
+            // The var owns the first share of the anchor
+            auto *created = new detail::counted_weak_anchor();
+            if (weak_anchor_.compare_exchange_strong(anchor, created, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                anchor = created;
+            }
+            else
+            {
+                delete created;
+            }
+        }
+        anchor->acquire();
+        return anchor;
     }
 
   private:
-    counted_borrow_manager() = default;
+    static constexpr bool is_draining = TDrainTimeoutMs != 0;
+    // Set in the counter while the var waits for its references
+    static constexpr TCounter draining_flag = TCounter(1) << (std::numeric_limits<TCounter>::digits - 1);
+
+    basic_counted_borrow_manager() = default;
+
+    // Waits for the outstanding references (e.g. the in-flight operator-> borrows of other threads), at most for the timeout.
+    // Returns the value of the unborrowed counter: the draining flag stays set until the closing, so a borrow meanwhile still panics.
+    TCounter drain() const noexcept
+    {
+        if (counter_.load(std::memory_order_acquire) == 0)
+        {
+            return 0;
+        }
+
+        counter_.fetch_or(draining_flag, std::memory_order_acq_rel);
+        detail::drain_notifier::wait_for(this, std::chrono::milliseconds(TDrainTimeoutMs), [this]() {
+            return (counter_.load(std::memory_order_acquire) & ~draining_flag) == 0;
+        });
+        return draining_flag;
+    }
+
+    void close_or_panic(TCounter unborrowed_value, const std::type_info &var_type, void *var_instance) const noexcept
+    {
+        TCounter prev_value = unborrowed_value;
+        const bool destroyed_with_active_references = !counter_.compare_exchange_strong(prev_value, std::numeric_limits<TCounter>::max());
+        if (destroyed_with_active_references)
+        {
+            auto num_dangling_references = prev_value;
+            if constexpr (is_draining)
+            {
+                num_dangling_references &= static_cast<TCounter>(~draining_flag);
+            }
+            if (counted_dangling_reference_panic)
+            {
+                counted_dangling_reference_panic(var_type, var_instance, num_dangling_references);
+            }
+            abort();
+        }
+    }
 
     void register_reference() const
     {
-        counter_++;
+        [[maybe_unused]] const auto prev_value = counter_++;
+        if constexpr (is_draining)
+        {
+            // The destruction of a draining var closes it for new borrows (also for the copies of the outstanding references),
+            // otherwise a thread borrowing it repeatedly would never let the drain finish
+            if ((prev_value & draining_flag) != 0)
+            {
+                if (draining_borrow_panic)
+                {
+                    draining_borrow_panic(static_cast<std::size_t>(prev_value & static_cast<TCounter>(~draining_flag)));
+                }
+                abort();
+            }
+        }
+        if constexpr (sizeof(TCounter) < sizeof(std::size_t))
+        {
+            // A narrow counter must not wrap around (or reach the closed value), the references would not be counted anymore
+            if (prev_value >= std::numeric_limits<TCounter>::max() - 1)
+            {
+                abort();
+            }
+        }
     }
 
     void unregister_reference() const
     {
-        const auto prev_value = counter_--;
+        [[maybe_unused]] const auto prev_value = counter_--;
+        if constexpr (is_draining)
+        {
+            // The last reference of a draining var wakes it
+            if (prev_value == (draining_flag | 1))
+            {
+                detail::drain_notifier::notify_drained(this);
+            }
+        }
         // Reference count cannot go below zero, so the previous value must be greater than zero
         assert(prev_value > 0);
     }
@@ -175,10 +399,42 @@ class counted_borrow_manager
     template <underlying_type TOther, borrow_manager TOtherBorrowManager>
     friend class var;
 
+    template <underlying_type TOther, borrow_manager TOtherBorrowManager>
+    friend class var_vector;
+
+    template <borrow_manager TOtherBorrowManager>
+    friend class statistics_borrow_manager;
+
     // maxint the counter was closed, no more borrows are allowed
     // 0 counter means that the instance is not borrowed
     // counter > 0 means that the instance is borrowed
-    mutable std::atomic<std::size_t> counter_ = 0;
+    alignas(TAlignment) mutable std::atomic<TCounter> counter_ = 0;
+    // if the manager is not observable, this member is optimized away
+#ifdef _MSC_VER
+    [[msvc::no_unique_address]]
+#else
+    [[no_unique_address]]
+#endif
+    mutable std::conditional_t<TObservable, std::atomic<detail::counted_weak_anchor *>, detail::no_weak_anchor> weak_anchor_{};
 };
 
+// Default layout: a pointer sized counter
+using counted_borrow_manager = basic_counted_borrow_manager<std::size_t>;
+
+// Dense layout: the counter packs with small types, e.g. a var<std::uint32_t> takes 8 bytes instead of 16.
+// A var can have at most 2^32 - 2 references at the same time, exceeding it aborts the process.
+using compact_counted_borrow_manager = basic_counted_borrow_manager<std::uint32_t>;
+
+// Contention resistant layout: the counter has its own cache line, so the vars next to each other (e.g. in an array),
+// which are borrowed from different threads, do not invalidate each other's cache lines.
+using padded_counted_borrow_manager = basic_counted_borrow_manager<std::size_t, 64>;
+
+// Observable layout: the var can be observed by weak_refs, without being borrowed by them
+using weak_counted_borrow_manager = basic_counted_borrow_manager<std::size_t, alignof(std::atomic<std::size_t>), true>;
+
+// Draining layout: the destruction of the var waits for the outstanding references (SAAM_DRAIN_TIMEOUT_MS at most), instead of panicking
+// right away, e.g. when a worker borrows a var shared across the threads in the middle of its destruction at shutdown.
+using draining_counted_borrow_manager =
+    basic_counted_borrow_manager<std::size_t, alignof(std::atomic<std::size_t>), false, SAAM_DRAIN_TIMEOUT_MS>;
+
 }  // namespace saam
@@ -0,0 +1,249 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/borrow_manager_traits.hpp>
+#include <saam/detail/counted_borrow_manager.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <typeinfo>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// The user may define this function to handle a borrow of a var with a distributed counted borrow manager (also a copy of its reference),
+// after the destruction of the var closed the slot of the borrowing thread. After returning from this function, the process will be aborted.
+using distributed_closed_borrow_panic_t = std::function<void()>;
+inline distributed_closed_borrow_panic_t distributed_closed_borrow_panic;
+
+// Counted borrow manager for vars that are borrowed from many threads at the same time.
+// The reference counter is distributed over cache line sized slots, each thread counts its borrows in its own slot,
+// so the threads do not contend on a single counter. The cost is the size of the manager: one cache line per slot.
+// A reference may be released on another thread than it was created on, so a single slot can go negative,
+// only the sum of the slots is meaningful.
+// The destruction closes the slots one by one, a borrow on an already closed slot panics (distributed_closed_borrow_panic),
+// so a reference cannot be copied into a closed slot unnoticed, while its original is released in a slot that is not closed yet.
+// The dangling reference panic handler is the same as for the counted_borrow_manager.
+class distributed_counted_borrow_manager
+{
+  public:
+    // Number of counter slots, it must be a power of two
+    static constexpr std::size_t num_slots = 16;
+    // While not borrowed, the slots sum up to zero, so the var can be relocated bitwise (see relocate.hpp)
+    static constexpr bool is_relocatable_when_unborrowed = true;
+    static_assert(num_slots > 0 && (num_slots & (num_slots - 1)) == 0, "the number of counter slots must be a power of two");
+
+    // For the manager to be able to manage the reference, the reference must derived from this base class.
+    // This manager specific base class adds everything to a reference that is needed for its management.
+    class ref_base
+    {
+      public:
+        // If the underlying raw pointer is managed reference (refrence counted)
+        [[nodiscard]] bool is_managed() const noexcept
+        {
+            return borrow_manager_ != nullptr;
+        }
+
+        [[nodiscard]] distributed_counted_borrow_manager *borrow_manager() const noexcept
+        {
+            return borrow_manager_;
+        }
+
+      protected:
+        ref_base() = default;
+
+        ref_base(distributed_counted_borrow_manager *borrow_manager) :
+            borrow_manager_(borrow_manager)
+        {
+            register_self();
+        }
+
+        ref_base(const ref_base &other) :
+            borrow_manager_(other.borrow_manager_)
+        {
+            register_self();
+        }
+
+        ref_base(ref_base &&other) noexcept :
+            borrow_manager_(other.borrow_manager_)
+        {
+            // "this" gets always the same reference counter as "other", so the count that "other" loses, gains "this"
+            // -> no modification on the counter needed
+            other.borrow_manager_ = nullptr;
+        }
+
+        ref_base &operator=(const ref_base &other)
+        {
+            if (this == &other)
+            {
+                return *this;
+            }
+
+            const bool change_in_borrow_manager = borrow_manager_ != other.borrow_manager_;
+            if (change_in_borrow_manager)
+            {
+                unregister_self();
+
+                borrow_manager_ = other.borrow_manager_;
+                register_self();
+            }
+
+            return *this;
+        }
+
+        ref_base &operator=(ref_base &&other) noexcept
+        {
+            if (this == &other)
+            {
+                return *this;
+            }
+
+            const bool change_in_borrow_manager = borrow_manager_ != other.borrow_manager_;
+            if (change_in_borrow_manager)
+            {
+                unregister_self();
+
+                borrow_manager_ = other.borrow_manager_;
+                register_self();
+            }
+
+            other.unregister_self();
+
+            return *this;
+        }
+
+        ~ref_base()
+        {
+            unregister_self();
+        }
+
+        void register_self() noexcept
+        {
+            if (!is_managed())
+            {
+                return;
+            }
+
+            borrow_manager_->register_reference();
+        }
+
+        void unregister_self() noexcept
+        {
+            if (!is_managed())
+            {
+                return;
+            }
+
+            borrow_manager_->unregister_reference();
+            borrow_manager_ = nullptr;
+        }
+
+      private:
+        distributed_counted_borrow_manager *borrow_manager_ = nullptr;
+    };
+
+    // reference counters are not copied/moved, each var counts its own references
+    distributed_counted_borrow_manager(const distributed_counted_borrow_manager &other) = delete;
+    distributed_counted_borrow_manager(distributed_counted_borrow_manager &&other) noexcept = delete;
+    distributed_counted_borrow_manager &operator=(const distributed_counted_borrow_manager &other) = delete;
+    distributed_counted_borrow_manager &operator=(distributed_counted_borrow_manager &&other) noexcept = delete;
+    ~distributed_counted_borrow_manager() = default;
+
+    // Number of the live references, a snapshot for diagnostics: the slots are summed up one by one
+    [[nodiscard]] std::size_t num_borrows() const noexcept
+    {
+        std::ptrdiff_t num_references = 0;
+        for (const auto &slot : slots_)
+        {
+            num_references += slot.counter.load(std::memory_order_relaxed);
+        }
+        // A reference may be counted in one slot and released in another one, meanwhile the sum can be transiently negative
+        return num_references > 0 ? static_cast<std::size_t>(num_references) : 0;
+    }
+
+    void verify_dangling_references(const std::type_info &var_type, void *var_instance) const noexcept
+    {
+        // Close all the slots, and sum up the references they counted until the closing
+        std::ptrdiff_t num_references = 0;
+        for (auto &slot : slots_)
+        {
+            num_references += slot.counter.exchange(closed_slot);
+        }
+
+        const bool destroyed_with_active_references = num_references != 0;
+        if (destroyed_with_active_references)
+        {
+            const auto num_dangling_references = static_cast<std::size_t>(num_references);
+            if (counted_dangling_reference_panic)
+            {
+                counted_dangling_reference_panic(var_type, var_instance, num_dangling_references);
+            }
+            abort();
+        }
+    }
+
+  private:
+    distributed_counted_borrow_manager() = default;
+
+    // Each thread gets a slot assigned in a round-robin manner, when it borrows first time
+    static std::size_t current_slot_index() noexcept
+    {
+        thread_local const std::size_t slot_index = next_slot_index_.fetch_add(1, std::memory_order_relaxed) & (num_slots - 1);
+        return slot_index;
+    }
+
+    void register_reference() const
+    {
+        const auto prev_value = slots_[current_slot_index()].counter.fetch_add(1, std::memory_order_relaxed);
+        // No borrowing is allowed after the slots were closed, in any build
+        if (is_closed(prev_value))
+        {
+            if (distributed_closed_borrow_panic)
+            {
+                distributed_closed_borrow_panic();
+            }
+            abort();
+        }
+    }
+
+    // The counter of a closed slot stays near to closed_slot, even when the references are released in it
+    static constexpr bool is_closed(std::ptrdiff_t counter) noexcept
+    {
+        return counter <= closed_slot / 2;
+    }
+
+    void unregister_reference() const
+    {
+        // Release ordering, so the accesses via the reference happen before the closing of the slots
+        slots_[current_slot_index()].counter.fetch_sub(1, std::memory_order_release);
+    }
+
+    template <underlying_type TOther, borrow_manager TOtherBorrowManager>
+    friend class var;
+
+    template <borrow_manager TOtherBorrowManager>
+    friend class statistics_borrow_manager;
+
+    // Each counter is on its own cache line, so the threads do not falsely share
+    struct alignas(64) slot
+    {
+        std::atomic<std::ptrdiff_t> counter = 0;
+    };
+
+    // half of the min value: the slot was closed, no more borrows are allowed.
+    // It is far from both the ends of the range, so the references released in the closed slot cannot wrap it around.
+    static constexpr std::ptrdiff_t closed_slot = std::numeric_limits<std::ptrdiff_t>::min() / 2;
+
+    static inline std::atomic<std::size_t> next_slot_index_ = 0;
+
+    mutable std::array<slot, num_slots> slots_;
+};
+
+}  // namespace saam
@@ -8,283 +8,433 @@
 #include <saam/safe_ref.hpp>
 
 #include <cassert>
+#include <utility>
 
-namespace saam
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
 //
 // Unique guard
 //
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
 template <typename TOther>
     requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-guard<T>::guard(guard<TOther> &&other) noexcept :
+guard<T, TLockPolicy>::guard(guard<TOther, TLockPolicy> &&other) noexcept :
+    token_(std::move(other.token_)),
     lock_(std::move(other.lock_)),
-    protected_instance_(std::move(other.protected_instance_))
+    protected_instance_(std::exchange(other.protected_instance_, nullptr)),
+    modified_(std::exchange(other.modified_, false))
 {
 }
 
-template <typename T>
-guard<T>::guard(guard<T> &&other) noexcept :
+template <typename T, lock_policy TLockPolicy>
+guard<T, TLockPolicy>::guard(guard<T, TLockPolicy> &&other) noexcept :
+    token_(std::move(other.token_)),
     lock_(std::move(other.lock_)),
-    protected_instance_(std::move(other.protected_instance_))
+    protected_instance_(std::exchange(other.protected_instance_, nullptr)),
+    modified_(std::exchange(other.modified_, false))
 {
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
 template <typename TOther>
     requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-guard<T>::guard(synchronized<TOther> &other) noexcept :
+guard<T, TLockPolicy>::guard(synchronized<TOther, TLockPolicy> &other) noexcept :
+    token_(other.guard_counter_),
     lock_(other.mutex_),
-    protected_instance_(other.protected_instance_)
+    protected_instance_(other.instance())
 {
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
 template <typename TOther>
     requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-guard<T> &guard<T>::operator=(guard<TOther> &&other) noexcept
+guard<T, TLockPolicy> &guard<T, TLockPolicy>::operator=(guard<TOther, TLockPolicy> &&other) noexcept
 {
     if (this == &other)
     {
         return *this;
     }
 
+    release_and_notify();
+    token_ = std::move(other.token_);
     lock_ = std::move(other.lock_);
-    protected_instance_ = std::move(other.protected_instance_);
+    protected_instance_ = std::exchange(other.protected_instance_, nullptr);
+    modified_ = std::exchange(other.modified_, false);
 
     return *this;
 }
 
-template <typename T>
-guard<T> &guard<T>::operator=(guard<T> &&other) noexcept
+template <typename T, lock_policy TLockPolicy>
+guard<T, TLockPolicy> &guard<T, TLockPolicy>::operator=(guard<T, TLockPolicy> &&other) noexcept
 {
     if (this == &other)
     {
         return *this;
     }
 
+    release_and_notify();
+    token_ = std::move(other.token_);
     lock_ = std::move(other.lock_);
-    protected_instance_ = std::move(other.protected_instance_);
+    protected_instance_ = std::exchange(other.protected_instance_, nullptr);
+    modified_ = std::exchange(other.modified_, false);
 
     return *this;
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
 template <typename TOther>
     requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-guard<T> &guard<T>::operator=(synchronized<TOther> &other) noexcept
+guard<T, TLockPolicy> &guard<T, TLockPolicy>::operator=(synchronized<TOther, TLockPolicy> &other) noexcept
 {
-    if (const bool self_assignment = protected_instance_ == other.protected_instance_.borrow(); self_assignment)
+    if (const bool self_assignment = protected_instance_ == other.instance(); self_assignment)
     {
         return *this;
     }
 
+    release_and_notify();
+    token_ = detail::guard_token<>(other.guard_counter_);
     lock_ = lock_t(other.mutex_);
-    protected_instance_ = other.protected_instance_;
+    protected_instance_ = other.instance();
 
     return *this;
 }
 
-template <typename T>
-T *guard<T>::operator->() const
+template <typename T, lock_policy TLockPolicy>
+T *guard<T, TLockPolicy>::operator->() const
 {
-    return protected_instance_.operator->();
+    modified_ = true;
+    assert(protected_instance_ != nullptr && "operator->() called on a moved-from guard");
+    return protected_instance_;
 }
 
-template <typename T>
-T &guard<T>::operator*() const
+template <typename T, lock_policy TLockPolicy>
+T &guard<T, TLockPolicy>::operator*() const
 {
+    modified_ = true;
+    assert(protected_instance_ != nullptr && "dereference of a moved-from guard");
     return *protected_instance_;
 }
 
-template <typename T>
-guard<T>::operator T &() const noexcept
+template <typename T, lock_policy TLockPolicy>
+guard<T, TLockPolicy>::operator T &() const noexcept
 {
+    modified_ = true;
+    assert(protected_instance_ != nullptr && "dereference of a moved-from guard");
     return *protected_instance_;
 }
 
-template <typename T>
-guard<T>::operator T *() const noexcept
+template <typename T, lock_policy TLockPolicy>
+guard<T, TLockPolicy>::operator T *() const noexcept
 {
-    return static_cast<T *>(protected_instance_);
+    modified_ = true;
+    return protected_instance_;
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
 template <typename TOther>
     requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-guard<T>::guard(ref<TOther> protected_instance, lock_t lock) noexcept :
+guard<T, TLockPolicy>::guard(TOther *protected_instance, lock_t lock, detail::guard_token<> token) noexcept :
+    token_(std::move(token)),
     lock_(std::move(lock)),
-    protected_instance_(std::move(protected_instance))
+    protected_instance_(protected_instance)
 {
     // The mutex is expected to be already locked
 }
 
+template <typename T, lock_policy TLockPolicy>
+guard<const T, TLockPolicy> guard<T, TLockPolicy>::downgrade() &&
+    requires upgradable_lock_policy<TLockPolicy>
+{
+    auto *mutex = lock_.release();
+    mutex->unlock_and_lock_shared();
+    guard<const T, TLockPolicy> downgraded(std::exchange(protected_instance_, nullptr),
+                                           typename TLockPolicy::shared_lock_t(*mutex, std::adopt_lock), std::move(token_));
+
+    // The released unique lock counts as a release for the waiters
+    if (std::exchange(modified_, false))
+    {
+        detail::change_notifier::notify_changed(mutex);
+    }
+    return downgraded;
+}
+
+template <typename T, lock_policy TLockPolicy>
+guard<T, TLockPolicy>::~guard()
+{
+    release_and_notify();
+}
+
+template <typename T, lock_policy TLockPolicy>
+void guard<T, TLockPolicy>::release_and_notify() noexcept
+{
+    const void *mutex = lock_.mutex();
+    if (lock_.owns_lock())
+    {
+        lock_.unlock();
+    }
+
+    // The waiters are notified after the unlock, so they do not wake up only to block on the mutex
+    if (std::exchange(modified_, false) && mutex != nullptr)
+    {
+        detail::change_notifier::notify_changed(mutex);
+    }
+}
+
 //
 // Shared guard
 //
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
 template <typename TOther>
-    requires std::is_convertible_v<TOther *, const T *>
-guard<const T>::guard(const guard<const TOther> &other) noexcept :
-    lock_(*other.lock_.mutex()),
+    requires(std::is_convertible_v<TOther *, const T *> && TLockPolicy::is_shared)
+guard<const T, TLockPolicy>::guard(const guard<const TOther, TLockPolicy> &other) noexcept :
+    token_(other.token_),
+    lock_(copy_lock(other.lock_)),
+    shared_lock_(other.shared_lock_),
     protected_instance_(other.protected_instance_)
 {
 }
 
-template <typename T>
-guard<const T>::guard(const guard<const T> &other) noexcept :
-    lock_(*other.lock_.mutex()),
+template <typename T, lock_policy TLockPolicy>
+guard<const T, TLockPolicy>::guard(const guard<const T, TLockPolicy> &other) noexcept
+    requires(TLockPolicy::is_shared)
+    :
+    token_(other.token_),
+    lock_(copy_lock(other.lock_)),
+    shared_lock_(other.shared_lock_),
     protected_instance_(other.protected_instance_)
 {
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
 template <typename TOther>
     requires std::is_convertible_v<TOther *, const T *>
-guard<const T>::guard(guard<const TOther> &&other) noexcept :
+guard<const T, TLockPolicy>::guard(guard<const TOther, TLockPolicy> &&other) noexcept :
+    token_(std::move(other.token_)),
     lock_(std::move(other.lock_)),
-    protected_instance_(std::move(other.protected_instance_))
+    shared_lock_(std::move(other.shared_lock_)),
+    protected_instance_(std::exchange(other.protected_instance_, nullptr))
 {
 }
 
-template <typename T>
-guard<const T>::guard(guard<const T> &&other) noexcept :
+template <typename T, lock_policy TLockPolicy>
+guard<const T, TLockPolicy>::guard(guard<const T, TLockPolicy> &&other) noexcept :
+    token_(std::move(other.token_)),
     lock_(std::move(other.lock_)),
-    protected_instance_(std::move(other.protected_instance_))
+    shared_lock_(std::move(other.shared_lock_)),
+    protected_instance_(std::exchange(other.protected_instance_, nullptr))
 {
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
 template <typename TOther>
     requires(std::is_convertible_v<TOther *, const T *> && !std::is_const_v<TOther>)
-guard<const T>::guard(const synchronized<TOther> &other) noexcept :
+guard<const T, TLockPolicy>::guard(const synchronized<TOther, TLockPolicy> &other) noexcept :
+    token_(other.guard_counter_),
     lock_(other.mutex_),
-    protected_instance_(other.protected_instance_)
+    protected_instance_(other.instance())
 {
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
 template <typename TOther>
-    requires std::is_convertible_v<TOther *, const T *>
-guard<const T> &guard<const T>::operator=(const guard<const TOther> &other)
+    requires(std::is_convertible_v<TOther *, const T *> && TLockPolicy::is_shared)
+guard<const T, TLockPolicy> &guard<const T, TLockPolicy>::operator=(const guard<const TOther, TLockPolicy> &other)
 {
     if (this == &other)
     {
         return *this;
     }
 
-    lock_ = lock_t(*other.lock_.mutex());
+    token_ = other.token_;
+    lock_ = copy_lock(other.lock_);
+    shared_lock_ = other.shared_lock_;
     protected_instance_ = other.protected_instance_;
 
     return *this;
 }
 
-template <typename T>
-guard<const T> &guard<const T>::operator=(const guard<const T> &other)
+template <typename T, lock_policy TLockPolicy>
+guard<const T, TLockPolicy> &guard<const T, TLockPolicy>::operator=(const guard<const T, TLockPolicy> &other)
+    requires(TLockPolicy::is_shared)
 {
     if (this == &other)
     {
         return *this;
     }
 
-    lock_ = lock_t(*other.lock_.mutex());
+    token_ = other.token_;
+    lock_ = copy_lock(other.lock_);
+    shared_lock_ = other.shared_lock_;
     protected_instance_ = other.protected_instance_;
 
     return *this;
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
 template <typename TOther>
     requires std::is_convertible_v<TOther *, const T *>
-guard<const T> &guard<const T>::operator=(guard<const TOther> &&other) noexcept
+guard<const T, TLockPolicy> &guard<const T, TLockPolicy>::operator=(guard<const TOther, TLockPolicy> &&other) noexcept
 {
     if (this == &other)
     {
         return *this;
     }
 
+    token_ = std::move(other.token_);
     lock_ = std::move(other.lock_);
-    protected_instance_ = std::move(other.protected_instance_);
+    shared_lock_ = std::move(other.shared_lock_);
+    protected_instance_ = std::exchange(other.protected_instance_, nullptr);
 
     return *this;
 }
 
-template <typename T>
-guard<const T> &guard<const T>::operator=(guard<const T> &&other) noexcept
+template <typename T, lock_policy TLockPolicy>
+guard<const T, TLockPolicy> &guard<const T, TLockPolicy>::operator=(guard<const T, TLockPolicy> &&other) noexcept
 {
     if (this == &other)
     {
         return *this;
     }
 
+    token_ = std::move(other.token_);
     lock_ = std::move(other.lock_);
-    protected_instance_ = std::move(other.protected_instance_);
+    shared_lock_ = std::move(other.shared_lock_);
+    protected_instance_ = std::exchange(other.protected_instance_, nullptr);
 
     return *this;
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
 template <typename TOther>
     requires std::is_convertible_v<TOther *, const T *>
-guard<const T> &guard<const T>::operator=(const synchronized<TOther> &other) noexcept
+guard<const T, TLockPolicy> &guard<const T, TLockPolicy>::operator=(const synchronized<TOther, TLockPolicy> &other) noexcept
 {
-    if (const bool self_assignment = protected_instance_ == other.protected_instance_.borrow(); self_assignment)
+    if (const bool self_assignment = protected_instance_ == other.instance(); self_assignment)
     {
         return *this;
     }
 
+    token_ = detail::guard_token<>(other.guard_counter_);
     lock_ = lock_t(other.mutex_);
-    protected_instance_ = other.protected_instance_;
+    shared_lock_.reset();
+    protected_instance_ = other.instance();
 
     return *this;
 }
 
-template <typename T>
-bool guard<const T>::operator==(const guard &other) const noexcept
+template <typename T, lock_policy TLockPolicy>
+bool guard<const T, TLockPolicy>::operator==(const guard &other) const noexcept
 {
     return protected_instance_ == other.protected_instance_;
 }
 
-template <typename T>
-bool guard<const T>::operator!=(const guard &other) const noexcept
+template <typename T, lock_policy TLockPolicy>
+bool guard<const T, TLockPolicy>::operator!=(const guard &other) const noexcept
 {
     return !(*this == other);
 }
 
-template <typename T>
-const T *guard<const T>::operator->() const
+template <typename T, lock_policy TLockPolicy>
+const T *guard<const T, TLockPolicy>::operator->() const
 {
-    return protected_instance_.operator->();
+    assert(protected_instance_ != nullptr && "operator->() called on a moved-from guard");
+    return protected_instance_;
 }
 
-template <typename T>
-const T &guard<const T>::operator*() const
+template <typename T, lock_policy TLockPolicy>
+const T &guard<const T, TLockPolicy>::operator*() const
 {
+    assert(protected_instance_ != nullptr && "dereference of a moved-from guard");
     return *protected_instance_;
 }
 
-template <typename T>
-guard<const T>::operator const T &() const noexcept
+template <typename T, lock_policy TLockPolicy>
+guard<const T, TLockPolicy>::operator const T &() const noexcept
 {
+    assert(protected_instance_ != nullptr && "dereference of a moved-from guard");
     return *protected_instance_;
 }
 
-template <typename T>
-guard<const T>::operator const T *() const noexcept
+template <typename T, lock_policy TLockPolicy>
+guard<const T, TLockPolicy>::operator const T *() const noexcept
+{
+    return protected_instance_;
+}
+
+template <typename T, lock_policy TLockPolicy>
+template <typename TOther>
+    requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
+guard<const T, TLockPolicy>::guard(const TOther *protected_instance, lock_t lock, detail::guard_token<> token) noexcept :
+    token_(std::move(token)),
+    lock_(std::move(lock)),
+    protected_instance_(protected_instance)
 {
-    return static_cast<const T *>(protected_instance_);
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
 template <typename TOther>
     requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-guard<const T>::guard(ref<const TOther> protected_instance, lock_t lock) noexcept :
+guard<const T, TLockPolicy>::guard(const TOther *protected_instance, std::shared_ptr<lock_t> shared_lock,
+                                   detail::guard_token<> token) noexcept :
+    token_(std::move(token)),
+    shared_lock_(std::move(shared_lock)),
+    protected_instance_(protected_instance)
+{
+    // The shared lock is expected to be already locked
+}
+
+template <typename T, lock_policy TLockPolicy>
+typename guard<const T, TLockPolicy>::lock_t guard<const T, TLockPolicy>::copy_lock(const lock_t &other_lock)
+{
+    return other_lock.mutex() != nullptr ? lock_t(*other_lock.mutex()) : lock_t();
+}
+
+//
+// Upgrade guard
+//
+
+template <typename T, lock_policy TLockPolicy>
+upgrade_guard<T, TLockPolicy>::upgrade_guard(T *protected_instance, lock_t lock, detail::guard_token<> token) noexcept :
+    token_(std::move(token)),
     lock_(std::move(lock)),
-    protected_instance_(std::move(protected_instance))
+    protected_instance_(protected_instance)
+{
+    // The mutex is expected to be already locked
+}
+
+template <typename T, lock_policy TLockPolicy>
+const T *upgrade_guard<T, TLockPolicy>::operator->() const
+{
+    assert(protected_instance_ != nullptr && "operator->() called on a moved-from guard");
+    return protected_instance_;
+}
+
+template <typename T, lock_policy TLockPolicy>
+const T &upgrade_guard<T, TLockPolicy>::operator*() const
+{
+    assert(protected_instance_ != nullptr && "dereference of a moved-from guard");
+    return *protected_instance_;
+}
+
+template <typename T, lock_policy TLockPolicy>
+guard<T, TLockPolicy> upgrade_guard<T, TLockPolicy>::upgrade() &&
+{
+    auto *mutex = lock_.release();
+    mutex->unlock_upgrade_and_lock();
+    return guard<T, TLockPolicy>(std::exchange(protected_instance_, nullptr), typename TLockPolicy::unique_lock_t(*mutex, std::adopt_lock),
+                                 std::move(token_));
+}
+
+template <typename T, lock_policy TLockPolicy>
+guard<const T, TLockPolicy> upgrade_guard<T, TLockPolicy>::downgrade() &&
 {
+    auto *mutex = lock_.release();
+    mutex->unlock_upgrade_and_lock_shared();
+    return guard<const T, TLockPolicy>(std::exchange(protected_instance_, nullptr),
+                                       typename TLockPolicy::shared_lock_t(*mutex, std::adopt_lock), std::move(token_));
 }
 
 }  // namespace saam
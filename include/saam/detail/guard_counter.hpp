@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/abi.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace saam::inline SAAM_ABI_NAMESPACE::detail
+{
+
+// The guards of a synchronized are counted, so its destruction can verify that none of them outlives it.
+// The unchecked mode does not count them, like it does not count the refs.
+inline constexpr bool counts_guards = SAAM_BORROW_CHECKING_MODE != 2;
+
+template <bool TEnabled = counts_guards>
+class guard_token;
+
+// Number of the live guards of a synchronized, each guard holds a token of it
+template <bool TEnabled = counts_guards>
+class guard_counter
+{
+  public:
+    [[nodiscard]] std::size_t num_guards() const noexcept
+    {
+        return num_guards_.load(std::memory_order_acquire);
+    }
+
+  private:
+    friend class guard_token<TEnabled>;
+
+    mutable std::atomic<std::size_t> num_guards_ = 0;
+};
+
+template <>
+class guard_counter<false>
+{
+  public:
+    [[nodiscard]] static constexpr std::size_t num_guards() noexcept
+    {
+        return 0;
+    }
+};
+
+// Share of a guard in the counter of its synchronized, it follows the guard through its copies and moves
+template <bool TEnabled>
+class guard_token
+{
+  public:
+    guard_token() = default;
+
+    explicit guard_token(const guard_counter<TEnabled> &counter) noexcept :
+        counter_(&counter)
+    {
+        acquire();
+    }
+
+    guard_token(const guard_token &other) noexcept :
+        counter_(other.counter_)
+    {
+        acquire();
+    }
+
+    guard_token(guard_token &&other) noexcept :
+        counter_(std::exchange(other.counter_, nullptr))
+    {
+    }
+
+    guard_token &operator=(const guard_token &other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            counter_ = other.counter_;
+            acquire();
+        }
+        return *this;
+    }
+
+    guard_token &operator=(guard_token &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            counter_ = std::exchange(other.counter_, nullptr);
+        }
+        return *this;
+    }
+
+    ~guard_token()
+    {
+        release();
+    }
+
+  private:
+    void acquire() noexcept
+    {
+        if (counter_ != nullptr)
+        {
+            counter_->num_guards_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void release() noexcept
+    {
+        if (counter_ != nullptr)
+        {
+            // Release ordering, so the accesses via the guard happen before the check of the synchronized
+            counter_->num_guards_.fetch_sub(1, std::memory_order_release);
+            counter_ = nullptr;
+        }
+    }
+
+    const guard_counter<TEnabled> *counter_ = nullptr;
+};
+
+template <>
+class guard_token<false>
+{
+  public:
+    guard_token() = default;
+
+    explicit guard_token(const guard_counter<false> & /*counter*/) noexcept
+    {
+    }
+};
+
+}  // namespace saam::detail
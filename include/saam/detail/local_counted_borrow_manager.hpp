@@ -0,0 +1,212 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/abi.hpp>
+#include <saam/detail/borrow_manager_traits.hpp>
+#include <saam/detail/counted_borrow_manager.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <thread>
+#include <typeinfo>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// Counted borrow manager for vars that never leave the thread that created them.
+// The counter is a plain integer, so borrowing costs no atomic operations.
+// Borrowing the var or copying and releasing its references on another thread is a data race on the counter.
+// With SAAM_LOCAL_COUNTED_THREAD_CHECK enabled, touching a reference on another thread asserts.
+// The panic handler is the same as for the counted_borrow_manager.
+class local_counted_borrow_manager
+{
+  public:
+    // While not borrowed, only the counter is set, so the var can be relocated bitwise (see relocate.hpp)
+    static constexpr bool is_relocatable_when_unborrowed = true;
+
+    // For the manager to be able to manage the reference, the reference must derived from this base class.
+    // This manager specific base class adds everything to a reference that is needed for its management.
+    class ref_base
+    {
+      public:
+        // If the underlying raw pointer is managed reference (refrence counted)
+        [[nodiscard]] bool is_managed() const noexcept
+        {
+            return borrow_manager_ != nullptr;
+        }
+
+        [[nodiscard]] local_counted_borrow_manager *borrow_manager() const noexcept
+        {
+            return borrow_manager_;
+        }
+
+      protected:
+        ref_base() = default;
+
+        ref_base(local_counted_borrow_manager *borrow_manager) :
+            borrow_manager_(borrow_manager)
+        {
+            register_self();
+        }
+
+        ref_base(const ref_base &other) :
+            borrow_manager_(other.borrow_manager_)
+        {
+            register_self();
+        }
+
+        ref_base(ref_base &&other) noexcept :
+            borrow_manager_(other.borrow_manager_)
+        {
+            // "this" gets always the same reference counter as "other", so the count that "other" loses, gains "this"
+            // -> no modification on the counter needed
+            other.borrow_manager_ = nullptr;
+        }
+
+        ref_base &operator=(const ref_base &other)
+        {
+            if (this == &other)
+            {
+                return *this;
+            }
+
+            const bool change_in_borrow_manager = borrow_manager_ != other.borrow_manager_;
+            if (change_in_borrow_manager)
+            {
+                unregister_self();
+
+                borrow_manager_ = other.borrow_manager_;
+                register_self();
+            }
+
+            return *this;
+        }
+
+        ref_base &operator=(ref_base &&other) noexcept
+        {
+            if (this == &other)
+            {
+                return *this;
+            }
+
+            const bool change_in_borrow_manager = borrow_manager_ != other.borrow_manager_;
+            if (change_in_borrow_manager)
+            {
+                unregister_self();
+
+                borrow_manager_ = other.borrow_manager_;
+                register_self();
+            }
+
+            other.unregister_self();
+
+            return *this;
+        }
+
+        ~ref_base()
+        {
+            unregister_self();
+        }
+
+        void register_self() noexcept
+        {
+            if (!is_managed())
+            {
+                return;
+            }
+
+            borrow_manager_->register_reference();
+        }
+
+        void unregister_self() noexcept
+        {
+            if (!is_managed())
+            {
+                return;
+            }
+
+            borrow_manager_->unregister_reference();
+            borrow_manager_ = nullptr;
+        }
+
+      private:
+        local_counted_borrow_manager *borrow_manager_ = nullptr;
+    };
+
+    // reference counters are not copied/moved, each var counts its own references
+    local_counted_borrow_manager(const local_counted_borrow_manager &other) = delete;
+    local_counted_borrow_manager(local_counted_borrow_manager &&other) noexcept = delete;
+    local_counted_borrow_manager &operator=(const local_counted_borrow_manager &other) = delete;
+    local_counted_borrow_manager &operator=(local_counted_borrow_manager &&other) noexcept = delete;
+    ~local_counted_borrow_manager() = default;
+
+    // Number of the live references, it can be queried only on the owner thread
+    [[nodiscard]] std::size_t num_borrows() const noexcept
+    {
+        verify_owner_thread();
+        return counter_;
+    }
+
+    // The var may be destroyed on any thread, once its references are released
+    void verify_dangling_references(const std::type_info &var_type, void *var_instance) const noexcept
+    {
+        const bool destroyed_with_active_references = counter_ != 0;
+        if (destroyed_with_active_references)
+        {
+            const auto num_dangling_references = counter_;
+            if (counted_dangling_reference_panic)
+            {
+                counted_dangling_reference_panic(var_type, var_instance, num_dangling_references);
+            }
+            abort();
+        }
+
+        counter_ = std::numeric_limits<std::size_t>::max();
+    }
+
+  private:
+    local_counted_borrow_manager() = default;
+
+    void register_reference() const
+    {
+        verify_owner_thread();
+        counter_++;
+    }
+
+    void unregister_reference() const
+    {
+        verify_owner_thread();
+        // Reference count cannot go below zero, so the previous value must be greater than zero
+        assert(counter_ > 0);
+        counter_--;
+    }
+
+    void verify_owner_thread() const noexcept
+    {
+#if SAAM_LOCAL_COUNTED_THREAD_CHECK
+        assert(owner_thread_ == std::this_thread::get_id() && "thread local var is borrowed on another thread");
+#endif
+    }
+
+    template <underlying_type TOther, borrow_manager TOtherBorrowManager>
+    friend class var;
+
+    template <borrow_manager TOtherBorrowManager>
+    friend class statistics_borrow_manager;
+
+    // maxint the counter was closed, no more borrows are allowed
+    // 0 counter means that the instance is not borrowed
+    // counter > 0 means that the instance is borrowed
+    mutable std::size_t counter_ = 0;
+
+#if SAAM_LOCAL_COUNTED_THREAD_CHECK
+    // The thread that created the var
+    std::thread::id owner_thread_ = std::this_thread::get_id();
+#endif
+};
+
+}  // namespace saam
@@ -0,0 +1,23 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/abi.hpp>
+
+#include <concepts>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// Kept apart from the policies, so var.hpp can forward declare synchronized without including them (see lock_policy.hpp)
+template <typename TLockPolicy>
+concept lock_policy = requires {
+    typename TLockPolicy::mutex_t;
+    typename TLockPolicy::unique_lock_t;
+    typename TLockPolicy::shared_lock_t;
+    { TLockPolicy::is_shared } -> std::convertible_to<bool>;
+};
+
+}  // namespace saam
@@ -0,0 +1,149 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/abi.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+#include <span>
+
+#if defined(_WIN32)
+extern "C" __declspec(dllimport) unsigned short __stdcall RtlCaptureStackBackTrace(unsigned long frames_to_skip,
+                                                                                   unsigned long frames_to_capture,
+                                                                                   void **back_trace,
+                                                                                   unsigned long *back_trace_hash);
+#elif __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define SAAM_HAS_EXECINFO 1
+#endif
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// Stacktrace that captures only the raw return addresses into an inline buffer.
+// The capture does not allocate and does not resolve symbols, so it is cheap enough to be done for every borrow.
+// The symbols are resolved only when the stacktrace is printed - typically from the dangling reference panic handler.
+class raw_stacktrace
+{
+  public:
+    // Maximum number of return addresses stored in a raw stacktrace
+    static constexpr std::size_t max_depth = 16;
+
+    raw_stacktrace() noexcept = default;
+
+    // Captures the return addresses of the calling thread, the frame of this function is not included.
+    [[nodiscard]] static raw_stacktrace current(std::size_t skip = 0) noexcept
+    {
+        raw_stacktrace stacktrace;
+#if defined(_WIN32)
+        stacktrace.size_ = RtlCaptureStackBackTrace(static_cast<unsigned long>(skip + 1),
+                                                    static_cast<unsigned long>(max_depth),
+                                                    stacktrace.frames_.data(),
+                                                    nullptr);
+#elif defined(SAAM_HAS_EXECINFO)
+        // backtrace() cannot skip frames, so capture the skipped frames too and drop them afterwards
+        std::array<void *, max_depth + 8> frames{};
+        const auto captured = static_cast<std::size_t>(::backtrace(frames.data(), static_cast<int>(frames.size())));
+        const auto first_frame = std::min(captured, skip + 1);
+        stacktrace.size_ = std::min(captured - first_frame, max_depth);
+        std::copy_n(frames.begin() + static_cast<std::ptrdiff_t>(first_frame), stacktrace.size_, stacktrace.frames_.begin());
+#else
+        (void)skip;
+#endif
+        return stacktrace;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return size_ == 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    [[nodiscard]] std::span<void *const> frames() const noexcept
+    {
+        return {frames_.data(), size_};
+    }
+
+    void clear() noexcept
+    {
+        size_ = 0;
+    }
+
+    // FNV-1a over the captured addresses, the unused part of the buffer is not hashed
+    [[nodiscard]] std::size_t hash() const noexcept
+    {
+        std::uint64_t hash = 0xCBF29CE484222325ULL;
+        for (void *frame : frames())
+        {
+            hash = (hash ^ static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(frame))) * 0x100000001B3ULL;
+        }
+        return static_cast<std::size_t>(hash);
+    }
+
+    friend bool operator==(const raw_stacktrace &lhs, const raw_stacktrace &rhs) noexcept
+    {
+        return std::ranges::equal(lhs.frames(), rhs.frames());
+    }
+
+    // Resolves the symbols of the captured addresses as far as the platform supports it,
+    // otherwise only the raw addresses are printed (they can be resolved offline, e.g. with addr2line).
+    friend std::ostream &operator<<(std::ostream &stream, const raw_stacktrace &stacktrace)
+    {
+#if defined(SAAM_HAS_EXECINFO)
+        char **symbols = ::backtrace_symbols(stacktrace.frames_.data(), static_cast<int>(stacktrace.size_));
+#endif
+        for (std::size_t i = 0; i < stacktrace.size_; i++)
+        {
+            stream << i << "# ";
+#if defined(SAAM_HAS_EXECINFO)
+            if (symbols != nullptr)
+            {
+                stream << symbols[i] << '\n';
+                continue;
+            }
+#endif
+            stream << stacktrace.frames_[i] << '\n';
+        }
+#if defined(SAAM_HAS_EXECINFO)
+        // NOLINTNEXTLINE(cppcoreguidelines-no-malloc,hicpp-no-malloc,cppcoreguidelines-owning-memory)
+        std::free(symbols);
+#endif
+        return stream;
+    }
+
+  private:
+    std::array<void *, max_depth> frames_{};
+    std::size_t size_ = 0;
+};
+
+// Decides if the current stacktrace capture is sampled, when 1 in sampling_rate captures shall be done
+// (1: every capture is sampled, 0: none of them).
+// Counts down the captures per thread, so the sampling does not contend on a shared counter.
+inline bool is_sampled_capture(std::size_t sampling_rate) noexcept
+{
+    if (sampling_rate <= 1)
+    {
+        return sampling_rate == 1;
+    }
+
+    thread_local std::size_t captures_until_sample = 0;
+    if (captures_until_sample == 0 || captures_until_sample > sampling_rate)
+    {
+        captures_until_sample = sampling_rate;
+    }
+
+    return --captures_until_sample == 0;
+}
+
+}  // namespace saam
@@ -0,0 +1,206 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/rcu_synchronized.hpp>
+
+#include <thread>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+rcu_synchronized<T>::rcu_synchronized() :
+    current_(new version(std::in_place))
+{
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+template <typename... Args>
+rcu_synchronized<T>::rcu_synchronized(std::in_place_t, Args &&...args) :
+    current_(new version(std::in_place, std::forward<Args>(args)...))
+{
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+rcu_synchronized<T>::rcu_synchronized(const T &instance) :
+    current_(new version(std::in_place, instance))
+{
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+rcu_synchronized<T>::rcu_synchronized(T &&instance) :
+    current_(new version(std::in_place, std::move(instance)))
+{
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+rcu_synchronized<T>::~rcu_synchronized()
+{
+    // The destruction of a still borrowed version panics in its var
+    delete current_.load();
+    while (retired_ != nullptr)
+    {
+        delete std::exchange(retired_, retired_->next_retired);
+    }
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+typename rcu_synchronized<T>::reader_ref_t rcu_synchronized<T>::read() const
+{
+    // The reader section protects only the borrowing, the borrow keeps the version alive afterwards
+    auto &reader_slot = reader_slots_[grace_period_.load() & 1][current_reader_slot_index()];
+    reader_slot.counter.fetch_add(1);
+    reader_ref_t pinned_version = current_.load()->instance;
+    reader_slot.counter.fetch_sub(1, std::memory_order_release);
+
+    return pinned_version;
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+rcu_writer<T> rcu_synchronized<T>::commence_mut()
+{
+    return rcu_writer<T>(*this, std::unique_lock(writer_mutex_));
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+rcu_synchronized<T> &rcu_synchronized<T>::operator=(const T &instance)
+{
+    auto new_version = std::make_unique<version>(std::in_place, instance);
+    std::lock_guard lock(writer_mutex_);
+    publish(std::move(new_version));
+    return *this;
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+rcu_synchronized<T> &rcu_synchronized<T>::operator=(T &&instance)
+{
+    auto new_version = std::make_unique<version>(std::in_place, std::move(instance));
+    std::lock_guard lock(writer_mutex_);
+    publish(std::move(new_version));
+    return *this;
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+std::size_t rcu_synchronized<T>::reclaim()
+{
+    std::lock_guard lock(writer_mutex_);
+    return reclaim_locked();
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+std::size_t rcu_synchronized<T>::current_reader_slot_index() noexcept
+{
+    // Each thread gets a slot assigned in a round-robin manner, when it reads first time
+    thread_local const std::size_t slot_index = next_reader_slot_index_.fetch_add(1, std::memory_order_relaxed) & (num_reader_slots - 1);
+    return slot_index;
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+void rcu_synchronized<T>::publish(std::unique_ptr<version> new_version) noexcept
+{
+    version *replaced_version = current_.exchange(new_version.release());
+    replaced_version->next_retired = retired_;
+    retired_ = replaced_version;
+
+    wait_for_readers();
+    reclaim_locked();
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+void rcu_synchronized<T>::wait_for_readers() noexcept
+{
+    // The parity is flipped twice, like in synchronize_rcu of userspace RCU: a reader may load the parity before a flip,
+    // but count itself only after the wait for that parity, so a single flip could miss it while it borrows the replaced version.
+    // After both waits, every reader, which has counted itself before the replacing, is done with the borrowing.
+    for (int phase = 0; phase < 2; phase++)
+    {
+        const auto previous_parity = grace_period_.fetch_add(1) & 1;
+        for (const auto &reader_slot : reader_slots_[previous_parity])
+        {
+            while (reader_slot.counter.load() != 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+std::size_t rcu_synchronized<T>::reclaim_locked() noexcept
+{
+    // After the grace period, the retired versions can be only released, they cannot be borrowed again
+    std::size_t num_borrowed = 0;
+    for (version **link = &retired_; *link != nullptr;)
+    {
+        version *retired_version = *link;
+        if (retired_version->instance.borrow_manager_.is_borrowed())
+        {
+            num_borrowed++;
+            link = &retired_version->next_retired;
+            continue;
+        }
+
+        *link = retired_version->next_retired;
+        delete retired_version;
+    }
+    return num_borrowed;
+}
+
+//
+// Writer
+//
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+rcu_writer<T>::rcu_writer(rcu_synchronized<T> &owner, std::unique_lock<std::mutex> lock) :
+    lock_(std::move(lock)),
+    owner_(&owner),
+    // Only the writers access the current version with a mutable reference, and the lock of the writers is held
+    draft_(std::make_unique<version_t>(std::in_place, *owner.current_.load()->instance.borrow())),
+    draft_ref_(draft_->instance)
+{
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+rcu_writer<T>::~rcu_writer()
+{
+    // A moved-from writer has nothing to publish
+    if (draft_ != nullptr)
+    {
+        owner_->publish(std::move(draft_));
+    }
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+T *rcu_writer<T>::operator->() const
+{
+    return draft_ref_.operator->();
+}
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+T &rcu_writer<T>::operator*() const
+{
+    return *draft_ref_;
+}
+
+}  // namespace saam
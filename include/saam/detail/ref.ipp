@@ -10,7 +10,7 @@
 #include <cassert>
 #include <type_traits>
 
-namespace saam
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
 template <underlying_type T, borrow_manager TBorrowManager>
@@ -36,9 +36,10 @@ ref<T, TBorrowManager>::ref(const ref<TOther, TBorrowManager> &other) :
 }
 
 template <underlying_type T, borrow_manager TBorrowManager>
-ref<T, TBorrowManager>::ref(const ref &other) :
-    TBorrowManager::ref_base(other),
-    instance_(other.instance_)
+ref<T, TBorrowManager>::ref(const ref &other)
+    requires(!is_trivially_copyable)
+    : TBorrowManager::ref_base(other),
+      instance_(other.instance_)
 {
 }
 
@@ -49,13 +50,18 @@ ref<T, TBorrowManager>::ref(ref<TOther, TBorrowManager> &&other) noexcept :
     TBorrowManager::ref_base(std::move(other)),
     instance_(other.instance_)
 {
-    other.instance_ = nullptr;
+    // Like the defaulted move of the same type, the move of a trivially copyable ref is a copy
+    if constexpr (!is_trivially_copyable)
+    {
+        other.instance_ = nullptr;
+    }
 }
 
 template <underlying_type T, borrow_manager TBorrowManager>
-ref<T, TBorrowManager>::ref(ref &&other) noexcept :
-    TBorrowManager::ref_base(std::move(other)),
-    instance_(other.instance_)
+ref<T, TBorrowManager>::ref(ref &&other) noexcept
+    requires(!is_trivially_copyable)
+    : TBorrowManager::ref_base(std::move(other)),
+      instance_(other.instance_)
 {
     other.instance_ = nullptr;
 }
@@ -82,6 +88,7 @@ ref<T, TBorrowManager> &ref<T, TBorrowManager>::operator=(const ref<TOther, TBor
 
 template <underlying_type T, borrow_manager TBorrowManager>
 ref<T, TBorrowManager> &ref<T, TBorrowManager>::operator=(const ref &other)
+    requires(!is_trivially_copyable)
 {
     if (this == &other)
     {
@@ -101,7 +108,10 @@ template <underlying_type TOther>
 ref<T, TBorrowManager> &ref<T, TBorrowManager>::operator=(ref<TOther, TBorrowManager> &&other) noexcept
 {
     instance_ = other.instance_;
-    other.instance_ = nullptr;
+    if constexpr (!is_trivially_copyable)
+    {
+        other.instance_ = nullptr;
+    }
 
     TBorrowManager::ref_base::operator=(std::move(other));
 
@@ -110,6 +120,7 @@ ref<T, TBorrowManager> &ref<T, TBorrowManager>::operator=(ref<TOther, TBorrowMan
 
 template <underlying_type T, borrow_manager TBorrowManager>
 ref<T, TBorrowManager> &ref<T, TBorrowManager>::operator=(ref &&other) noexcept
+    requires(!is_trivially_copyable)
 {
     if (this == &other)
     {
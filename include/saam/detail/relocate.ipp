@@ -0,0 +1,111 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/relocate.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <typeinfo>
+#include <utility>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+namespace detail
+{
+
+struct var_relocation
+{
+    // Panics, if the var is borrowed
+    template <underlying_type T, borrow_manager TBorrowManager>
+    static void verify_not_borrowed(var<T, TBorrowManager> &source) noexcept
+    {
+        if constexpr (has_num_borrows<TBorrowManager>)
+        {
+            if (source.borrow_manager_.num_borrows() != 0)
+            {
+                // The refs of the source would dangle, like at its destruction
+                source.borrow_manager_.verify_dangling_references(typeid(T), &source);
+                abort();
+            }
+        }
+    }
+
+    template <underlying_type T, borrow_manager TBorrowManager>
+    static var<T, TBorrowManager> *relocate_bitwise(var<T, TBorrowManager> *source, void *destination) noexcept
+    {
+        // The self references given out by the post_constructor() can be revoked, like at the destruction
+        if constexpr (has_pre_destructor<T>)
+        {
+            source->instance_.pre_destructor();
+        }
+        if constexpr (has_verify_dangling_references<TBorrowManager>)
+        {
+            source->borrow_manager_.verify_dangling_references(typeid(T), source);
+        }
+        std::destroy_at(std::addressof(source->borrow_manager_));
+
+        std::memcpy(destination, static_cast<void *>(source), sizeof(var<T, TBorrowManager>));
+        auto *relocated = std::launder(static_cast<var<T, TBorrowManager> *>(destination));
+        relocated->renew_borrow_manager();
+        relocated->call_post_constructor();
+        return relocated;
+    }
+};
+
+}  // namespace detail
+
+template <underlying_type T, borrow_manager TBorrowManager>
+var<T, TBorrowManager> *relocate(var<T, TBorrowManager> *source, void *destination) noexcept
+{
+    if constexpr (is_trivially_relocatable_v<var<T, TBorrowManager>>)
+    {
+        return relocate_n(source, 1, destination);
+    }
+    else if constexpr (is_trivially_relocatable_v<T>)
+    {
+        return detail::var_relocation::relocate_bitwise(source, destination);
+    }
+    else
+    {
+        auto *relocated = ::new (destination) var<T, TBorrowManager>(std::move(*source));
+        std::destroy_at(source);
+        return relocated;
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+var<T, TBorrowManager> *relocate_n(var<T, TBorrowManager> *first, std::size_t count, void *destination) noexcept
+{
+    using var_t = var<T, TBorrowManager>;
+
+    if constexpr (is_trivially_relocatable_v<var_t>)
+    {
+        for (std::size_t index = 0; index < count; index++)
+        {
+            detail::var_relocation::verify_not_borrowed(first[index]);
+        }
+        // The unborrowed borrow managers are copied together with the instances
+        if (count != 0)
+        {
+            std::memcpy(destination, static_cast<void *>(first), count * sizeof(var_t));
+        }
+        return std::launder(static_cast<var_t *>(destination));
+    }
+    else
+    {
+        auto *relocated = static_cast<var_t *>(destination);
+        for (std::size_t index = 0; index < count; index++)
+        {
+            relocate(first + index, relocated + index);
+        }
+        return relocated;
+    }
+}
+
+}  // namespace saam
@@ -0,0 +1,285 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/borrow_manager_traits.hpp>
+#include <saam/detail/raw_stacktrace.hpp>
+#include <saam/detail/striped_mutex.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <typeinfo>
+#include <vector>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// The user must define this function to handle the dangling reference situation.
+// After this function, dangling reference(s) exist in the process, so the memory is possibly going to be corrupted soon.
+// All the dangling references are counted, but the creation stack is known only for the sampled ones,
+// so the number of sampled creation stacks is usually less than the number of dangling references.
+// Therefore, after returning from this function, the process will be aborted.
+using sampled_dangling_reference_panic_t = std::function<void(const std::type_info &var_type,
+                                                      void *var_instance,
+                                                      std::size_t num_dangling_references,
+                                                      const std::vector<raw_stacktrace> &sampled_ref_creation_stacks)>;
+inline sampled_dangling_reference_panic_t sampled_dangling_reference_panic;
+
+// The creation stack is captured for 1 in N reference registrations (N=1 captures all of them, N=0 captures none).
+inline std::atomic<std::size_t> sampled_creation_stack_rate = 64;
+
+// Counts the references like the counted_borrow_manager, and additionally tracks the creation stack of a sampled subset of them.
+// The unsampled references cost the same as in counted mode, only the sampled ones are chained (tracked) under a lock.
+class sampled_borrow_manager
+{
+    // Tracking record of a sampled reference
+    struct sample
+    {
+        sample *previous_ = nullptr;
+        sample *next_ = nullptr;
+        raw_stacktrace creation_stack_;
+    };
+
+  public:
+    // While not borrowed, there are no samples chained to the manager, so the var can be relocated bitwise (see relocate.hpp)
+    static constexpr bool is_relocatable_when_unborrowed = true;
+
+    // For the manager to be able to manage the reference, the reference must derived from this base class.
+    // This manager specific base class adds everything to a reference that is needed for its management.
+    class ref_base
+    {
+      public:
+        // If the underlying raw pointer is managed reference (refrence counted)
+        [[nodiscard]] bool is_managed() const noexcept
+        {
+            return borrow_manager_ != nullptr;
+        }
+
+        [[nodiscard]] sampled_borrow_manager *borrow_manager() const noexcept
+        {
+            return borrow_manager_;
+        }
+
+      protected:
+        ref_base() = default;
+
+        ref_base(sampled_borrow_manager *borrow_manager) :
+            borrow_manager_(borrow_manager)
+        {
+            register_self();
+        }
+
+        ref_base(const ref_base &other) :
+            borrow_manager_(other.borrow_manager_)
+        {
+            register_self();
+        }
+
+        ref_base(ref_base &&other) noexcept :
+            borrow_manager_(other.borrow_manager_),
+            sample_(other.sample_)
+        {
+            // "this" gets always the same reference counter and sample as "other"
+            // -> no modification on the counter needed
+            other.borrow_manager_ = nullptr;
+            other.sample_ = nullptr;
+        }
+
+        ref_base &operator=(const ref_base &other)
+        {
+            if (this == &other)
+            {
+                return *this;
+            }
+
+            const bool change_in_borrow_manager = borrow_manager_ != other.borrow_manager_;
+            if (change_in_borrow_manager)
+            {
+                unregister_self();
+
+                borrow_manager_ = other.borrow_manager_;
+                register_self();
+            }
+
+            return *this;
+        }
+
+        ref_base &operator=(ref_base &&other) noexcept
+        {
+            if (this == &other)
+            {
+                return *this;
+            }
+
+            const bool change_in_borrow_manager = borrow_manager_ != other.borrow_manager_;
+            if (change_in_borrow_manager)
+            {
+                unregister_self();
+
+                // Take over the count and the sample of "other"
+                borrow_manager_ = other.borrow_manager_;
+                sample_ = other.sample_;
+                other.borrow_manager_ = nullptr;
+                other.sample_ = nullptr;
+            }
+            else
+            {
+                other.unregister_self();
+            }
+
+            return *this;
+        }
+
+        ~ref_base()
+        {
+            unregister_self();
+        }
+
+        void register_self() noexcept
+        {
+            if (!is_managed())
+            {
+                return;
+            }
+
+            borrow_manager_->register_reference();
+
+            if (is_sampled_capture(sampled_creation_stack_rate.load(std::memory_order_relaxed)))
+            {
+                // Without memory the reference stays unsampled
+                sample_ = new (std::nothrow) sample{.creation_stack_ = raw_stacktrace::current()};
+                if (sample_ != nullptr)
+                {
+                    borrow_manager_->attach_sample(*sample_);
+                }
+            }
+        }
+
+        void unregister_self() noexcept
+        {
+            if (!is_managed())
+            {
+                return;
+            }
+
+            if (sample_ != nullptr)
+            {
+                borrow_manager_->detach_sample(*sample_);
+                delete sample_;
+                sample_ = nullptr;
+            }
+
+            borrow_manager_->unregister_reference();
+            borrow_manager_ = nullptr;
+        }
+
+      private:
+        sampled_borrow_manager *borrow_manager_ = nullptr;
+        sample *sample_ = nullptr;
+    };
+
+    // reference counters are not copied/moved, each var counts its own references
+    sampled_borrow_manager(const sampled_borrow_manager &other) = delete;
+    sampled_borrow_manager(sampled_borrow_manager &&other) noexcept = delete;
+    sampled_borrow_manager &operator=(const sampled_borrow_manager &other) = delete;
+    sampled_borrow_manager &operator=(sampled_borrow_manager &&other) noexcept = delete;
+    ~sampled_borrow_manager() = default;
+
+    // Number of the live references (sampled or not), a snapshot for diagnostics
+    [[nodiscard]] std::size_t num_borrows() const noexcept
+    {
+        return counter_.load(std::memory_order_relaxed);
+    }
+
+    void verify_dangling_references(const std::type_info &var_type, void *var_instance) const noexcept
+    {
+        std::size_t prev_value = 0;
+        const bool destroyed_with_active_references =
+            !counter_.compare_exchange_strong(prev_value, std::numeric_limits<std::size_t>::max());
+        if (destroyed_with_active_references)
+        {
+            const auto num_dangling_references = counter_.load();
+            if (sampled_dangling_reference_panic)
+            {
+                std::vector<raw_stacktrace> sampled_ref_creation_stacks;
+                {
+                    std::lock_guard guard(striped_mutex_lock_policy::get_mutex(this));
+                    for (auto *current_sample = sample_chain_root_; current_sample != nullptr; current_sample = current_sample->next_)
+                    {
+                        sampled_ref_creation_stacks.push_back(current_sample->creation_stack_);
+                    }
+                }
+                sampled_dangling_reference_panic(var_type, var_instance, num_dangling_references, sampled_ref_creation_stacks);
+            }
+            abort();
+        }
+    }
+
+  private:
+    sampled_borrow_manager() = default;
+
+    void register_reference() const
+    {
+        counter_++;
+    }
+
+    void unregister_reference() const
+    {
+        [[maybe_unused]] const auto prev_value = counter_--;
+        // Reference count cannot go below zero, so the previous value must be greater than zero
+        assert(prev_value > 0);
+    }
+
+    void attach_sample(sample &new_sample)
+    {
+        std::lock_guard guard(striped_mutex_lock_policy::get_mutex(this));
+        // Attach the new sample to the beginning of the chain, like the tracked_borrow_manager does
+        new_sample.next_ = sample_chain_root_;
+        if (sample_chain_root_ != nullptr)
+        {
+            sample_chain_root_->previous_ = &new_sample;
+        }
+        sample_chain_root_ = &new_sample;
+    }
+
+    void detach_sample(sample &sample_to_detach)
+    {
+        std::lock_guard guard(striped_mutex_lock_policy::get_mutex(this));
+        if (sample_to_detach.previous_ == nullptr)
+        {
+            assert(sample_chain_root_ == &sample_to_detach);
+            sample_chain_root_ = sample_to_detach.next_;
+        }
+        else
+        {
+            sample_to_detach.previous_->next_ = sample_to_detach.next_;
+        }
+
+        if (sample_to_detach.next_ != nullptr)
+        {
+            sample_to_detach.next_->previous_ = sample_to_detach.previous_;
+        }
+    }
+
+    template <underlying_type TOther, borrow_manager TOtherBorrowManager>
+    friend class var;
+
+    template <borrow_manager TOtherBorrowManager>
+    friend class statistics_borrow_manager;
+
+    // maxint the counter was closed, no more borrows are allowed
+    // 0 counter means that the instance is not borrowed
+    // counter > 0 means that the instance is borrowed
+    mutable std::atomic<std::size_t> counter_ = 0;
+
+    // The samples are rarely touched, so they are protected by the shared lock stripes instead of an own mutex
+    sample *sample_chain_root_ = nullptr;
+};
+
+}  // namespace saam
@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/ref.hpp>
+#include <saam/scoped_ref.hpp>
+
+#include <type_traits>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+template <underlying_type T>
+template <underlying_type TOther, borrow_manager TBorrowManager>
+    requires std::is_convertible_v<TOther *, T *>
+scoped_ref<T>::scoped_ref(const ref<TOther, TBorrowManager> &parent) noexcept :
+    instance_(static_cast<TOther *>(parent))
+{
+}
+
+template <underlying_type T>
+template <underlying_type TOther>
+    requires std::is_convertible_v<TOther *, T *>
+scoped_ref<T>::scoped_ref(const scoped_ref<TOther> &other) noexcept :
+    instance_(other.instance_)
+{
+}
+
+template <underlying_type T>
+bool scoped_ref<T>::operator==(const scoped_ref &other) const noexcept
+{
+    return instance_ == other.instance_;
+}
+
+template <underlying_type T>
+bool scoped_ref<T>::operator!=(const scoped_ref &other) const noexcept
+{
+    return !(instance_ == other.instance_);
+}
+
+template <underlying_type T>
+T *scoped_ref<T>::operator->() const noexcept
+{
+    return instance_;
+}
+
+template <underlying_type T>
+T &scoped_ref<T>::operator*() const noexcept
+{
+    return *instance_;
+}
+
+template <underlying_type T>
+scoped_ref<T>::operator T &() const noexcept
+{
+    return *instance_;
+}
+
+template <underlying_type T>
+scoped_ref<T>::operator T *() const noexcept
+{
+    return instance_;
+}
+
+}  // namespace saam
@@ -0,0 +1,123 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/sharded_synchronized.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+template <typename TContainer, std::size_t TShardCount, lock_policy TLockPolicy, typename THash>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+sharded_synchronized<TContainer, TShardCount, TLockPolicy, THash>::sharded_synchronized(THash hash) :
+    hash_(std::move(hash))
+{
+}
+
+template <typename TContainer, std::size_t TShardCount, lock_policy TLockPolicy, typename THash>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+std::size_t sharded_synchronized<TContainer, TShardCount, TLockPolicy, THash>::shard_index(const key_t &key) const noexcept
+{
+    // The hash is mixed (Fibonacci hashing), because std::hash of the integers is the identity on some platforms.
+    // The shard is selected by the upper bits (the best mixed ones), so the buckets of the containers stay evenly used within a shard.
+    const std::uint64_t mixed = static_cast<std::uint64_t>(hash_(key)) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<std::size_t>(((mixed >> 32) * TShardCount) >> 32);
+}
+
+template <typename TContainer, std::size_t TShardCount, lock_policy TLockPolicy, typename THash>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+guard<TContainer, TLockPolicy> sharded_synchronized<TContainer, TShardCount, TLockPolicy, THash>::commence_mut(const key_t &key)
+{
+    return shards_[shard_index(key)].instance.commence_mut();
+}
+
+template <typename TContainer, std::size_t TShardCount, lock_policy TLockPolicy, typename THash>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+guard<const TContainer, TLockPolicy> sharded_synchronized<TContainer, TShardCount, TLockPolicy, THash>::commence(const key_t &key) const
+{
+    return shards_[shard_index(key)].instance.commence();
+}
+
+template <typename TContainer, std::size_t TShardCount, lock_policy TLockPolicy, typename THash>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+std::optional<guard<TContainer, TLockPolicy>> sharded_synchronized<TContainer, TShardCount, TLockPolicy, THash>::try_commence_mut(
+    const key_t &key)
+{
+    return shards_[shard_index(key)].instance.try_commence_mut();
+}
+
+template <typename TContainer, std::size_t TShardCount, lock_policy TLockPolicy, typename THash>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+std::optional<guard<const TContainer, TLockPolicy>> sharded_synchronized<TContainer, TShardCount, TLockPolicy, THash>::try_commence(
+    const key_t &key) const
+{
+    return shards_[shard_index(key)].instance.try_commence();
+}
+
+template <typename TContainer, std::size_t TShardCount, lock_policy TLockPolicy, typename THash>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+std::vector<guard<TContainer, TLockPolicy>> sharded_synchronized<TContainer, TShardCount, TLockPolicy, THash>::commence_all_mut()
+{
+    return saam::commence_all<TContainer>(shard_addresses());
+}
+
+template <typename TContainer, std::size_t TShardCount, lock_policy TLockPolicy, typename THash>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+std::vector<guard<const TContainer, TLockPolicy>> sharded_synchronized<TContainer, TShardCount, TLockPolicy, THash>::commence_all() const
+{
+    return saam::commence_all<const TContainer>(shard_addresses());
+}
+
+template <typename TContainer, std::size_t TShardCount, lock_policy TLockPolicy, typename THash>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+std::size_t sharded_synchronized<TContainer, TShardCount, TLockPolicy, THash>::size() const
+{
+    std::size_t result = 0;
+    for (const auto &shard_guard : commence_all())
+    {
+        result += shard_guard->size();
+    }
+    return result;
+}
+
+template <typename TContainer, std::size_t TShardCount, lock_policy TLockPolicy, typename THash>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+typename sharded_synchronized<TContainer, TShardCount, TLockPolicy, THash>::shard_t &sharded_synchronized<TContainer, TShardCount,
+                                                                                                          TLockPolicy, THash>::shard(
+    std::size_t index) noexcept
+{
+    return shards_[index].instance;
+}
+
+template <typename TContainer, std::size_t TShardCount, lock_policy TLockPolicy, typename THash>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+const typename sharded_synchronized<TContainer, TShardCount, TLockPolicy, THash>::shard_t &sharded_synchronized<
+    TContainer, TShardCount, TLockPolicy, THash>::shard(std::size_t index) const noexcept
+{
+    return shards_[index].instance;
+}
+
+template <typename TContainer, std::size_t TShardCount, lock_policy TLockPolicy, typename THash>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+std::vector<typename sharded_synchronized<TContainer, TShardCount, TLockPolicy, THash>::shard_t *> sharded_synchronized<
+    TContainer, TShardCount, TLockPolicy, THash>::shard_addresses() const
+{
+    // Like commencing a single shard, locking all of them is a const operation
+    std::vector<shard_t *> result;
+    result.reserve(TShardCount);
+    for (auto &shard : shards_)
+    {
+        result.push_back(const_cast<shard_t *>(&shard.instance));
+    }
+    return result;
+}
+
+}  // namespace saam
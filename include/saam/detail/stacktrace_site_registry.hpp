@@ -0,0 +1,133 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/raw_stacktrace.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// Identifies an interned creation stacktrace (site), 0 stands for no stacktrace
+using stacktrace_site_id = std::uint32_t;
+inline constexpr stacktrace_site_id no_stacktrace_site = 0;
+
+namespace detail
+{
+
+// Process wide intern table of the creation stacktraces: the refs created at the same place in the code share a single copy of their stacktrace,
+// and each ref holds only the id of it. The sites are never removed, so the table grows with the number of distinct creation places.
+class stacktrace_site_registry
+{
+  public:
+    // Number of entries in the per thread cache of the recently interned stacktraces, it must be a power of two
+    static constexpr std::size_t cache_size = 64;
+    static_assert(cache_size > 0 && (cache_size & (cache_size - 1)) == 0, "the size of the stacktrace site cache must be a power of two");
+
+    // Returns no_stacktrace_site for an empty stacktrace, or when the table cannot grow
+    [[nodiscard]] static stacktrace_site_id intern(const raw_stacktrace &stacktrace) noexcept
+    {
+        if (stacktrace.empty())
+        {
+            return no_stacktrace_site;
+        }
+
+        // The interned stacktraces are immutable, so a cache hit is verified without locking the table
+        thread_local std::array<cache_entry, cache_size> cache{};
+        const std::size_t hash = stacktrace.hash();
+        auto &cached = cache[hash & (cache_size - 1)];
+        if (cached.stacktrace != nullptr && *cached.stacktrace == stacktrace)
+        {
+            return cached.id;
+        }
+
+        try
+        {
+            cached = find_or_insert(stacktrace);
+            return cached.id;
+        }
+        catch (...)
+        {
+            return no_stacktrace_site;
+        }
+    }
+
+    // The returned stacktrace lives until the end of the process, the no_stacktrace_site is an empty stacktrace
+    [[nodiscard]] static const raw_stacktrace &site(stacktrace_site_id id) noexcept
+    {
+        static const raw_stacktrace empty_stacktrace;
+        if (id == no_stacktrace_site)
+        {
+            return empty_stacktrace;
+        }
+
+        std::shared_lock lock(mutex_);
+        return *sites_[id - 1];
+    }
+
+    [[nodiscard]] static std::size_t size()
+    {
+        std::shared_lock lock(mutex_);
+        return sites_.size();
+    }
+
+  private:
+    struct cache_entry
+    {
+        const raw_stacktrace *stacktrace = nullptr;
+        stacktrace_site_id id = no_stacktrace_site;
+    };
+
+    struct hasher
+    {
+        std::size_t operator()(const raw_stacktrace &stacktrace) const noexcept
+        {
+            return stacktrace.hash();
+        }
+    };
+
+    static cache_entry find_or_insert(const raw_stacktrace &stacktrace)
+    {
+        {
+            std::shared_lock lock(mutex_);
+            if (auto found = ids_.find(stacktrace); found != ids_.end())
+            {
+                return {&found->first, found->second};
+            }
+        }
+
+        std::unique_lock lock(mutex_);
+        // The keys of the map are not moved on rehashing, the sites point to them
+        auto [inserted, is_new] = ids_.try_emplace(stacktrace, static_cast<stacktrace_site_id>(sites_.size() + 1));
+        if (is_new)
+        {
+            try
+            {
+                sites_.push_back(&inserted->first);
+            }
+            catch (...)
+            {
+                ids_.erase(inserted);
+                throw;
+            }
+        }
+        return {&inserted->first, inserted->second};
+    }
+
+    static inline std::shared_mutex mutex_;
+    static inline std::unordered_map<raw_stacktrace, stacktrace_site_id, hasher> ids_;
+    static inline std::vector<const raw_stacktrace *> sites_;
+};
+
+}  // namespace detail
+
+}  // namespace saam
@@ -0,0 +1,483 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/borrow_manager_traits.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// Borrow statistics of the vars of a type, aggregated since the start of the process
+struct type_borrow_statistics
+{
+    const std::type_info *var_type = nullptr;
+    // Number of vars created and destroyed
+    std::uint64_t vars_created = 0;
+    std::uint64_t vars_destroyed = 0;
+    // Number of refs created (a moved ref is not a new one), and released
+    std::uint64_t borrows = 0;
+    std::uint64_t releases = 0;
+    // Highest number of refs that were alive at the same time on a single var
+    std::uint64_t peak_live_refs = 0;
+    // Number of refs that were still alive, when their var was destroyed (dangling references)
+    std::uint64_t refs_outstanding_at_destruction = 0;
+    // Summed up and the longest lifetime of the released refs
+    std::chrono::nanoseconds total_ref_lifetime{0};
+    std::chrono::nanoseconds max_ref_lifetime{0};
+};
+
+// The borrow rates are the difference of two snapshots divided by the time between them
+struct borrow_statistics_snapshot
+{
+    std::chrono::steady_clock::time_point taken_at;
+    std::vector<type_borrow_statistics> types;
+};
+
+// Live references of a single var
+struct var_borrow_census
+{
+    const std::type_info *var_type = nullptr;
+    const void *var_instance = nullptr;
+    std::uint64_t live_refs = 0;
+};
+
+// The most borrowed live vars, a var that keeps growing between the snapshots is likely pinned by leaking refs
+struct borrow_census_snapshot
+{
+    std::chrono::steady_clock::time_point taken_at;
+    // In descending order of the live refs, the vars without live refs are not listed
+    std::vector<var_borrow_census> vars;
+};
+
+namespace detail
+{
+
+// Lock-free counters of a type, updated by the statistics_borrow_manager
+struct type_borrow_counters
+{
+    std::atomic<std::uint64_t> vars_created = 0;
+    std::atomic<std::uint64_t> vars_destroyed = 0;
+    std::atomic<std::uint64_t> borrows = 0;
+    std::atomic<std::uint64_t> releases = 0;
+    std::atomic<std::uint64_t> peak_live_refs = 0;
+    std::atomic<std::uint64_t> refs_outstanding_at_destruction = 0;
+    std::atomic<std::int64_t> total_ref_lifetime_ns = 0;
+    std::atomic<std::int64_t> max_ref_lifetime_ns = 0;
+};
+
+template <typename TValue>
+void update_maximum(std::atomic<TValue> &maximum, TValue value) noexcept
+{
+    auto current = maximum.load(std::memory_order_relaxed);
+    while (current < value && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+// The counters are registered once per type, they are never released, so they can be referred without locking
+class borrow_statistics_registry
+{
+  public:
+    static type_borrow_counters &counters_of(const std::type_info &var_type)
+    {
+        std::lock_guard guard(mutex_);
+        auto &counters = counters_[std::type_index(var_type)];
+        if (!counters.second)
+        {
+            counters = {&var_type, std::make_unique<type_borrow_counters>()};
+        }
+        return *counters.second;
+    }
+
+    static borrow_statistics_snapshot snapshot()
+    {
+        borrow_statistics_snapshot result{.taken_at = std::chrono::steady_clock::now(), .types = {}};
+
+        std::lock_guard guard(mutex_);
+        result.types.reserve(counters_.size());
+        for (const auto &[type_index, type_counters] : counters_)
+        {
+            const auto &[var_type, counters] = type_counters;
+            result.types.push_back({
+                .var_type = var_type,
+                .vars_created = counters->vars_created.load(std::memory_order_relaxed),
+                .vars_destroyed = counters->vars_destroyed.load(std::memory_order_relaxed),
+                .borrows = counters->borrows.load(std::memory_order_relaxed),
+                .releases = counters->releases.load(std::memory_order_relaxed),
+                .peak_live_refs = counters->peak_live_refs.load(std::memory_order_relaxed),
+                .refs_outstanding_at_destruction = counters->refs_outstanding_at_destruction.load(std::memory_order_relaxed),
+                .total_ref_lifetime = std::chrono::nanoseconds(counters->total_ref_lifetime_ns.load(std::memory_order_relaxed)),
+                .max_ref_lifetime = std::chrono::nanoseconds(counters->max_ref_lifetime_ns.load(std::memory_order_relaxed)),
+            });
+        }
+        return result;
+    }
+
+  private:
+    static inline std::mutex mutex_;
+    static inline std::map<std::type_index, std::pair<const std::type_info *, std::unique_ptr<type_borrow_counters>>> counters_;
+};
+
+// A live var in the borrow census registry, it is owned by the statistics_borrow_manager of the var
+struct borrow_census_entry
+{
+    const std::type_info *var_type = nullptr;
+    const void *var_instance = nullptr;
+    const std::atomic<std::uint64_t> *live_refs = nullptr;
+    borrow_census_entry *previous = nullptr;
+    borrow_census_entry *next = nullptr;
+};
+
+// Intrusive list of the live vars, a var is linked at its construction and unlinked at its destruction
+class borrow_census_registry
+{
+  public:
+    static void attach(borrow_census_entry &entry) noexcept
+    {
+        std::lock_guard guard(mutex_);
+        entry.previous = nullptr;
+        entry.next = root_;
+        if (root_ != nullptr)
+        {
+            root_->previous = &entry;
+        }
+        root_ = &entry;
+    }
+
+    static void detach(borrow_census_entry &entry) noexcept
+    {
+        std::lock_guard guard(mutex_);
+        *(entry.previous == nullptr ? &root_ : &entry.previous->next) = entry.next;
+        if (entry.next != nullptr)
+        {
+            entry.next->previous = entry.previous;
+        }
+        entry.previous = nullptr;
+        entry.next = nullptr;
+    }
+
+    static borrow_census_snapshot snapshot(std::size_t top_n)
+    {
+        borrow_census_snapshot result{.taken_at = std::chrono::steady_clock::now(), .vars = {}};
+        {
+            std::lock_guard guard(mutex_);
+            for (const auto *entry = root_; entry != nullptr; entry = entry->next)
+            {
+                const auto live_refs = entry->live_refs->load(std::memory_order_relaxed);
+                if (live_refs != 0)
+                {
+                    result.vars.push_back({.var_type = entry->var_type, .var_instance = entry->var_instance, .live_refs = live_refs});
+                }
+            }
+        }
+
+        const auto by_live_refs = [](const auto &lhs, const auto &rhs) { return lhs.live_refs > rhs.live_refs; };
+        const auto top_end = result.vars.begin() + static_cast<std::ptrdiff_t>(std::min(top_n, result.vars.size()));
+        std::partial_sort(result.vars.begin(), top_end, result.vars.end(), by_live_refs);
+        result.vars.erase(top_end, result.vars.end());
+        return result;
+    }
+
+  private:
+    static inline std::mutex mutex_;
+    static inline borrow_census_entry *root_ = nullptr;
+};
+
+}  // namespace detail
+
+// Takes a consistent list of the types, the counters of the types are read one by one (not atomically together)
+inline borrow_statistics_snapshot take_borrow_statistics_snapshot()
+{
+    return detail::borrow_statistics_registry::snapshot();
+}
+
+// Lists the top_n vars with the most live refs, among the vars with a statistics_borrow_manager.
+// The list of the vars is consistent, their counters are read one by one.
+inline borrow_census_snapshot take_borrow_census(std::size_t top_n = 10)
+{
+    return detail::borrow_census_registry::snapshot(top_n);
+}
+
+// Exports the snapshot in the Prometheus text exposition format, the type is given by its (implementation specific) type name
+inline std::ostream &operator<<(std::ostream &stream, const borrow_statistics_snapshot &snapshot)
+{
+    const auto write_metric = [&](const char *name, const char *metric_type, const auto &value_of) {
+        stream << "# TYPE " << name << ' ' << metric_type << '\n';
+        for (const auto &type_statistics : snapshot.types)
+        {
+            stream << name << "{type=\"" << type_statistics.var_type->name() << "\"} " << value_of(type_statistics) << '\n';
+        }
+    };
+
+    write_metric("saam_vars_created_total", "counter", [](const auto &statistics) { return statistics.vars_created; });
+    write_metric("saam_vars_destroyed_total", "counter", [](const auto &statistics) { return statistics.vars_destroyed; });
+    write_metric("saam_borrows_total", "counter", [](const auto &statistics) { return statistics.borrows; });
+    write_metric("saam_releases_total", "counter", [](const auto &statistics) { return statistics.releases; });
+    write_metric("saam_peak_live_refs", "gauge", [](const auto &statistics) { return statistics.peak_live_refs; });
+    write_metric("saam_refs_outstanding_at_destruction_total", "counter", [](const auto &statistics) {
+        return statistics.refs_outstanding_at_destruction;
+    });
+    write_metric("saam_ref_lifetime_seconds_total", "counter", [](const auto &statistics) {
+        return std::chrono::duration<double>(statistics.total_ref_lifetime).count();
+    });
+    write_metric("saam_ref_lifetime_seconds_max", "gauge", [](const auto &statistics) {
+        return std::chrono::duration<double>(statistics.max_ref_lifetime).count();
+    });
+    return stream;
+}
+
+// Exports the census in the Prometheus text exposition format, the var is identified by its type and its address
+inline std::ostream &operator<<(std::ostream &stream, const borrow_census_snapshot &snapshot)
+{
+    stream << "# TYPE saam_var_live_refs gauge\n";
+    for (const auto &var_census : snapshot.vars)
+    {
+        stream << "saam_var_live_refs{type=\"" << var_census.var_type->name() << "\",var=\"" << var_census.var_instance << "\"} "
+               << var_census.live_refs << '\n';
+    }
+    return stream;
+}
+
+// Collects borrow statistics of the vars per type, and delegates the borrow checking to the wrapped borrow manager.
+// Each ref gets a creation timestamp, so the statistics adds a clock read and a few relaxed atomic operations to the borrows,
+// it is meant to be used for profiling (see SAAM_BORROW_STATISTICS), or for selected types (see borrow_manager_for).
+template <borrow_manager TBorrowManager>
+class statistics_borrow_manager
+{
+    using clock_t = std::chrono::steady_clock;
+
+  public:
+    using wrapped_borrow_manager_t = TBorrowManager;
+
+    // For the manager to be able to manage the reference, the reference must derived from this base class.
+    // This manager specific base class adds everything to a reference that is needed for its management.
+    class ref_base : private TBorrowManager::ref_base
+    {
+        using wrapped_ref_base_t = typename TBorrowManager::ref_base;
+
+      public:
+        // If the underlying raw pointer is managed reference, as the wrapped borrow manager sees it
+        [[nodiscard]] bool is_managed() const noexcept
+        {
+            return wrapped_ref_base_t::is_managed();
+        }
+
+        [[nodiscard]] statistics_borrow_manager *borrow_manager() const noexcept
+        {
+            return borrow_manager_;
+        }
+
+      protected:
+        ref_base() = default;
+
+        ref_base(statistics_borrow_manager *borrow_manager) :
+            wrapped_ref_base_t(borrow_manager != nullptr ? &borrow_manager->wrapped_borrow_manager_ : nullptr),
+            borrow_manager_(borrow_manager)
+        {
+            register_self();
+        }
+
+        ref_base(const ref_base &other) :
+            wrapped_ref_base_t(other),
+            borrow_manager_(other.borrow_manager_)
+        {
+            register_self();
+        }
+
+        ref_base(ref_base &&other) noexcept :
+            wrapped_ref_base_t(std::move(other)),
+            borrow_manager_(other.borrow_manager_),
+            created_at_(other.created_at_)
+        {
+            // A moved ref lives on in "this", its lifetime continues
+            other.borrow_manager_ = nullptr;
+        }
+
+        ref_base &operator=(const ref_base &other)
+        {
+            if (this == &other)
+            {
+                return *this;
+            }
+
+            wrapped_ref_base_t::operator=(other);
+
+            const bool change_in_borrow_manager = borrow_manager_ != other.borrow_manager_;
+            if (change_in_borrow_manager)
+            {
+                unregister_self();
+
+                borrow_manager_ = other.borrow_manager_;
+                register_self();
+            }
+
+            return *this;
+        }
+
+        ref_base &operator=(ref_base &&other) noexcept
+        {
+            if (this == &other)
+            {
+                return *this;
+            }
+
+            wrapped_ref_base_t::operator=(std::move(other));
+
+            const bool change_in_borrow_manager = borrow_manager_ != other.borrow_manager_;
+            if (change_in_borrow_manager)
+            {
+                unregister_self();
+
+                // Take over the ref of "other" together with its lifetime
+                borrow_manager_ = other.borrow_manager_;
+                created_at_ = other.created_at_;
+                other.borrow_manager_ = nullptr;
+            }
+            else
+            {
+                other.unregister_self();
+            }
+
+            return *this;
+        }
+
+        ~ref_base()
+        {
+            unregister_self();
+        }
+
+        void register_self() noexcept
+        {
+            if (borrow_manager_ == nullptr)
+            {
+                return;
+            }
+
+            created_at_ = clock_t::now();
+            borrow_manager_->register_reference();
+        }
+
+        void unregister_self() noexcept
+        {
+            if (borrow_manager_ == nullptr)
+            {
+                return;
+            }
+
+            borrow_manager_->unregister_reference(clock_t::now() - created_at_);
+            borrow_manager_ = nullptr;
+        }
+
+      private:
+        statistics_borrow_manager *borrow_manager_ = nullptr;
+        clock_t::time_point created_at_;
+    };
+
+    // reference counters are not copied/moved, each var counts its own references
+    statistics_borrow_manager(const statistics_borrow_manager &other) = delete;
+    statistics_borrow_manager(statistics_borrow_manager &&other) noexcept = delete;
+    statistics_borrow_manager &operator=(const statistics_borrow_manager &other) = delete;
+    statistics_borrow_manager &operator=(statistics_borrow_manager &&other) noexcept = delete;
+
+    ~statistics_borrow_manager()
+    {
+        if (census_entry_.var_type != nullptr)
+        {
+            detail::borrow_census_registry::detach(census_entry_);
+        }
+    }
+
+    // Called by the var on its construction, the var is listed in the borrow census until its destruction
+    template <typename T>
+    void bind_var_type(const void *var_instance) noexcept
+    {
+        // Each type is looked up only once
+        static detail::type_borrow_counters &counters = detail::borrow_statistics_registry::counters_of(typeid(T));
+        counters_ = &counters;
+        counters_->vars_created.fetch_add(1, std::memory_order_relaxed);
+
+        census_entry_.var_type = &typeid(T);
+        census_entry_.var_instance = var_instance;
+        census_entry_.live_refs = &live_refs_;
+        detail::borrow_census_registry::attach(census_entry_);
+    }
+
+    [[nodiscard]] std::size_t num_borrows() const noexcept
+    {
+        return static_cast<std::size_t>(live_refs_.load(std::memory_order_relaxed));
+    }
+
+    [[nodiscard]] auto borrow_census() const
+        requires has_borrow_census<TBorrowManager>
+    {
+        return wrapped_borrow_manager_.borrow_census();
+    }
+
+    void verify_dangling_references(const std::type_info &var_type, void *var_instance) const noexcept
+    {
+        // The statistics is updated first, because the wrapped borrow manager may abort the process
+        if (counters_ != nullptr)
+        {
+            counters_->vars_destroyed.fetch_add(1, std::memory_order_relaxed);
+            counters_->refs_outstanding_at_destruction.fetch_add(live_refs_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        if constexpr (has_verify_dangling_references<TBorrowManager>)
+        {
+            wrapped_borrow_manager_.verify_dangling_references(var_type, var_instance);
+        }
+    }
+
+  private:
+    statistics_borrow_manager() = default;
+
+    void register_reference() noexcept
+    {
+        const auto live_refs = live_refs_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (counters_ != nullptr)
+        {
+            counters_->borrows.fetch_add(1, std::memory_order_relaxed);
+            detail::update_maximum(counters_->peak_live_refs, live_refs);
+        }
+    }
+
+    void unregister_reference(clock_t::duration ref_lifetime) noexcept
+    {
+        live_refs_.fetch_sub(1, std::memory_order_relaxed);
+        if (counters_ != nullptr)
+        {
+            const auto lifetime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(ref_lifetime).count();
+            counters_->releases.fetch_add(1, std::memory_order_relaxed);
+            counters_->total_ref_lifetime_ns.fetch_add(lifetime_ns, std::memory_order_relaxed);
+            detail::update_maximum(counters_->max_ref_lifetime_ns, static_cast<std::int64_t>(lifetime_ns));
+        }
+    }
+
+    template <underlying_type TOther, borrow_manager TOtherBorrowManager>
+    friend class var;
+
+    mutable TBorrowManager wrapped_borrow_manager_;
+
+    // Without being bound to a type (not created by a var), the manager does not collect statistics
+    detail::type_borrow_counters *counters_ = nullptr;
+    std::atomic<std::uint64_t> live_refs_ = 0;
+    detail::borrow_census_entry census_entry_;
+};
+
+}  // namespace saam
@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/abi.hpp>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+namespace detail
+{
+
+// Selects a stripe of a global table by an address.
+// Fibonacci hashing spreads the neighbouring addresses (e.g. vars in an array) over the stripes.
+template <std::size_t NumStripes>
+    requires(NumStripes > 0 && (NumStripes & (NumStripes - 1)) == 0)
+[[nodiscard]] std::size_t stripe_index_of(const void *address) noexcept
+{
+    constexpr std::uint64_t golden_ratio = 0x9E3779B97F4A7C15ULL;
+    constexpr int stripe_bits = std::countr_zero(NumStripes);
+    const auto address_value = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(address));
+    return stripe_bits == 0 ? 0 : static_cast<std::size_t>((address_value * golden_ratio) >> (64 - stripe_bits));
+}
+
+}  // namespace detail
+
+// The lock policy provides the mutex that protects the reference chain of a borrow manager
+
+// The borrow manager owns its mutex
+class owned_mutex_lock_policy
+{
+  public:
+    std::mutex &get_mutex(const void * /*borrow_manager*/) const noexcept
+    {
+        return mutex_;
+    }
+
+  private:
+    mutable std::mutex mutex_;
+};
+
+// The borrow managers share a global table of mutexes, the mutex is selected by the address of the borrow manager
+class striped_mutex_lock_policy
+{
+  public:
+    // Number of mutexes in the global lock stripe table of the borrow managers, it must be a power of two
+    static constexpr std::size_t num_stripes = 64;
+    static_assert(num_stripes > 0 && (num_stripes & (num_stripes - 1)) == 0, "the number of lock stripes must be a power of two");
+
+    static std::mutex &get_mutex(const void *borrow_manager) noexcept
+    {
+        return stripes_[detail::stripe_index_of<num_stripes>(borrow_manager)].mutex;
+    }
+
+  private:
+    // Each mutex is on its own cache line, so the stripes do not falsely share
+    struct alignas(64) stripe
+    {
+        std::mutex mutex;
+    };
+
+    static inline std::array<stripe, num_stripes> stripes_;
+};
+
+}  // namespace saam
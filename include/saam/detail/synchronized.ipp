@@ -6,135 +6,470 @@
 
 #include <saam/synchronized.hpp>
 
-namespace saam
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <typeinfo>
+#include <utility>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-synchronized<T>::synchronized() = default;
+synchronized<T, TLockPolicy>::synchronized() = default;
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
 template <typename... Args>
-synchronized<T>::synchronized(std::in_place_t, Args &&...args) :
+synchronized<T, TLockPolicy>::synchronized(std::in_place_t, Args &&...args) :
     protected_instance_(std::in_place, std::forward<Args>(args)...)
 {
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-synchronized<T>::synchronized(const T &instance) :
+synchronized<T, TLockPolicy>::synchronized(const T &instance) :
     protected_instance_(instance)
 {
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-synchronized<T>::synchronized(T &&instance) :
+synchronized<T, TLockPolicy>::synchronized(T &&instance) :
     protected_instance_(std::move(instance))
 {
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-synchronized<T>::synchronized(const synchronized &other) :
+synchronized<T, TLockPolicy>::synchronized(const synchronized &other) :
     // Copy over the content of the other protected instance
     protected_instance_(*other.commence())
 {
     // The mutexes of "this" and "other" are independent
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-synchronized<T>::synchronized(synchronized &&other) :
+synchronized<T, TLockPolicy>::synchronized(synchronized &&other) :
     // Move over the content of the other protected instance
     protected_instance_(std::move(*other.commence_mut()))
 {
     // The mutexes of "this" and "other" are independent
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-synchronized<T> &synchronized<T>::operator=(const synchronized<T> &other)
+synchronized<T, TLockPolicy> &synchronized<T, TLockPolicy>::operator=(const synchronized<T, TLockPolicy> &other)
 {
     if (this == &other)
     {
         return *this;
     }
 
-    std::unique_lock<mutex_t> this_lock(mutex_, std::defer_lock);
-    std::shared_lock<mutex_t> other_lock(other.mutex_, std::defer_lock);
-    std::lock(this_lock, other_lock);
+    {
+        typename TLockPolicy::unique_lock_t this_lock(mutex_, std::defer_lock);
+        typename TLockPolicy::shared_lock_t other_lock(other.mutex_, std::defer_lock);
+        std::lock(this_lock, other_lock);
 
-    protected_instance_ = other.protected_instance_;
+        protected_instance_ = other.protected_instance_;
+    }
 
+    // Like a mutable guard, the waiters are notified after the unlock
+    detail::change_notifier::notify_changed(&mutex_);
     return *this;
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-synchronized<T> &synchronized<T>::operator=(synchronized<T> &&other)
+synchronized<T, TLockPolicy> &synchronized<T, TLockPolicy>::operator=(synchronized<T, TLockPolicy> &&other)
 {
     if (this == &other)
     {
         return *this;
     }
 
-    std::unique_lock<mutex_t> this_lock(mutex_, std::defer_lock);
-    std::unique_lock<mutex_t> other_lock(other.mutex_, std::defer_lock);
-    std::lock(this_lock, other_lock);
+    {
+        typename TLockPolicy::unique_lock_t this_lock(mutex_, std::defer_lock);
+        typename TLockPolicy::unique_lock_t other_lock(other.mutex_, std::defer_lock);
+        std::lock(this_lock, other_lock);
 
-    protected_instance_ = std::move(other.protected_instance_);
+        protected_instance_ = std::move(other.protected_instance_);
+    }
 
+    // Both instances are modified, the moved-from source too
+    detail::change_notifier::notify_changed(&mutex_);
+    detail::change_notifier::notify_changed(&other.mutex_);
     return *this;
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+synchronized<T, TLockPolicy>::~synchronized()
+{
+    verify_dangling_guards();
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+guard<T, TLockPolicy> synchronized<T, TLockPolicy>::commence_mut()
+{
+    return guard<T, TLockPolicy>(*this);
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+guard<const T, TLockPolicy> synchronized<T, TLockPolicy>::commence() const
+{
+    return guard<const T, TLockPolicy>(*this);
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+std::optional<guard<T, TLockPolicy>> synchronized<T, TLockPolicy>::try_commence_mut()
+{
+    return try_commence_as<T>(std::try_to_lock);
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+std::optional<guard<const T, TLockPolicy>> synchronized<T, TLockPolicy>::try_commence() const
+{
+    return try_commence_as<const T>(std::try_to_lock);
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TRep, typename TPeriod>
+std::optional<guard<T, TLockPolicy>> synchronized<T, TLockPolicy>::try_commence_mut_for(const std::chrono::duration<TRep, TPeriod> &timeout)
+    requires timed_lock_policy<TLockPolicy>
+{
+    return try_commence_as<T>(timeout);
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TClock, typename TDuration>
+std::optional<guard<T, TLockPolicy>> synchronized<T, TLockPolicy>::try_commence_mut_until(
+    const std::chrono::time_point<TClock, TDuration> &deadline)
+    requires timed_lock_policy<TLockPolicy>
+{
+    return try_commence_as<T>(deadline);
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TRep, typename TPeriod>
+std::optional<guard<const T, TLockPolicy>> synchronized<T, TLockPolicy>::try_commence_for(
+    const std::chrono::duration<TRep, TPeriod> &timeout) const
+    requires timed_lock_policy<TLockPolicy>
+{
+    return try_commence_as<const T>(timeout);
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TClock, typename TDuration>
+std::optional<guard<const T, TLockPolicy>> synchronized<T, TLockPolicy>::try_commence_until(
+    const std::chrono::time_point<TClock, TDuration> &deadline) const
+    requires timed_lock_policy<TLockPolicy>
+{
+    return try_commence_as<const T>(deadline);
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+upgrade_guard<T, TLockPolicy> synchronized<T, TLockPolicy>::commence_upgradable()
+    requires upgradable_lock_policy<TLockPolicy>
+{
+    return upgrade_guard<T, TLockPolicy>(instance(), typename TLockPolicy::upgrade_lock_t(mutex_), detail::guard_token<>(guard_counter_));
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <std::predicate<const T &> TPredicate>
+guard<const T, TLockPolicy> synchronized<T, TLockPolicy>::commence_when(TPredicate predicate) const
+{
+    return *commence_as_when<const T>([&predicate](auto &lock, const T &instance) {
+        detail::change_notifier::wait(lock, [&]() -> bool { return predicate(instance); });
+        return true;
+    });
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <std::predicate<const T &> TPredicate>
+guard<T, TLockPolicy> synchronized<T, TLockPolicy>::commence_mut_when(TPredicate predicate)
+{
+    return *commence_as_when<T>([&predicate](auto &lock, const T &instance) {
+        detail::change_notifier::wait(lock, [&]() -> bool { return predicate(instance); });
+        return true;
+    });
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TRep, typename TPeriod, std::predicate<const T &> TPredicate>
+std::optional<guard<const T, TLockPolicy>> synchronized<T, TLockPolicy>::commence_when_for(
+    const std::chrono::duration<TRep, TPeriod> &timeout, TPredicate predicate) const
+{
+    return commence_when_until(std::chrono::steady_clock::now() + timeout, std::move(predicate));
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TClock, typename TDuration, std::predicate<const T &> TPredicate>
+std::optional<guard<const T, TLockPolicy>> synchronized<T, TLockPolicy>::commence_when_until(
+    const std::chrono::time_point<TClock, TDuration> &deadline, TPredicate predicate) const
+{
+    return commence_as_when<const T>([&predicate, &deadline](auto &lock, const T &instance) {
+        return detail::change_notifier::wait_until(lock, deadline, [&]() -> bool { return predicate(instance); });
+    });
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TRep, typename TPeriod, std::predicate<const T &> TPredicate>
+std::optional<guard<T, TLockPolicy>> synchronized<T, TLockPolicy>::commence_mut_when_for(const std::chrono::duration<TRep, TPeriod> &timeout,
+                                                                                          TPredicate predicate)
+{
+    return commence_mut_when_until(std::chrono::steady_clock::now() + timeout, std::move(predicate));
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TClock, typename TDuration, std::predicate<const T &> TPredicate>
+std::optional<guard<T, TLockPolicy>> synchronized<T, TLockPolicy>::commence_mut_when_until(
+    const std::chrono::time_point<TClock, TDuration> &deadline, TPredicate predicate)
+{
+    return commence_as_when<T>([&predicate, &deadline](auto &lock, const T &instance) {
+        return detail::change_notifier::wait_until(lock, deadline, [&]() -> bool { return predicate(instance); });
+    });
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+T synchronized<T, TLockPolicy>::snapshot() const
+    requires(optimistic_lock_policy<TLockPolicy> && std::is_trivially_copyable_v<T>)
+{
+    // T is not required to be default constructible, so the copy is made into raw bytes.
+    // The bytes may be torn by a parallel writer, but then the sequence number changes, and the torn copy is dropped.
+    // The instance is read without borrowing it, it lives as long as "this", and the readers must keep "this" alive anyway.
+    const T *source = instance();
+    std::array<std::byte, sizeof(T)> copy;
+    while (true)
+    {
+        const auto sequence = mutex_.read_begin();
+        std::memcpy(copy.data(), source, sizeof(T));
+        if (!mutex_.read_retry(sequence))
+        {
+            return std::bit_cast<T>(copy);
+        }
+    }
+}
+
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-synchronized<T>::~synchronized() = default;
+template <typename TExecutor>
+auto synchronized<T, TLockPolicy>::async_commence_mut(TExecutor executor)
+    requires requires(mutex_t &mutex) { mutex.async_lock(executor); }
+{
+    return guard_awaiter<T, decltype(mutex_.async_lock(executor))>(*this, mutex_.async_lock(std::move(executor)));
+}
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-guard<T> synchronized<T>::commence_mut()
+template <typename TExecutor>
+auto synchronized<T, TLockPolicy>::async_commence(TExecutor executor) const
+    requires requires(mutex_t &mutex) { mutex.async_lock_shared(executor); }
 {
-    return guard<T>(*this);
+    // With an exclusive lock policy, the immutable guards take the exclusive lock too
+    if constexpr (TLockPolicy::is_shared)
+    {
+        return guard_awaiter<const T, decltype(mutex_.async_lock_shared(executor))>(*this, mutex_.async_lock_shared(std::move(executor)));
+    }
+    else
+    {
+        return guard_awaiter<const T, decltype(mutex_.async_lock(executor))>(*this, mutex_.async_lock(std::move(executor)));
+    }
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-guard<const T> synchronized<T>::commence() const
+template <std::invocable<T &> TFunction>
+std::invoke_result_t<TFunction &, T &> synchronized<T, TLockPolicy>::apply(TFunction &&function)
 {
-    return guard<const T>(*this);
+    static_assert(!std::is_reference_v<std::invoke_result_t<TFunction &, T &>>,
+                  "apply: the result is returned after the unlock, it must not refer into the protected instance");
+
+    if constexpr (requires { mutex_.combining_queue(); })
+    {
+        return mutex_.combining_queue().apply(function, [this]() { return try_commence_mut(); });
+    }
+    else
+    {
+        auto guard = commence_mut();
+        return std::invoke(function, *guard);
+    }
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-[[nodiscard]] guard<T> synchronized<T>::operator->()
+auto &synchronized<T, TLockPolicy>::profile() const
+    requires requires(const mutex_t &mutex) { mutex.profile(); }
 {
-    return guard<T>(*this);
+    return mutex_.profile();
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-[[nodiscard]] guard<const T> synchronized<T>::operator->() const
+[[nodiscard]] guard<T, TLockPolicy> synchronized<T, TLockPolicy>::operator->()
 {
-    return guard<const T>(*this);
+    return guard<T, TLockPolicy>(*this);
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-synchronized<T> &synchronized<T>::operator=(const T &instance)
+[[nodiscard]] guard<const T, TLockPolicy> synchronized<T, TLockPolicy>::operator->() const
+{
+    return guard<const T, TLockPolicy>(*this);
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+synchronized<T, TLockPolicy> &synchronized<T, TLockPolicy>::operator=(const T &instance)
 {
     *commence_mut() = instance;
     return *this;
 }
 
-template <typename T>
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
-synchronized<T> &synchronized<T>::operator=(T &&instance)
+synchronized<T, TLockPolicy> &synchronized<T, TLockPolicy>::operator=(T &&instance)
 {
     *commence_mut() = std::move(instance);
     return *this;
 }
 
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+typename synchronized<T, TLockPolicy>::mutex_t synchronized<T, TLockPolicy>::make_mutex()
+{
+    if constexpr (std::is_constructible_v<mutex_t, const std::type_info &>)
+    {
+        return mutex_t(typeid(T));
+    }
+    else
+    {
+        return mutex_t();
+    }
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+T *synchronized<T, TLockPolicy>::instance() const noexcept
+{
+    // Like borrowing, the access to the instance is a const operation of the synchronized
+    return const_cast<T *>(std::addressof(protected_instance_.instance_));
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+void synchronized<T, TLockPolicy>::verify_dangling_guards() noexcept
+{
+    // Counting the guards does not touch the mutex, so it is valid for every lock policy, even when the destroying thread holds a guard.
+    // The unchecked mode does not count them (see guard_counter.hpp).
+    if (guard_counter_.num_guards() == 0)
+    {
+        return;
+    }
+
+    if (dangling_guard_panic)
+    {
+        dangling_guard_panic(typeid(*this), this);
+    }
+    abort();
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TGuarded, typename... TLockArgs>
+std::optional<guard<TGuarded, TLockPolicy>> synchronized<T, TLockPolicy>::try_commence_as(TLockArgs &&...lock_args) const
+{
+    typename guard<TGuarded, TLockPolicy>::lock_t lock(mutex_, std::forward<TLockArgs>(lock_args)...);
+    if (!lock.owns_lock())
+    {
+        return std::nullopt;
+    }
+
+    return make_guard_as<TGuarded>(std::move(lock));
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TGuarded, typename TWait>
+std::optional<guard<TGuarded, TLockPolicy>> synchronized<T, TLockPolicy>::commence_as_when(TWait wait) const
+{
+    auto locked = make_guard_as<TGuarded>(lock_as<TGuarded>());
+    // Read via the ref of the guard, so the predicate does not mark the mutable guard as modified
+    if (!wait(locked.lock_, std::as_const(*locked.protected_instance_)))
+    {
+        return std::nullopt;
+    }
+    return locked;
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TGuarded>
+typename guard<TGuarded, TLockPolicy>::lock_t synchronized<T, TLockPolicy>::lock_as() const
+{
+    return typename guard<TGuarded, TLockPolicy>::lock_t(mutex_);
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TGuarded>
+guard<TGuarded, TLockPolicy> synchronized<T, TLockPolicy>::make_guard_as(typename guard<TGuarded, TLockPolicy>::lock_t lock) const
+{
+    return guard<TGuarded, TLockPolicy>(instance(), std::move(lock), detail::guard_token<>(guard_counter_));
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TGuarded>
+std::shared_ptr<void> synchronized<T, TLockPolicy>::share_lock_as(typename guard<TGuarded, TLockPolicy>::lock_t lock)
+{
+    if constexpr (std::is_const_v<TGuarded> && TLockPolicy::is_shared)
+    {
+        return std::make_shared<typename guard<TGuarded, TLockPolicy>::lock_t>(std::move(lock));
+    }
+    else
+    {
+        // Not reached, such a duplicate panics before
+        return nullptr;
+    }
+}
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+template <typename TGuarded>
+guard<TGuarded, TLockPolicy> synchronized<T, TLockPolicy>::make_guard_as(typename guard<TGuarded, TLockPolicy>::lock_t lock,
+                                                                        const std::shared_ptr<void> &shared_lock) const
+{
+    if constexpr (std::is_const_v<TGuarded> && TLockPolicy::is_shared)
+    {
+        if (shared_lock != nullptr)
+        {
+            using lock_t = typename guard<TGuarded, TLockPolicy>::lock_t;
+            return guard<TGuarded, TLockPolicy>(instance(), std::static_pointer_cast<lock_t>(shared_lock), detail::guard_token<>(guard_counter_));
+        }
+    }
+    return make_guard_as<TGuarded>(std::move(lock));
+}
+
 }  // namespace saam
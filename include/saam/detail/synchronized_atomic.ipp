@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/synchronized_atomic.hpp>
+
+#include <functional>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+template <lock_free_atomic T, bool TWaitable>
+synchronized_atomic<T, TWaitable>::synchronized_atomic() noexcept :
+    instance_(T{})
+{
+}
+
+template <lock_free_atomic T, bool TWaitable>
+synchronized_atomic<T, TWaitable>::synchronized_atomic(T instance) noexcept :
+    instance_(instance)
+{
+}
+
+template <lock_free_atomic T, bool TWaitable>
+synchronized_atomic<T, TWaitable>::synchronized_atomic(const synchronized_atomic &other) noexcept :
+    instance_(other.load())
+{
+}
+
+template <lock_free_atomic T, bool TWaitable>
+synchronized_atomic<T, TWaitable> &synchronized_atomic<T, TWaitable>::operator=(const synchronized_atomic &other) noexcept
+{
+    if (this != &other)
+    {
+        store(other.load());
+    }
+    return *this;
+}
+
+template <lock_free_atomic T, bool TWaitable>
+T synchronized_atomic<T, TWaitable>::load(std::memory_order order) const noexcept
+{
+    return instance_.load(order);
+}
+
+template <lock_free_atomic T, bool TWaitable>
+void synchronized_atomic<T, TWaitable>::store(T instance, std::memory_order order) noexcept
+{
+    instance_.store(instance, order);
+    notify_waiters();
+}
+
+template <lock_free_atomic T, bool TWaitable>
+T synchronized_atomic<T, TWaitable>::exchange(T instance, std::memory_order order) noexcept
+{
+    const T replaced = instance_.exchange(instance, order);
+    notify_waiters();
+    return replaced;
+}
+
+template <lock_free_atomic T, bool TWaitable>
+bool synchronized_atomic<T, TWaitable>::compare_exchange(T &expected, T desired, std::memory_order order) noexcept
+{
+    if (!instance_.compare_exchange_strong(expected, desired, order))
+    {
+        return false;
+    }
+    notify_waiters();
+    return true;
+}
+
+template <lock_free_atomic T, bool TWaitable>
+template <typename TFunction>
+    requires std::is_invocable_r_v<T, TFunction &, T>
+T synchronized_atomic<T, TWaitable>::update(TFunction &&function, std::memory_order order)
+{
+    T current = instance_.load(std::memory_order_relaxed);
+    T desired = std::invoke(function, current);
+    // On failure the current instance is reloaded
+    while (!instance_.compare_exchange_weak(current, desired, order, std::memory_order_relaxed))
+    {
+        desired = std::invoke(function, current);
+    }
+    notify_waiters();
+    return desired;
+}
+
+template <lock_free_atomic T, bool TWaitable>
+void synchronized_atomic<T, TWaitable>::wait(T old, std::memory_order order) const noexcept
+    requires TWaitable
+{
+    instance_.wait(old, order);
+}
+
+template <lock_free_atomic T, bool TWaitable>
+void synchronized_atomic<T, TWaitable>::notify_waiters() noexcept
+{
+    if constexpr (TWaitable)
+    {
+        instance_.notify_all();
+    }
+}
+
+}  // namespace saam
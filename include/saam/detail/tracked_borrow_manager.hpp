@@ -5,28 +5,49 @@
 #pragma once
 
 #include <saam/detail/borrow_manager_traits.hpp>
+#include <saam/detail/raw_stacktrace.hpp>
+#include <saam/detail/stacktrace_site_registry.hpp>
+#include <saam/detail/striped_mutex.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <functional>
 #include <mutex>
 #include <stacktrace>
 #include <utility>
+#include <vector>
 
-namespace saam
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
 // The user must define this function to handle the dangling reference situation.
 // After this function, dangling reference(s) exist in the process, so the memory is possibly going to be corrupted soon.
-// This function is called for each dangling reference detected.
+// This function is called once for each creation site of the dangling references, with the number of the dangling references created there.
 // Therefore, after returning from this function, the process will be aborted.
-using dangling_reference_panic_t = std::function<void(const std::type_info &var_type,
+// The creation stack is empty for the dangling references, that were not sampled for stacktrace capture.
+using tracked_dangling_reference_panic_t = std::function<void(const std::type_info &var_type,
                                                       void *var_instance,
                                                       const std::stacktrace &var_destruction_stack,
-                                                      std::size_t dangling_ref_index,
-                                                      const std::stacktrace &dangling_ref_creation_stack)>;
-inline dangling_reference_panic_t dangling_reference_panic;
+                                                      std::size_t num_dangling_references,
+                                                      const raw_stacktrace &dangling_ref_creation_stack)>;
+inline tracked_dangling_reference_panic_t tracked_dangling_reference_panic;
 
-class tracked_borrow_manager
+// The creation stack is captured for 1 in N reference registrations (N=1 captures all of them, N=0 captures none).
+// All references are tracked regardless of the sampling, so the dangling reference detection stays exact.
+inline std::atomic<std::size_t> creation_stack_sampling_rate = 1;
+
+// The live references of a var, that were created at the same site
+struct borrow_site_census
+{
+    // Empty for the references, that were not sampled for stacktrace capture
+    const raw_stacktrace *creation_stack = nullptr;
+    std::size_t num_references = 0;
+};
+
+template <typename TLockPolicy>
+class basic_tracked_borrow_manager
 {
   public:
     class ref_base
@@ -37,7 +58,7 @@ class tracked_borrow_manager
             return borrow_manager_ != nullptr;
         }
 
-        [[nodiscard]] tracked_borrow_manager *borrow_manager() const noexcept
+        [[nodiscard]] basic_tracked_borrow_manager *borrow_manager() const noexcept
         {
             return borrow_manager_;
         }
@@ -45,7 +66,7 @@ class tracked_borrow_manager
       protected:
         ref_base() = default;
 
-        ref_base(tracked_borrow_manager *borrow_manager) :
+        ref_base(basic_tracked_borrow_manager *borrow_manager) :
             borrow_manager_(borrow_manager)
         {
             register_self();
@@ -123,10 +144,12 @@ class tracked_borrow_manager
                 return;
             }
 
-            borrow_manager_->register_ref(*this);
-
-            // The linked_ref is now attached to a var, let's capture the stacktrace of this moment
-            stacktrace_ = std::stacktrace::current();
+            // The linked_ref is attached to a var in this moment, so the stacktrace is captured now.
+            // It is interned before the locking, the site is stored under the lock, as the census reads it from other threads.
+            const auto creation_site = is_sampled_capture(creation_stack_sampling_rate.load(std::memory_order_relaxed))
+                                           ? detail::stacktrace_site_registry::intern(raw_stacktrace::current())
+                                           : no_stacktrace_site;
+            borrow_manager_->register_ref(*this, creation_site);
         }
 
         void unregister_self()
@@ -136,46 +159,74 @@ class tracked_borrow_manager
                 return;
             }
 
+            // The linked_ref is detached from any var, the stacktrace is reset under the lock
             borrow_manager_->unregister_ref(*this);
             borrow_manager_ = nullptr;
-
-            // The linked_ref is detached from any var, so the stacktrace is not relevant anymore
-            stacktrace_ = std::stacktrace();
         }
 
       private:
-        friend class tracked_borrow_manager;
+        friend class basic_tracked_borrow_manager;
 
+        // The chain is doubly linked, so a ref can be detached or replaced without walking the chain
+        ref_base *previous_ = nullptr;
         ref_base *next_ = nullptr;
-        std::stacktrace stacktrace_;
-        tracked_borrow_manager *borrow_manager_ = nullptr;
+        // The creation stacktrace is interned, the refs created at the same place share it
+        stacktrace_site_id creation_site_ = no_stacktrace_site;
+        basic_tracked_borrow_manager *borrow_manager_ = nullptr;
     };
 
     // reference management is copied/moved, each var manages its own references
     // regardless if it was assigned a another T instance
-    tracked_borrow_manager(const tracked_borrow_manager &other) = delete;
-    tracked_borrow_manager(tracked_borrow_manager &&other) noexcept = delete;
-    tracked_borrow_manager &operator=(const tracked_borrow_manager &other) = delete;
-    tracked_borrow_manager &operator=(tracked_borrow_manager &&other) noexcept = delete;
-    ~tracked_borrow_manager() = default;
+    basic_tracked_borrow_manager(const basic_tracked_borrow_manager &other) = delete;
+    basic_tracked_borrow_manager(basic_tracked_borrow_manager &&other) noexcept = delete;
+    basic_tracked_borrow_manager &operator=(const basic_tracked_borrow_manager &other) = delete;
+    basic_tracked_borrow_manager &operator=(basic_tracked_borrow_manager &&other) noexcept = delete;
+    ~basic_tracked_borrow_manager() = default;
+
+    // Number of the live references, the chain is walked under the lock
+    [[nodiscard]] std::size_t num_borrows() const noexcept
+    {
+        std::lock_guard guard(lock_policy_.get_mutex(this));
+        return num_borrows_locked();
+    }
+
+    // The live references grouped by their creation sites, e.g. to find the code that pins a var
+    [[nodiscard]] std::vector<borrow_site_census> borrow_census() const
+    {
+        std::lock_guard guard(lock_policy_.get_mutex(this));
+        return census_of_chain();
+    }
 
     void verify_dangling_references(const std::type_info &var_type, void *var_instance) const noexcept
     {
-        std::lock_guard guard(mutex_);
+        std::lock_guard guard(lock_policy_.get_mutex(this));
 
         const bool destroyed_with_active_references = ref_chain_root_ != nullptr;
         if (destroyed_with_active_references)
         {
-            std::size_t dangling_ref_index = 0;
-            std::stacktrace var_destruction_stack = std::stacktrace::current();
-            for (auto *current_link = ref_chain_root_; current_link != nullptr; current_link = current_link->next_)
+            if (tracked_dangling_reference_panic)
             {
-                const auto &ref_stacktrace = current_link->stacktrace_;
-                if (dangling_reference_panic)
+                std::stacktrace var_destruction_stack = std::stacktrace::current();
+                std::vector<borrow_site_census> census;
+                try
                 {
-                    dangling_reference_panic(var_type, var_instance, var_destruction_stack, dangling_ref_index, ref_stacktrace);
+                    census = census_of_chain();
+                }
+                catch (...)
+                {
+                    // Without memory for the census, all the references are reported without their creation stacktraces
+                    census.clear();
+                }
+
+                if (census.empty())
+                {
+                    tracked_dangling_reference_panic(var_type, var_instance, var_destruction_stack, num_borrows_locked(),
+                                                     detail::stacktrace_site_registry::site(no_stacktrace_site));
+                }
+                for (const auto &site : census)
+                {
+                    tracked_dangling_reference_panic(var_type, var_instance, var_destruction_stack, site.num_references, *site.creation_stack);
                 }
-                dangling_ref_index++;
             }
 
             abort();
@@ -183,63 +234,118 @@ class tracked_borrow_manager
     }
 
   private:
-    tracked_borrow_manager() = default;
+    basic_tracked_borrow_manager() = default;
+
+    // The lock is held
+    std::size_t num_borrows_locked() const noexcept
+    {
+        std::size_t num_references = 0;
+        for (auto *current_link = ref_chain_root_; current_link != nullptr; current_link = current_link->next_)
+        {
+            num_references++;
+        }
+        return num_references;
+    }
 
-    void register_ref(ref_base &ref)
+    // The lock is held. The sites are listed in the order of their first interning, the unsampled refs first.
+    std::vector<borrow_site_census> census_of_chain() const
     {
-        std::lock_guard guard(mutex_);
+        std::vector<stacktrace_site_id> creation_sites;
+        for (auto *current_link = ref_chain_root_; current_link != nullptr; current_link = current_link->next_)
+        {
+            creation_sites.push_back(current_link->creation_site_);
+        }
+        std::ranges::sort(creation_sites);
+
+        std::vector<borrow_site_census> census;
+        for (auto site = creation_sites.begin(); site != creation_sites.end();)
+        {
+            const auto site_end = std::ranges::upper_bound(site, creation_sites.end(), *site);
+            census.push_back({.creation_stack = &detail::stacktrace_site_registry::site(*site),
+                              .num_references = static_cast<std::size_t>(site_end - site)});
+            site = site_end;
+        }
+        return census;
+    }
+
+    void register_ref(ref_base &ref, stacktrace_site_id creation_site)
+    {
+        std::lock_guard guard(lock_policy_.get_mutex(this));
+        ref.creation_site_ = creation_site;
         // Attach the new link to the beginning of the chain - we saved a walk to the end of the chain
         // Moreover, it is likely that new refs will die earlier than old ones
+        ref.previous_ = nullptr;
         ref.next_ = ref_chain_root_;
+        if (ref_chain_root_ != nullptr)
+        {
+            ref_chain_root_->previous_ = &ref;
+        }
         ref_chain_root_ = &ref;
     }
 
     void unregister_ref(ref_base &linked_ref_to_detach)
     {
-        std::lock_guard guard(mutex_);
+        std::lock_guard guard(lock_policy_.get_mutex(this));
 
-        auto *previous_link_ptr = get_previous_ptr_in_chain(linked_ref_to_detach);
-        *previous_link_ptr = (*previous_link_ptr)->next_;
+        *get_pointer_to_link(linked_ref_to_detach) = linked_ref_to_detach.next_;
+        if (linked_ref_to_detach.next_ != nullptr)
+        {
+            linked_ref_to_detach.next_->previous_ = linked_ref_to_detach.previous_;
+        }
+        linked_ref_to_detach.previous_ = nullptr;
+        linked_ref_to_detach.next_ = nullptr;
+        linked_ref_to_detach.creation_site_ = no_stacktrace_site;
     }
 
     // Atomically replace `from` with `to` in the chain under a single lock,
-    // preserving `from`'s chain position and creation stacktrace.
+    // preserving `from`'s chain position and creation site.
     // On return `from` is fully detached (borrow_manager_ == nullptr).
     void transfer_ref(ref_base &from, ref_base &to) noexcept
     {
-        std::lock_guard guard(mutex_);
-        auto *previous_link_ptr = get_previous_ptr_in_chain(from);
+        std::lock_guard guard(lock_policy_.get_mutex(this));
+        *get_pointer_to_link(from) = &to;
+        to.previous_ = from.previous_;
         to.next_ = from.next_;
-        to.stacktrace_ = std::move(from.stacktrace_);
-        *previous_link_ptr = &to;
+        if (to.next_ != nullptr)
+        {
+            to.next_->previous_ = &to;
+        }
+        to.creation_site_ = from.creation_site_;
+        from.previous_ = nullptr;
         from.next_ = nullptr;
         from.borrow_manager_ = nullptr;
     }
 
-    ref_base **get_previous_ptr_in_chain(ref_base &ref_to_detach)
+    // Returns the pointer in the chain that points to the given ref: either the root or the next pointer of the previous ref
+    ref_base **get_pointer_to_link(ref_base &linked_ref)
     {
-        auto *previous_link_ptr = &ref_chain_root_;
-        while (true)
-        {
-            ref_base *current_link = *previous_link_ptr;
-            // Sanity check - the linked_ref to detach must be in the chain
-            assert(current_link != nullptr);
+        // Sanity check - the linked_ref must be in the chain
+        assert(linked_ref.previous_ != nullptr || ref_chain_root_ == &linked_ref);
+        assert(linked_ref.previous_ == nullptr || linked_ref.previous_->next_ == &linked_ref);
 
-            const bool link_to_detach_found = current_link == &ref_to_detach;
-            if (link_to_detach_found)
-            {
-                return previous_link_ptr;
-            }
-
-            previous_link_ptr = &current_link->next_;
-        }
+        return linked_ref.previous_ == nullptr ? &ref_chain_root_ : &linked_ref.previous_->next_;
     }
 
     template <underlying_type TOther, borrow_manager TOtherBorrowManager>
     friend class var;
 
-    mutable std::mutex mutex_;
+    template <borrow_manager TOtherBorrowManager>
+    friend class statistics_borrow_manager;
+
+    // if TLockPolicy has no state, this member is optimized away
+#ifdef _MSC_VER
+    [[msvc::no_unique_address]]
+#else
+    [[no_unique_address]]
+#endif
+    TLockPolicy lock_policy_;
     ref_base *ref_chain_root_ = nullptr;
 };
 
+// Each var owns its mutex, so borrows of different vars never contend
+using tracked_borrow_manager = basic_tracked_borrow_manager<owned_mutex_lock_policy>;
+
+// The vars share the mutexes of a global lock stripe table, the per var overhead is only the chain root pointer
+using striped_tracked_borrow_manager = basic_tracked_borrow_manager<striped_mutex_lock_policy>;
+
 }  // namespace saam
@@ -6,12 +6,15 @@
 
 #include <saam/detail/borrow_manager_traits.hpp>
 
-namespace saam
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
 class unchecked_borrow_manager
 {
   public:
+    // Stateless, so the var can always be relocated bitwise (see relocate.hpp)
+    static constexpr bool is_relocatable_when_unborrowed = true;
+
     // For the manager to be able to manage the reference, the reference must derived from this base class.
     // This manager specific base class adds everything to a reference that is needed for its management.
     class ref_base
@@ -55,6 +58,9 @@ class unchecked_borrow_manager
 
     template <underlying_type TOther, borrow_manager TOtherBorrowManager>
     friend class var;
+
+    template <borrow_manager TOtherBorrowManager>
+    friend class statistics_borrow_manager;
 };
 
 }  // namespace saam
@@ -6,12 +6,15 @@
 
 #include <saam/detail/constructor_destructor_traits.hpp>
 #include <saam/detail/unchecked_borrow_manager.hpp>
+#include <saam/scoped_ref.hpp>
 
+#include <functional>
 #include <memory>
+#include <new>
 #include <type_traits>
 #include <utility>
 
-namespace saam
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
 template <underlying_type T, borrow_manager TBorrowManager>
@@ -231,6 +234,34 @@ ref<T, TBorrowManager> var<T, TBorrowManager>::operator->() const noexcept
     return borrow();
 }
 
+template <underlying_type T, borrow_manager TBorrowManager>
+template <typename TFunction>
+    requires std::is_invocable_v<TFunction, scoped_ref<T>>
+decltype(auto) var<T, TBorrowManager>::with(TFunction &&function) const
+{
+    // The scoped_ref is not registered, a copy of it that escapes the call would dangle unnoticed after the single borrow is released
+    static_assert(!std::is_convertible_v<scoped_ref<T>, std::remove_cvref_t<std::invoke_result_t<TFunction, scoped_ref<T>>>>,
+                  "with: the result outlives the single borrow, it must not hold the scoped_ref (return a ref instead)");
+
+    // The single borrow lives until the function returns, the function uses only child borrows of it
+    const auto pinned = borrow();
+    return std::invoke(std::forward<TFunction>(function), scoped_ref<T>(pinned));
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+std::size_t var<T, TBorrowManager>::num_borrows() const noexcept
+    requires has_num_borrows<TBorrowManager>
+{
+    return borrow_manager_.num_borrows();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+auto var<T, TBorrowManager>::borrow_census() const
+    requires has_borrow_census<TBorrowManager>
+{
+    return borrow_manager_.borrow_census();
+}
+
 template <underlying_type T, borrow_manager TBorrowManager>
 [[nodiscard]] bool var<T, TBorrowManager>::operator==(const T &other) const noexcept
 {
@@ -248,6 +279,11 @@ template <underlying_type T, borrow_manager TBorrowManager>
 template <underlying_type T, borrow_manager TBorrowManager>
 void var<T, TBorrowManager>::call_post_constructor() noexcept
 {
+    if constexpr (has_bind_var_type<TBorrowManager, T>)
+    {
+        borrow_manager_.template bind_var_type<T>(this);
+    }
+
     if constexpr (has_post_constructor<T, TBorrowManager>)
     {
         static_assert(has_noexcept_post_constructor<T, TBorrowManager>, "post_constructor() must be noexcept");
@@ -262,6 +298,12 @@ void var<T, TBorrowManager>::call_post_constructor() noexcept
     }
 }
 
+template <underlying_type T, borrow_manager TBorrowManager>
+void var<T, TBorrowManager>::renew_borrow_manager() noexcept
+{
+    ::new (static_cast<void *>(std::addressof(borrow_manager_))) TBorrowManager();
+}
+
 template <underlying_type T, borrow_manager TBorrowManager>
 void var<T, TBorrowManager>::call_post_assignment() noexcept
 {
@@ -0,0 +1,137 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/var_pool.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <utility>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+template <underlying_type T, borrow_manager TBorrowManager>
+var_pool<T, TBorrowManager>::var_pool(std::size_t slab_size) :
+    slab_size_(std::max<std::size_t>(slab_size, 1))
+{
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+var_pool<T, TBorrowManager>::~var_pool()
+{
+    clear();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+template <typename... Args>
+typename var_pool<T, TBorrowManager>::var_t &var_pool<T, TBorrowManager>::emplace(Args &&...args)
+{
+    slot *free_slot = acquire_slot();
+    try
+    {
+        auto *instance = ::new (static_cast<void *>(free_slot->storage)) var_t(std::in_place, std::forward<Args>(args)...);
+        free_slot->occupied = true;
+        size_++;
+        return *instance;
+    }
+    catch (...)
+    {
+        free_slot->next_free = std::exchange(free_list_, free_slot);
+        throw;
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_pool<T, TBorrowManager>::destroy(var_t &var) noexcept
+{
+    auto *occupied_slot = reinterpret_cast<slot *>(&var);
+    assert(occupied_slot->occupied && "The var is not in the pool, or it is already destroyed");
+
+    var.~var_t();
+    occupied_slot->occupied = false;
+    occupied_slot->next_free = std::exchange(free_list_, occupied_slot);
+    size_--;
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_pool<T, TBorrowManager>::clear() noexcept
+{
+    // One pass in the address order, the borrow managers are checked by the destructors of the vars
+    for (std::size_t slab_index = 0; slab_index < slabs_.size() && size_ > 0; slab_index++)
+    {
+        const std::size_t used = slab_index + 1 == slabs_.size() ? used_of_last_slab_ : slab_size_;
+        for (std::size_t slot_index = 0; slot_index < used; slot_index++)
+        {
+            slot &current = slabs_[slab_index][slot_index];
+            if (current.occupied)
+            {
+                current.get().~var_t();
+                current.occupied = false;
+                size_--;
+            }
+        }
+    }
+
+    // All slots are free again, the slabs are reused from the beginning
+    free_list_ = nullptr;
+    for (auto slab = slabs_.rbegin(); slab != slabs_.rend(); ++slab)
+    {
+        const std::size_t used = slab == slabs_.rbegin() ? used_of_last_slab_ : slab_size_;
+        for (std::size_t slot_index = used; slot_index-- > 0;)
+        {
+            (*slab)[slot_index].next_free = std::exchange(free_list_, &(*slab)[slot_index]);
+        }
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_pool<T, TBorrowManager>::shrink_to_fit()
+{
+    if (size_ == 0)
+    {
+        slabs_.clear();
+        free_list_ = nullptr;
+        used_of_last_slab_ = 0;
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+std::size_t var_pool<T, TBorrowManager>::size() const noexcept
+{
+    return size_;
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+std::size_t var_pool<T, TBorrowManager>::capacity() const noexcept
+{
+    return slabs_.size() * slab_size_;
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+typename var_pool<T, TBorrowManager>::var_t &var_pool<T, TBorrowManager>::slot::get() noexcept
+{
+    return *std::launder(reinterpret_cast<var_t *>(storage));
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+typename var_pool<T, TBorrowManager>::slot *var_pool<T, TBorrowManager>::acquire_slot()
+{
+    if (free_list_ != nullptr)
+    {
+        return std::exchange(free_list_, free_list_->next_free);
+    }
+
+    if (slabs_.empty() || used_of_last_slab_ == slab_size_)
+    {
+        // Default initialized, the storage of the vars is not zeroed
+        slabs_.push_back(std::unique_ptr<slot[]>(new slot[slab_size_]));
+        used_of_last_slab_ = 0;
+    }
+    return &slabs_.back()[used_of_last_slab_++];
+}
+
+}  // namespace saam
@@ -0,0 +1,282 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/var_vector.hpp>
+
+#include <cassert>
+#include <cstdlib>
+#include <utility>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+template <underlying_type T, borrow_manager TBorrowManager>
+var_vector<T, TBorrowManager>::var_vector(std::size_t count) :
+    values_(count)
+{
+    fit_borrow_managers();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+var_vector<T, TBorrowManager>::var_vector(std::initializer_list<T> values) :
+    values_(values)
+{
+    fit_borrow_managers();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+var_vector<T, TBorrowManager>::var_vector(const var_vector &other) :
+    values_(other.values_)
+{
+    fit_borrow_managers();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+var_vector<T, TBorrowManager>::var_vector(var_vector &&other) noexcept :
+    // The buffer and the borrow managers are taken over, so the borrows of the other vector stay valid
+    values_(std::move(other.values_)),
+    borrow_managers_(std::move(other.borrow_managers_)),
+    borrow_managers_capacity_(std::exchange(other.borrow_managers_capacity_, 0))
+{
+    other.values_.clear();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+var_vector<T, TBorrowManager> &var_vector<T, TBorrowManager>::operator=(const var_vector &other)
+{
+    if (this != &other)
+    {
+        verify_not_borrowed(0);
+        values_ = other.values_;
+        fit_borrow_managers();
+    }
+    return *this;
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+var_vector<T, TBorrowManager> &var_vector<T, TBorrowManager>::operator=(var_vector &&other) noexcept
+{
+    if (this != &other)
+    {
+        verify_not_borrowed(0);
+        values_ = std::move(other.values_);
+        other.values_.clear();
+        borrow_managers_ = std::move(other.borrow_managers_);
+        borrow_managers_capacity_ = std::exchange(other.borrow_managers_capacity_, 0);
+    }
+    return *this;
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+var_vector<T, TBorrowManager>::~var_vector()
+{
+    if constexpr (is_checked)
+    {
+        for (std::size_t index = 0; index < values_.size(); index++)
+        {
+            borrow_managers_[index].verify_dangling_references(typeid(T), &values_[index]);
+        }
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+ref<T, TBorrowManager> var_vector<T, TBorrowManager>::borrow(std::size_t index) const noexcept
+{
+    assert(index < values_.size());
+    T &instance = const_cast<T &>(values_[index]);
+    if constexpr (is_checked)
+    {
+        return {instance, &borrow_managers_[index]};
+    }
+    else
+    {
+        return {instance, nullptr};
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+ref<T, TBorrowManager> var_vector<T, TBorrowManager>::operator[](std::size_t index) const noexcept
+{
+    return borrow(index);
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+template <typename TFunction>
+    requires std::is_invocable_v<TFunction, std::span<T>>
+decltype(auto) var_vector<T, TBorrowManager>::with(TFunction &&function) const
+{
+    struct view_scope
+    {
+        explicit view_scope(std::atomic<std::size_t> &views) :
+            views_(views)
+        {
+            views_.fetch_add(1, std::memory_order_relaxed);
+        }
+        view_scope(const view_scope &) = delete;
+        view_scope &operator=(const view_scope &) = delete;
+        ~view_scope()
+        {
+            views_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        std::atomic<std::size_t> &views_;
+    };
+
+    [[maybe_unused]] const view_scope scope(views_);
+    auto &values = const_cast<std::vector<T> &>(values_);
+    return std::invoke(std::forward<TFunction>(function), std::span<T>(values.data(), values.size()));
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+template <typename... Args>
+ref<T, TBorrowManager> var_vector<T, TBorrowManager>::emplace_back(Args &&...args)
+{
+    verify_not_borrowed_before_growing_to(values_.size() + 1);
+    values_.emplace_back(std::forward<Args>(args)...);
+    fit_borrow_managers();
+    return borrow(values_.size() - 1);
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_vector<T, TBorrowManager>::push_back(const T &value)
+{
+    verify_not_borrowed_before_growing_to(values_.size() + 1);
+    values_.push_back(value);
+    fit_borrow_managers();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_vector<T, TBorrowManager>::push_back(T &&value)
+{
+    verify_not_borrowed_before_growing_to(values_.size() + 1);
+    values_.push_back(std::move(value));
+    fit_borrow_managers();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_vector<T, TBorrowManager>::pop_back() noexcept
+{
+    assert(!values_.empty());
+    verify_not_borrowed(values_.size() - 1);
+    values_.pop_back();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_vector<T, TBorrowManager>::erase(std::size_t index) noexcept
+{
+    assert(index < values_.size());
+    // The borrow managers stay at their position: the ones of the moved elements are not borrowed
+    verify_not_borrowed(index);
+    values_.erase(values_.begin() + static_cast<std::ptrdiff_t>(index));
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_vector<T, TBorrowManager>::clear() noexcept
+{
+    verify_not_borrowed(0);
+    values_.clear();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_vector<T, TBorrowManager>::reserve(std::size_t capacity)
+{
+    if (capacity > values_.capacity())
+    {
+        verify_not_borrowed(0);
+        values_.reserve(capacity);
+        fit_borrow_managers();
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_vector<T, TBorrowManager>::resize(std::size_t size)
+{
+    if (size < values_.size())
+    {
+        verify_not_borrowed(size);
+    }
+    else
+    {
+        verify_not_borrowed_before_growing_to(size);
+    }
+    values_.resize(size);
+    fit_borrow_managers();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_vector<T, TBorrowManager>::shrink_to_fit()
+{
+    if (values_.size() < values_.capacity())
+    {
+        verify_not_borrowed(0);
+        values_.shrink_to_fit();
+        fit_borrow_managers();
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+std::size_t var_vector<T, TBorrowManager>::size() const noexcept
+{
+    return values_.size();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+std::size_t var_vector<T, TBorrowManager>::capacity() const noexcept
+{
+    return values_.capacity();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+bool var_vector<T, TBorrowManager>::empty() const noexcept
+{
+    return values_.empty();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_vector<T, TBorrowManager>::verify_not_borrowed(std::size_t first) const noexcept
+{
+    if constexpr (is_checked)
+    {
+        std::size_t borrowed_index = views_.load(std::memory_order_relaxed) == 0 ? values_.size() : npos;
+        for (std::size_t index = first; index < values_.size() && borrowed_index == values_.size(); index++)
+        {
+            if (borrow_managers_[index].is_borrowed())
+            {
+                borrowed_index = index;
+            }
+        }
+
+        if (borrowed_index != values_.size())
+        {
+            if (var_vector_borrowed_panic)
+            {
+                var_vector_borrowed_panic(typeid(T), borrowed_index);
+            }
+            abort();
+        }
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_vector<T, TBorrowManager>::verify_not_borrowed_before_growing_to(std::size_t size) const noexcept
+{
+    // Without a reallocation, the existing elements stay in place
+    verify_not_borrowed(size > values_.capacity() ? 0 : values_.size());
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void var_vector<T, TBorrowManager>::fit_borrow_managers()
+{
+    if constexpr (is_checked)
+    {
+        if (borrow_managers_capacity_ != values_.capacity())
+        {
+            borrow_managers_.reset(new TBorrowManager[values_.capacity()]);
+            borrow_managers_capacity_ = values_.capacity();
+        }
+    }
+}
+
+}  // namespace saam
@@ -0,0 +1,145 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/weak_ref.hpp>
+
+#include <cassert>
+#include <mutex>
+#include <utility>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+template <underlying_type T, borrow_manager TBorrowManager>
+weak_ref<T, TBorrowManager>::weak_ref(T *instance, TBorrowManager *borrow_manager) :
+    instance_(instance),
+    borrow_manager_(borrow_manager),
+    anchor_(borrow_manager->acquire_weak_anchor())
+{
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+template <underlying_type TOther>
+    requires std::is_convertible_v<TOther *, T *>
+weak_ref<T, TBorrowManager>::weak_ref(const var<TOther, TBorrowManager> &other) :
+    weak_ref(&const_cast<var<TOther, TBorrowManager> &>(other).instance_, &other.borrow_manager_)
+{
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+template <underlying_type TOther>
+    requires std::is_convertible_v<TOther *, T *>
+weak_ref<T, TBorrowManager>::weak_ref(const ref<TOther, TBorrowManager> &other) :
+    weak_ref(other.instance_, other.borrow_manager())
+{
+    assert(other.is_managed() && "weak_ref can observe only managed refs");
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+weak_ref<T, TBorrowManager>::weak_ref(const weak_ref &other) noexcept :
+    instance_(other.instance_),
+    borrow_manager_(other.borrow_manager_),
+    anchor_(other.anchor_)
+{
+    if (anchor_ != nullptr)
+    {
+        anchor_->acquire();
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+weak_ref<T, TBorrowManager>::weak_ref(weak_ref &&other) noexcept :
+    instance_(std::exchange(other.instance_, nullptr)),
+    borrow_manager_(std::exchange(other.borrow_manager_, nullptr)),
+    anchor_(std::exchange(other.anchor_, nullptr))
+{
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+template <underlying_type TOther>
+    requires std::is_convertible_v<TOther *, T *>
+weak_ref<T, TBorrowManager>::weak_ref(const weak_ref<TOther, TBorrowManager> &other) noexcept :
+    instance_(other.instance_),
+    borrow_manager_(other.borrow_manager_),
+    anchor_(other.anchor_)
+{
+    if (anchor_ != nullptr)
+    {
+        anchor_->acquire();
+    }
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+weak_ref<T, TBorrowManager> &weak_ref<T, TBorrowManager>::operator=(const weak_ref &other) noexcept
+{
+    if (this != &other)
+    {
+        weak_ref copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+weak_ref<T, TBorrowManager> &weak_ref<T, TBorrowManager>::operator=(weak_ref &&other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        instance_ = std::exchange(other.instance_, nullptr);
+        borrow_manager_ = std::exchange(other.borrow_manager_, nullptr);
+        anchor_ = std::exchange(other.anchor_, nullptr);
+    }
+    return *this;
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+weak_ref<T, TBorrowManager>::~weak_ref()
+{
+    reset();
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+std::optional<ref<T, TBorrowManager>> weak_ref<T, TBorrowManager>::lock() const
+{
+    if (anchor_ == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    // The destruction of the var closes its counter under the same lock, so the var cannot go away before it counts this borrow
+    const std::lock_guard lock(anchor_->mutex);
+    if (!anchor_->alive)
+    {
+        return std::nullopt;
+    }
+    return ref<T, TBorrowManager>(*instance_, borrow_manager_);
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+bool weak_ref<T, TBorrowManager>::expired() const
+{
+    if (anchor_ == nullptr)
+    {
+        return true;
+    }
+
+    const std::lock_guard lock(anchor_->mutex);
+    return !anchor_->alive;
+}
+
+template <underlying_type T, borrow_manager TBorrowManager>
+void weak_ref<T, TBorrowManager>::reset() noexcept
+{
+    if (anchor_ != nullptr)
+    {
+        std::exchange(anchor_, nullptr)->release();
+    }
+    instance_ = nullptr;
+    borrow_manager_ = nullptr;
+}
+
+}  // namespace saam
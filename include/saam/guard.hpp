@@ -4,76 +4,92 @@
 
 #pragma once
 
+#include <saam/detail/change_notifier.hpp>
+#include <saam/detail/guard_counter.hpp>
+#include <saam/lock_policy.hpp>
 #include <saam/safe_ref.hpp>
 
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
+#include <typeinfo>
 
-namespace saam
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
-template <typename T>
+// The user may define this function to handle a guard outliving its synchronized, the guard still holds the mutex of the destroyed one.
+// After returning from this function, the process will be aborted.
+using dangling_guard_panic_t = std::function<void(const std::type_info &synchronized_type, void *synchronized_instance)>;
+inline dangling_guard_panic_t dangling_guard_panic;
+
+template <typename T, lock_policy TLockPolicy>
     requires(!std::is_const_v<T>)
 class synchronized;
 
+template <typename T, lock_policy TLockPolicy>
+class upgrade_guard;
+
 // Provides access to the protected instance of T, which is protected by a synchronized.
 // The guard is expected to be a short living object, its lifetime is often bound to scope or it is a temporal variable. It is not
 // supposed to be stored for a long time.
-template <typename T>
+// The lock policy must be the same as the one of the synchronized.
+template <typename T, lock_policy TLockPolicy = default_lock_policy>
 class guard
 {
   public:
-    using lock_t = std::unique_lock<std::shared_mutex>;
+    using lock_t = typename TLockPolicy::unique_lock_t;
     using value_t = T;
 
     // Unique guard is unique, after the copy we would have two unique guards, which is not unique anymore
-    guard(const guard<T> &other) = delete;
+    guard(const guard<T, TLockPolicy> &other) = delete;
 
     // Conversion move constructor
     template <typename TOther>
         requires (std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-    guard(guard<TOther> &&other) noexcept;
+    guard(guard<TOther, TLockPolicy> &&other) noexcept;
 
     // No conversion upgrade (immutable to mutable) move constructor.
     template <typename TOther>
         requires std::is_convertible_v<TOther *, T *>
-    guard(guard<const TOther> &&other) noexcept = delete;
+    guard(guard<const TOther, TLockPolicy> &&other) noexcept = delete;
 
     // The conversion move constructor does not cover the move constructor, so we need to implement it explicitly
-    guard(guard<T> &&other) noexcept;
+    guard(guard<T, TLockPolicy> &&other) noexcept;
 
     // No upgrade (immutable to mutable) move constructor.
-    guard(guard<const T> &&other) noexcept = delete;
+    guard(guard<const T, TLockPolicy> &&other) noexcept = delete;
 
     // Conversion copy construction from synchronized
     template <typename TOther>
         requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-    guard(synchronized<TOther> &other) noexcept;
+    guard(synchronized<TOther, TLockPolicy> &other) noexcept;
 
     // Unique guard is unique, after the assigment we would have two unique guards
-    guard &operator=(const guard<T> &other) = delete;
+    guard &operator=(const guard<T, TLockPolicy> &other) = delete;
 
     // Conversion move assignment operator from guard
     template <typename TOther>
         requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-    guard &operator=(guard<TOther> &&other) noexcept;
+    guard &operator=(guard<TOther, TLockPolicy> &&other) noexcept;
 
     // No conversion upgrade (immutable to mutable) move assignment.
     template <typename TOther>
         requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-    guard &operator=(guard<const TOther> &&other) noexcept = delete;
+    guard &operator=(guard<const TOther, TLockPolicy> &&other) noexcept = delete;
 
-    guard &operator=(guard<T> &&other) noexcept;
+    guard &operator=(guard<T, TLockPolicy> &&other) noexcept;
 
     // No upgrade (immutable to mutable) move assignment.
-    guard &operator=(guard<const T> &&other) noexcept = delete;
+    guard &operator=(guard<const T, TLockPolicy> &&other) noexcept = delete;
 
     // Conversion assignment operator from synchronized
     template <typename TOther>
         requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-    guard &operator=(synchronized<TOther> &other) noexcept;
+    guard &operator=(synchronized<TOther, TLockPolicy> &other) noexcept;
 
-    ~guard() = default;
+    // Notifies the waiters of the synchronized (commence_when), if the protected instance was accessed mutably
+    ~guard();
 
     // Equality of guards, not the underlying objects --> similar to smart pointers
     // As the guard is unique, there cannot be two guards to the same synchronized instance.
@@ -102,105 +118,127 @@ class guard
     // Cast to T pointer
     [[nodiscard]] explicit operator T *() const noexcept;
 
+    // Turns into an immutable guard without unlocking in between, so no other writer can intervene
+    [[nodiscard]] guard<const T, TLockPolicy> downgrade() &&
+        requires upgradable_lock_policy<TLockPolicy>;
+
   private:
-    template <typename TOther>
+    template <typename TOther, lock_policy TOtherLockPolicy>
         requires(!std::is_const_v<TOther>)
     friend class synchronized;
 
-    template <typename TOther>
+    template <typename TOther, lock_policy TOtherLockPolicy>
     friend class guard;
 
+    template <typename TOther, lock_policy TOtherLockPolicy>
+    friend class upgrade_guard;
+
     template <typename TOther>
         requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-    guard(ref<TOther> protected_instance, lock_t lock) noexcept;
-
+    guard(TOther *protected_instance, lock_t lock, detail::guard_token<> token) noexcept;
+
+    // Releases the lock, and notifies the waiters of the synchronized, if the protected instance was accessed mutably
+    void release_and_notify() noexcept;
+
+    // Counts the guard in its synchronized, it is destroyed after the unlock
+#ifdef _MSC_VER
+    [[msvc::no_unique_address]]
+#else
+    [[no_unique_address]]
+#endif
+    detail::guard_token<> token_;
     lock_t lock_;
-    // track the protected instance via a ref to detect the destruction of the synchronized instance
-    ref<T> protected_instance_;
+    // Raw pointer, the held lock protects it: the synchronized verifies at its destruction that none of its guards is alive
+    T *protected_instance_ = nullptr;
+    // Any mutable access counts as a modification, the waiters recheck their predicates anyway
+    mutable bool modified_ = false;
 
-    template <typename... TOther>
-    friend auto commence_all(synchronized<std::remove_const_t<TOther>> &...syncs);
+    template <typename... TOther, lock_policy... TOtherLockPolicy>
+    friend auto commence_all(synchronized<std::remove_const_t<TOther>, TOtherLockPolicy> &...syncs);
 };
 
 // The underlying lock is a shared lock for const access, so a separate implementation is needed.
-template <typename T>
-class guard<const T>
+// With an exclusive lock policy the lock is exclusive, and the guard cannot be copied.
+template <typename T, lock_policy TLockPolicy>
+class guard<const T, TLockPolicy>
 {
   public:
-    using lock_t = std::shared_lock<std::shared_mutex>;
+    using lock_t = typename TLockPolicy::shared_lock_t;
     using value_t = const T;
 
-    // Conversion copy constructor
+    // Conversion copy constructor, only a shared lock can be copied
     template <typename TOther>
-        requires std::is_convertible_v<TOther *, const T *>
-    guard(const guard<const TOther> &other) noexcept;
+        requires(std::is_convertible_v<TOther *, const T *> && TLockPolicy::is_shared)
+    guard(const guard<const TOther, TLockPolicy> &other) noexcept;
 
     // No conversion downgrade (mutable to immutable) copy constructor.
     template <typename TOther>
         requires std::is_convertible_v<TOther *, const T *>
-    guard(const guard<TOther> &other) noexcept = delete;
+    guard(const guard<TOther, TLockPolicy> &other) noexcept = delete;
 
     // The conversion copy constructor does not cover the copy constructor, so we need to implement it explicitly
-    guard(const guard<const T> &other) noexcept;
+    guard(const guard<const T, TLockPolicy> &other) noexcept
+        requires(TLockPolicy::is_shared);
 
     // No downgrade (mutable to immutable) copy constructor.
-    guard(const guard<T> &other) noexcept = delete;
+    guard(const guard<T, TLockPolicy> &other) noexcept = delete;
 
     // Conversion move constructor
     template <typename TOther>
         requires std::is_convertible_v<TOther *, const T *>
-    guard(guard<const TOther> &&other) noexcept;
+    guard(guard<const TOther, TLockPolicy> &&other) noexcept;
 
     // No conversion downgrade (mutable to immutable) move constructor.
     template <typename TOther>
         requires std::is_convertible_v<TOther *, const T *>
-    guard(guard<TOther> &&other) noexcept = delete;
+    guard(guard<TOther, TLockPolicy> &&other) noexcept = delete;
 
     // The conversion move constructor does not cover the move constructor, so we need to implement it explicitly
-    guard(guard<const T> &&other) noexcept;
+    guard(guard<const T, TLockPolicy> &&other) noexcept;
 
     // No downgrade (mutable to immutable) move constructor.
-    guard(guard<T> &&other) noexcept = delete;
+    guard(guard<T, TLockPolicy> &&other) noexcept = delete;
 
     // Conversion copy construction from synchronized
     template <typename TOther>
         requires(std::is_convertible_v<TOther *, const T *> && !std::is_const_v<TOther>)
-    guard(const synchronized<TOther> &other) noexcept;
+    guard(const synchronized<TOther, TLockPolicy> &other) noexcept;
 
-    // Conversion copy assignment operator from guard
+    // Conversion copy assignment operator from guard, only a shared lock can be copied
     template <typename TOther>
-        requires std::is_convertible_v<TOther *, const T *>
-    guard &operator=(const guard<const TOther> &other);
+        requires(std::is_convertible_v<TOther *, const T *> && TLockPolicy::is_shared)
+    guard &operator=(const guard<const TOther, TLockPolicy> &other);
 
     // No conversion downgrade (mutable to immutable) copy assignment.
     template <typename TOther>
         requires std::is_convertible_v<TOther *, const T *>
-    guard &operator=(const guard<TOther> &other) = delete;
+    guard &operator=(const guard<TOther, TLockPolicy> &other) = delete;
 
-    guard &operator=(const guard<const T> &other);
+    guard &operator=(const guard<const T, TLockPolicy> &other)
+        requires(TLockPolicy::is_shared);
 
     // No downgrade (mutable to immutable) copy assignment.
-    guard &operator=(const guard<T> &other) = delete;
+    guard &operator=(const guard<T, TLockPolicy> &other) = delete;
 
     // Conversion move assignment operator from guard
     template <typename TOther>
         requires std::is_convertible_v<TOther *, const T *>
-    guard &operator=(guard<const TOther> &&other) noexcept;
+    guard &operator=(guard<const TOther, TLockPolicy> &&other) noexcept;
 
     // No conversion downgrade (mutable to immutable) move assignment.
     template <typename TOther>
         requires std::is_convertible_v<TOther *, const T *>
-    guard &operator=(guard<TOther> &&other) noexcept = delete;
+    guard &operator=(guard<TOther, TLockPolicy> &&other) noexcept = delete;
 
-    guard &operator=(guard<const T> &&other) noexcept;
+    guard &operator=(guard<const T, TLockPolicy> &&other) noexcept;
 
     // No downgrade (mutable to immutable) move assignment.
-    guard &operator=(guard<T> &&other) noexcept = delete;
+    guard &operator=(guard<T, TLockPolicy> &&other) noexcept = delete;
 
     // Conversion assignment operator from synchronized
     template <typename TOther>
         requires std::is_convertible_v<TOther *, const T *>
-    guard &operator=(const synchronized<TOther> &other) noexcept;
+    guard &operator=(const synchronized<TOther, TLockPolicy> &other) noexcept;
 
     ~guard() = default;
 
@@ -209,14 +247,15 @@ class guard<const T>
 
     [[nodiscard]] bool operator!=(const guard &other) const noexcept;
 
+    // The lock shared with the other guards of the same synchronized of a commence_all, otherwise the own lock
     lock_t &get_lock() noexcept
     {
-        return lock_;
+        return shared_lock_ != nullptr ? *shared_lock_ : lock_;
     }
 
     const lock_t &get_lock() const noexcept
     {
-        return lock_;
+        return shared_lock_ != nullptr ? *shared_lock_ : lock_;
     }
 
     // Arrow operator
@@ -232,23 +271,104 @@ class guard<const T>
     [[nodiscard]] explicit operator const T *() const noexcept;
 
   private:
-    template <typename TOther>
+    template <typename TOther, lock_policy TOtherLockPolicy>
         requires(!std::is_const_v<TOther>)
     friend class synchronized;
 
-    template <typename TOther>
+    template <typename TOther, lock_policy TOtherLockPolicy>
     friend class guard;
 
+    template <typename TOther, lock_policy TOtherLockPolicy>
+    friend class upgrade_guard;
+
     template <typename TOther>
         requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
-    guard(ref<const TOther> protected_instance, lock_t lock) noexcept;
+    guard(const TOther *protected_instance, lock_t lock, detail::guard_token<> token) noexcept;
 
+    template <typename TOther>
+        requires(std::is_convertible_v<TOther *, T *> && !std::is_const_v<TOther>)
+    guard(const TOther *protected_instance, std::shared_ptr<lock_t> shared_lock, detail::guard_token<> token) noexcept;
+
+    // Copy of the lock of another guard, an empty lock if the other guard has no own lock
+    [[nodiscard]] static lock_t copy_lock(const lock_t &other_lock);
+
+    // Counts the guard in its synchronized, it is destroyed after the unlock
+#ifdef _MSC_VER
+    [[msvc::no_unique_address]]
+#else
+    [[no_unique_address]]
+#endif
+    detail::guard_token<> token_;
     lock_t lock_;
-    // track the protected instance via a ref to detect the destruction of the synchronized instance
-    ref<const T> protected_instance_;
+    // The guards of the same synchronized of a commence_all share a single lock instead, their own lock is empty.
+    // The same thread must not take the shared lock of a mutex more than once.
+    std::shared_ptr<lock_t> shared_lock_;
+    // Raw pointer, the held lock protects it: the synchronized verifies at its destruction that none of its guards is alive
+    const T *protected_instance_ = nullptr;
+
+    template <typename... TOther, lock_policy... TOtherLockPolicy>
+    friend auto commence_all(synchronized<std::remove_const_t<TOther>, TOtherLockPolicy> &...syncs);
+};
+
+// Immutable access with the upgrade right of the synchronized: it coexists with the shared guards, but there is only one upgrader at a time.
+// It can be turned into a mutable guard (e.g. insert on a cache miss) without unlocking in between, so the checked state stays valid.
+template <typename T, lock_policy TLockPolicy>
+class upgrade_guard
+{
+    static_assert(upgradable_lock_policy<TLockPolicy>, "the upgrade guard needs an upgradable lock policy, e.g. upgrade_mutex_policy");
+
+  public:
+    using lock_t = typename TLockPolicy::upgrade_lock_t;
+    using value_t = const T;
+
+    // The upgrade right is unique
+    upgrade_guard(const upgrade_guard &other) = delete;
+    upgrade_guard &operator=(const upgrade_guard &other) = delete;
+
+    upgrade_guard(upgrade_guard &&other) noexcept = default;
+    upgrade_guard &operator=(upgrade_guard &&other) noexcept = default;
 
-    template <typename... TOther>
-    friend auto commence_all(synchronized<std::remove_const_t<TOther>> &...syncs);
+    ~upgrade_guard() = default;
+
+    lock_t &get_lock() noexcept
+    {
+        return lock_;
+    }
+
+    const lock_t &get_lock() const noexcept
+    {
+        return lock_;
+    }
+
+    // Arrow operator
+    [[nodiscard]] const T *operator->() const;
+
+    // Dereference operator
+    [[nodiscard]] const T &operator*() const;
+
+    // Waits for the shared guards to be released, and turns into a mutable guard
+    [[nodiscard]] guard<T, TLockPolicy> upgrade() &&;
+
+    // Gives up the upgrade right, and keeps only the shared lock
+    [[nodiscard]] guard<const T, TLockPolicy> downgrade() &&;
+
+  private:
+    template <typename TOther, lock_policy TOtherLockPolicy>
+        requires(!std::is_const_v<TOther>)
+    friend class synchronized;
+
+    upgrade_guard(T *protected_instance, lock_t lock, detail::guard_token<> token) noexcept;
+
+    // Counts the guard in its synchronized, it is destroyed after the unlock
+#ifdef _MSC_VER
+    [[msvc::no_unique_address]]
+#else
+    [[no_unique_address]]
+#endif
+    detail::guard_token<> token_;
+    lock_t lock_;
+    // The upgrade gives mutable access, so the pointer is mutable, but this guard provides only immutable access
+    T *protected_instance_ = nullptr;
 };
 
 }  // namespace saam
@@ -0,0 +1,626 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/abi.hpp>
+#include <saam/detail/lock_policy_traits.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+
+// The readers restore the read bias of a reader_biased_mutex only after this multiple of the time its last revocation took
+#ifndef SAAM_READER_BIAS_INHIBIT_FACTOR
+#define SAAM_READER_BIAS_INHIBIT_FACTOR 9
+#endif
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// Minimal exclusive lock for very short critical sections, it busy waits (on a read-only load) instead of sleeping.
+// It satisfies the Lockable requirements, so it can be used with std::unique_lock and std::condition_variable_any.
+class spinlock
+{
+  public:
+    spinlock() noexcept = default;
+    spinlock(const spinlock &) = delete;
+    spinlock &operator=(const spinlock &) = delete;
+
+    void lock() noexcept
+    {
+        while (locked_.exchange(true, std::memory_order_acquire))
+        {
+            // Spin on a load until the lock looks free, so the waiting threads do not bounce the cache line
+            while (locked_.load(std::memory_order_relaxed))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool try_lock() noexcept
+    {
+        return !locked_.load(std::memory_order_relaxed) && !locked_.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() noexcept
+    {
+        locked_.store(false, std::memory_order_release);
+    }
+
+  private:
+    std::atomic<bool> locked_ = false;
+};
+
+// Sequence lock: the writers lock a mutex, and bump the sequence number before and after the write (odd: write in progress).
+// The readers do not lock, they read optimistically, and retry when the sequence number changed during the read,
+// so the readers never write the shared memory.
+class seqlock
+{
+  public:
+    seqlock() noexcept = default;
+    seqlock(const seqlock &) = delete;
+    seqlock &operator=(const seqlock &) = delete;
+
+    void lock()
+    {
+        mutex_.lock();
+        begin_write();
+    }
+
+    bool try_lock()
+    {
+        if (!mutex_.try_lock())
+        {
+            return false;
+        }
+
+        begin_write();
+        return true;
+    }
+
+    void unlock() noexcept
+    {
+        // Release ordering, so the writes of the protected data happen before the even sequence number
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        mutex_.unlock();
+    }
+
+    // Returns the sequence number to be passed to read_retry(), waits for the write in progress
+    [[nodiscard]] std::uint64_t read_begin() const noexcept
+    {
+        while (true)
+        {
+            const auto sequence = sequence_.load(std::memory_order_acquire);
+            if ((sequence & 1) == 0)
+            {
+                return sequence;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // The read is valid only, when there was no write since read_begin()
+    [[nodiscard]] bool read_retry(std::uint64_t sequence) const noexcept
+    {
+        // Acquire fence, so the reads of the protected data happen before the reread of the sequence number
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence_.load(std::memory_order_relaxed) != sequence;
+    }
+
+  private:
+    void begin_write() noexcept
+    {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        // Release fence, so the odd sequence number is visible before any write of the protected data
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    std::mutex mutex_;
+    std::atomic<std::uint64_t> sequence_ = 0;
+};
+
+// Reader-writer mutex with an upgrade right: one upgrader at a time, it coexists with the shared readers (but not with a writer).
+// The upgrader can become the writer without letting another writer in between, and a writer can become a reader or an upgrader the same way.
+// The writers take the upgrade right first, so while the right is held, nobody else can write.
+class upgrade_mutex
+{
+  public:
+    upgrade_mutex() noexcept = default;
+    upgrade_mutex(const upgrade_mutex &) = delete;
+    upgrade_mutex &operator=(const upgrade_mutex &) = delete;
+
+    void lock()
+    {
+        upgrade_right_.lock();
+        shared_mutex_.lock();
+    }
+
+    bool try_lock()
+    {
+        if (!upgrade_right_.try_lock())
+        {
+            return false;
+        }
+        if (!shared_mutex_.try_lock())
+        {
+            upgrade_right_.unlock();
+            return false;
+        }
+        return true;
+    }
+
+    void unlock()
+    {
+        shared_mutex_.unlock();
+        upgrade_right_.unlock();
+    }
+
+    void lock_shared()
+    {
+        shared_mutex_.lock_shared();
+    }
+
+    bool try_lock_shared()
+    {
+        return shared_mutex_.try_lock_shared();
+    }
+
+    void unlock_shared()
+    {
+        shared_mutex_.unlock_shared();
+    }
+
+    void lock_upgrade()
+    {
+        upgrade_right_.lock();
+        shared_mutex_.lock_shared();
+    }
+
+    bool try_lock_upgrade()
+    {
+        if (!upgrade_right_.try_lock())
+        {
+            return false;
+        }
+        if (!shared_mutex_.try_lock_shared())
+        {
+            upgrade_right_.unlock();
+            return false;
+        }
+        return true;
+    }
+
+    void unlock_upgrade()
+    {
+        shared_mutex_.unlock_shared();
+        upgrade_right_.unlock();
+    }
+
+    // Waits for the shared readers to leave, the upgrade right keeps the other writers out meanwhile
+    void unlock_upgrade_and_lock()
+    {
+        shared_mutex_.unlock_shared();
+        shared_mutex_.lock();
+    }
+
+    void unlock_and_lock_upgrade()
+    {
+        shared_mutex_.unlock();
+        shared_mutex_.lock_shared();
+    }
+
+    void unlock_and_lock_shared()
+    {
+        unlock_and_lock_upgrade();
+        upgrade_right_.unlock();
+    }
+
+    void unlock_upgrade_and_lock_shared()
+    {
+        upgrade_right_.unlock();
+    }
+
+  private:
+    std::mutex upgrade_right_;
+    std::shared_mutex shared_mutex_;
+};
+
+// Owns the upgrade right of an upgrade_mutex, similar to std::shared_lock
+template <typename TMutex>
+class upgrade_lock
+{
+  public:
+    using mutex_type = TMutex;
+
+    upgrade_lock() noexcept = default;
+
+    explicit upgrade_lock(mutex_type &mutex) :
+        mutex_(&mutex)
+    {
+        mutex_->lock_upgrade();
+        owns_ = true;
+    }
+
+    upgrade_lock(mutex_type &mutex, std::try_to_lock_t) :
+        mutex_(&mutex),
+        owns_(mutex.try_lock_upgrade())
+    {
+    }
+
+    upgrade_lock(mutex_type &mutex, std::adopt_lock_t) noexcept :
+        mutex_(&mutex),
+        owns_(true)
+    {
+    }
+
+    upgrade_lock(const upgrade_lock &) = delete;
+    upgrade_lock &operator=(const upgrade_lock &) = delete;
+
+    upgrade_lock(upgrade_lock &&other) noexcept :
+        mutex_(std::exchange(other.mutex_, nullptr)),
+        owns_(std::exchange(other.owns_, false))
+    {
+    }
+
+    upgrade_lock &operator=(upgrade_lock &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (owns_)
+            {
+                mutex_->unlock_upgrade();
+            }
+            mutex_ = std::exchange(other.mutex_, nullptr);
+            owns_ = std::exchange(other.owns_, false);
+        }
+        return *this;
+    }
+
+    ~upgrade_lock()
+    {
+        if (owns_)
+        {
+            mutex_->unlock_upgrade();
+        }
+    }
+
+    void lock()
+    {
+        mutex_->lock_upgrade();
+        owns_ = true;
+    }
+
+    bool try_lock()
+    {
+        owns_ = mutex_->try_lock_upgrade();
+        return owns_;
+    }
+
+    void unlock()
+    {
+        mutex_->unlock_upgrade();
+        owns_ = false;
+    }
+
+    // Disassociates the mutex without unlocking it
+    mutex_type *release() noexcept
+    {
+        owns_ = false;
+        return std::exchange(mutex_, nullptr);
+    }
+
+    [[nodiscard]] mutex_type *mutex() const noexcept
+    {
+        return mutex_;
+    }
+
+    [[nodiscard]] bool owns_lock() const noexcept
+    {
+        return owns_;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return owns_;
+    }
+
+  private:
+    mutex_type *mutex_ = nullptr;
+    bool owns_ = false;
+};
+
+// Reader-biased reader-writer mutex (BRAVO): while the read bias is on, a reader only increments the counter of its reader slot
+// (a cache line per slot, shared by a subset of the threads), and does not write the state of the shared mutex.
+// A writer revokes the bias, and waits for the biased readers to leave. The revocation is expensive,
+// so the bias is restored by a reader only when a multiple of the revocation time elapsed (see SAAM_READER_BIAS_INHIBIT_FACTOR).
+// The shared locks must be unlocked by the thread that locked them (like the ones of std::shared_mutex).
+class reader_biased_mutex
+{
+    using clock_t = std::chrono::steady_clock;
+
+  public:
+    // Number of reader slots, it must be a power of two
+    static constexpr std::size_t num_reader_slots = 16;
+    // Number of biased shared locks a thread may hold at the same time, the further shared locks are taken on the shared mutex
+    static constexpr std::size_t max_held_biased_locks = 8;
+    static_assert(num_reader_slots > 0 && (num_reader_slots & (num_reader_slots - 1)) == 0,
+                  "the number of reader slots must be a power of two");
+
+    reader_biased_mutex() noexcept = default;
+    reader_biased_mutex(const reader_biased_mutex &) = delete;
+    reader_biased_mutex &operator=(const reader_biased_mutex &) = delete;
+
+    void lock()
+    {
+        shared_mutex_.lock();
+        revoke_bias();
+    }
+
+    bool try_lock()
+    {
+        if (!shared_mutex_.try_lock())
+        {
+            return false;
+        }
+
+        // Waiting for the biased readers could deadlock with a reader waiting for a lock of the caller (e.g. in std::lock),
+        // so the bias is revoked, but the attempt fails while biased readers are inside
+        if (read_bias_.load(std::memory_order_relaxed))
+        {
+            read_bias_.store(false);
+            if (has_biased_readers())
+            {
+                shared_mutex_.unlock();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void unlock()
+    {
+        shared_mutex_.unlock();
+    }
+
+    void lock_shared()
+    {
+        if (try_lock_shared_biased())
+        {
+            return;
+        }
+        shared_mutex_.lock_shared();
+        restore_bias();
+    }
+
+    bool try_lock_shared()
+    {
+        if (try_lock_shared_biased())
+        {
+            return true;
+        }
+        if (!shared_mutex_.try_lock_shared())
+        {
+            return false;
+        }
+        restore_bias();
+        return true;
+    }
+
+    void unlock_shared()
+    {
+        if (!unlock_shared_biased())
+        {
+            shared_mutex_.unlock_shared();
+        }
+    }
+
+    [[nodiscard]] bool is_read_biased() const noexcept
+    {
+        return read_bias_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct alignas(64) reader_slot
+    {
+        std::atomic<std::size_t> counter = 0;
+    };
+
+    // The biased shared locks of the current thread, so the unlock knows which way the lock was taken.
+    // A thread holding more biased locks takes the shared mutex instead.
+    struct held_biased_locks
+    {
+        std::array<const reader_biased_mutex *, max_held_biased_locks> mutexes{};
+        std::size_t count = 0;
+    };
+
+    static held_biased_locks &current_held_biased_locks() noexcept
+    {
+        thread_local held_biased_locks held;
+        return held;
+    }
+
+    static std::size_t current_reader_slot_index() noexcept
+    {
+        // Each thread gets a slot assigned in a round-robin manner, when it reads first time
+        thread_local const std::size_t slot_index = next_reader_slot_index_.fetch_add(1, std::memory_order_relaxed) & (num_reader_slots - 1);
+        return slot_index;
+    }
+
+    bool try_lock_shared_biased() noexcept
+    {
+        auto &held = current_held_biased_locks();
+        if (!read_bias_.load(std::memory_order_relaxed) || held.count == held.mutexes.size())
+        {
+            return false;
+        }
+
+        // The writer revokes the bias before it checks the slots (both sequentially consistent),
+        // so either the writer sees this reader, or this reader sees the revocation
+        auto &slot = reader_slots_[current_reader_slot_index()];
+        slot.counter.fetch_add(1);
+        if (!read_bias_.load())
+        {
+            slot.counter.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+
+        held.mutexes[held.count++] = this;
+        return true;
+    }
+
+    bool unlock_shared_biased() noexcept
+    {
+        auto &held = current_held_biased_locks();
+        for (std::size_t index = held.count; index-- > 0;)
+        {
+            if (held.mutexes[index] == this)
+            {
+                held.mutexes[index] = held.mutexes[--held.count];
+                // Release ordering, so the reads of the protected data happen before the writer sees the slot empty
+                reader_slots_[current_reader_slot_index()].counter.fetch_sub(1, std::memory_order_release);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] bool has_biased_readers() const noexcept
+    {
+        for (const auto &slot : reader_slots_)
+        {
+            if (slot.counter.load() != 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The exclusive lock is held
+    void revoke_bias() noexcept
+    {
+        if (!read_bias_.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        const auto revoked_at = clock_t::now();
+        read_bias_.store(false);
+        while (has_biased_readers())
+        {
+            std::this_thread::yield();
+        }
+        const auto revoked_until = clock_t::now();
+        inhibit_until_ = revoked_until + (revoked_until - revoked_at) * SAAM_READER_BIAS_INHIBIT_FACTOR;
+    }
+
+    // A shared lock is held, so no writer can revoke the bias in the meantime
+    void restore_bias() noexcept
+    {
+        if (!read_bias_.load(std::memory_order_relaxed) && clock_t::now() >= inhibit_until_)
+        {
+            read_bias_.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    std::shared_mutex shared_mutex_;
+    std::atomic<bool> read_bias_ = true;
+    // Written by the writers, and read by the readers holding the shared mutex
+    clock_t::time_point inhibit_until_;
+    std::array<reader_slot, num_reader_slots> reader_slots_;
+
+    static inline std::atomic<std::size_t> next_reader_slot_index_ = 0;
+};
+
+// The lock policy of a synchronized defines its mutex and the locks of its guards.
+// A shared policy lets the immutable guards share the lock,
+// an exclusive policy has no shared lock, so the immutable guards take the exclusive lock too.
+
+// Reader-writer lock policy, the TMutex must satisfy the SharedMutex requirements
+template <typename TMutex>
+struct shared_lock_policy
+{
+    using mutex_t = TMutex;
+    using unique_lock_t = std::unique_lock<mutex_t>;
+    using shared_lock_t = std::shared_lock<mutex_t>;
+
+    static constexpr bool is_shared = true;
+};
+
+// Exclusive-only lock policy, the TMutex must satisfy the Lockable requirements
+template <typename TMutex>
+struct exclusive_lock_policy
+{
+    using mutex_t = TMutex;
+    using unique_lock_t = std::unique_lock<mutex_t>;
+    using shared_lock_t = std::unique_lock<mutex_t>;
+
+    static constexpr bool is_shared = false;
+};
+
+// Reader-writer lock policy with upgradable guards, the TMutex must provide the interface of the upgrade_mutex
+template <typename TMutex>
+struct upgrade_lock_policy : shared_lock_policy<TMutex>
+{
+    using upgrade_lock_t = upgrade_lock<TMutex>;
+};
+
+using shared_mutex_policy = shared_lock_policy<std::shared_mutex>;
+using shared_timed_mutex_policy = shared_lock_policy<std::shared_timed_mutex>;
+using mutex_policy = exclusive_lock_policy<std::mutex>;
+using timed_mutex_policy = exclusive_lock_policy<std::timed_mutex>;
+using spinlock_policy = exclusive_lock_policy<spinlock>;
+// Exclusive lock for the guards, and lock-free snapshot() for the readers of trivially copyable types
+using seqlock_policy = exclusive_lock_policy<seqlock>;
+// Shared lock for the immutable guards, plus upgradable guards that can become mutable without unlocking
+using upgrade_mutex_policy = upgrade_lock_policy<upgrade_mutex>;
+// Shared lock for the immutable guards, the readers do not write the shared state of the mutex while the read bias is on
+using reader_biased_mutex_policy = shared_lock_policy<reader_biased_mutex>;
+
+// The mutex of the policy supports optimistic reads
+template <typename TLockPolicy>
+concept optimistic_lock_policy = lock_policy<TLockPolicy> && requires(const typename TLockPolicy::mutex_t &mutex, std::uint64_t sequence) {
+    { mutex.read_begin() } -> std::same_as<std::uint64_t>;
+    { mutex.read_retry(sequence) } -> std::same_as<bool>;
+};
+
+// The mutex of the policy supports the timed acquisition of all the guards
+template <typename TLockPolicy>
+concept timed_lock_policy =
+    lock_policy<TLockPolicy> &&
+    requires(typename TLockPolicy::mutex_t &mutex, const std::chrono::steady_clock::time_point &deadline) {
+        { mutex.try_lock_until(deadline) } -> std::same_as<bool>;
+    } &&
+    (!TLockPolicy::is_shared || requires(typename TLockPolicy::mutex_t &mutex, const std::chrono::steady_clock::time_point &deadline) {
+        { mutex.try_lock_shared_until(deadline) } -> std::same_as<bool>;
+    });
+
+// The policy supports the upgradable guards
+template <typename TLockPolicy>
+concept upgradable_lock_policy = lock_policy<TLockPolicy> && TLockPolicy::is_shared && requires { typename TLockPolicy::upgrade_lock_t; };
+
+// Wraps the mutex of a policy, and records the contention of each synchronized instance (see profiled_lock_policy.hpp)
+template <lock_policy TLockPolicy>
+struct profiled_lock_policy;
+
+#if SAAM_LOCK_PROFILING
+using default_lock_policy = profiled_lock_policy<shared_mutex_policy>;
+#else
+using default_lock_policy = shared_mutex_policy;
+#endif
+
+}  // namespace saam
+
+#if SAAM_LOCK_PROFILING
+#include <saam/profiled_lock_policy.hpp>
+#endif
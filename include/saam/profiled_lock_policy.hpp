@@ -0,0 +1,591 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/lock_policy.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// Distribution of durations in power of two nanosecond buckets
+struct lock_histogram_snapshot
+{
+    // Number of the logarithmic buckets, the last bucket collects all the longer durations
+    static constexpr std::size_t bucket_count = 40;
+
+    // The bucket 0 counts the zero durations, the bucket i the durations of [2^(i-1), 2^i) nanoseconds
+    std::array<std::uint64_t, bucket_count> buckets{};
+    std::uint64_t count = 0;
+    std::chrono::nanoseconds total{0};
+
+    // Inclusive upper bound of a bucket, the last bucket is unbounded
+    [[nodiscard]] static constexpr std::chrono::nanoseconds upper_bound(std::size_t bucket) noexcept
+    {
+        return bucket + 1 < bucket_count ? std::chrono::nanoseconds((std::int64_t{1} << bucket) - 1) : std::chrono::nanoseconds::max();
+    }
+
+    // Upper bound of the bucket containing the quantile (0..1), zero for an empty histogram
+    [[nodiscard]] std::chrono::nanoseconds quantile(double quantile) const noexcept
+    {
+        const auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count)));
+        std::uint64_t cumulative = 0;
+        for (std::size_t bucket = 0; bucket < bucket_count; ++bucket)
+        {
+            cumulative += buckets[bucket];
+            if (cumulative >= std::max<std::uint64_t>(rank, 1))
+            {
+                return upper_bound(bucket);
+            }
+        }
+        return std::chrono::nanoseconds(0);
+    }
+};
+
+// Contention profile of a synchronized instance with a profiled lock policy
+struct instance_lock_profile
+{
+    // Address of the profiled mutex, it tells apart the instances with the same type and label
+    const void *instance = nullptr;
+    // The protected type of the synchronized, and the optional user label
+    const std::type_info *type = nullptr;
+    std::string label;
+    // Number of the acquired locks (including the timed and the non-blocking ones), the upgrade right is counted as shared
+    std::uint64_t exclusive_acquisitions = 0;
+    std::uint64_t shared_acquisitions = 0;
+    // Number of the acquisitions, that found the mutex locked and had to wait
+    std::uint64_t contended_acquisitions = 0;
+    // Number of the non-blocking and the timed attempts, that did not get the lock
+    std::uint64_t failed_attempts = 0;
+    // Time spent waiting for the locks (zero for the uncontended ones), and holding the exclusive locks
+    lock_histogram_snapshot wait_time;
+    lock_histogram_snapshot hold_time;
+};
+
+struct lock_profile_snapshot
+{
+    std::chrono::steady_clock::time_point taken_at;
+    std::vector<instance_lock_profile> instances;
+};
+
+namespace detail
+{
+
+// Lock-free histogram, updated by the profiled mutex
+class lock_histogram
+{
+  public:
+    void record(std::chrono::nanoseconds duration) noexcept
+    {
+        const auto nanoseconds = static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 0));
+        const auto bucket = std::min<std::size_t>(std::bit_width(nanoseconds), lock_histogram_snapshot::bucket_count - 1);
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        total_ns_.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] lock_histogram_snapshot snapshot() const noexcept
+    {
+        lock_histogram_snapshot result;
+        for (std::size_t bucket = 0; bucket < lock_histogram_snapshot::bucket_count; ++bucket)
+        {
+            result.buckets[bucket] = buckets_[bucket].load(std::memory_order_relaxed);
+            result.count += result.buckets[bucket];
+        }
+        result.total = std::chrono::nanoseconds(total_ns_.load(std::memory_order_relaxed));
+        return result;
+    }
+
+  private:
+    std::array<std::atomic<std::uint64_t>, lock_histogram_snapshot::bucket_count> buckets_{};
+    std::atomic<std::uint64_t> total_ns_ = 0;
+};
+
+class lock_profile_registry;
+
+}  // namespace detail
+
+// Live counters of a profiled mutex, it is registered for the lock profile snapshots while it exists
+class lock_profile
+{
+  public:
+    lock_profile();
+    // The type is set before the profile is registered, so the snapshots never see it change
+    explicit lock_profile(const std::type_info &type);
+    lock_profile(const lock_profile &) = delete;
+    lock_profile &operator=(const lock_profile &) = delete;
+    ~lock_profile();
+
+    // The label tells apart the instances in the exported profile, e.g. the shards of a map
+    void set_label(std::string label);
+    [[nodiscard]] std::string label() const;
+
+    [[nodiscard]] const std::type_info *type() const noexcept
+    {
+        return type_;
+    }
+
+    [[nodiscard]] instance_lock_profile snapshot() const;
+
+    void record_acquisition(bool exclusive, bool contended, std::chrono::nanoseconds wait_time) noexcept
+    {
+        (exclusive ? exclusive_acquisitions_ : shared_acquisitions_).fetch_add(1, std::memory_order_relaxed);
+        if (contended)
+        {
+            contended_acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        wait_time_.record(wait_time);
+    }
+
+    void record_failed_attempt() noexcept
+    {
+        failed_attempts_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record_hold(std::chrono::nanoseconds hold_time) noexcept
+    {
+        hold_time_.record(hold_time);
+    }
+
+  private:
+    friend class detail::lock_profile_registry;
+
+    [[nodiscard]] instance_lock_profile snapshot_unlocked() const;
+
+    // The registry links the live profiles, the links and the label are protected by the mutex of the registry
+    lock_profile *previous_ = nullptr;
+    lock_profile *next_ = nullptr;
+    std::string label_;
+
+    const std::type_info *const type_ = nullptr;
+    std::atomic<std::uint64_t> exclusive_acquisitions_ = 0;
+    std::atomic<std::uint64_t> shared_acquisitions_ = 0;
+    std::atomic<std::uint64_t> contended_acquisitions_ = 0;
+    std::atomic<std::uint64_t> failed_attempts_ = 0;
+    detail::lock_histogram wait_time_;
+    detail::lock_histogram hold_time_;
+};
+
+namespace detail
+{
+
+// Intrusive list of the live lock profiles, the profiles of the destroyed instances are not kept
+class lock_profile_registry
+{
+  public:
+    static void add(lock_profile &profile)
+    {
+        std::lock_guard guard(mutex_);
+        profile.next_ = head_;
+        if (head_ != nullptr)
+        {
+            head_->previous_ = &profile;
+        }
+        head_ = &profile;
+    }
+
+    static void remove(lock_profile &profile) noexcept
+    {
+        std::lock_guard guard(mutex_);
+        (profile.previous_ != nullptr ? profile.previous_->next_ : head_) = profile.next_;
+        if (profile.next_ != nullptr)
+        {
+            profile.next_->previous_ = profile.previous_;
+        }
+    }
+
+    static void set_label(lock_profile &profile, std::string label)
+    {
+        std::lock_guard guard(mutex_);
+        profile.label_ = std::move(label);
+    }
+
+    static std::string label(const lock_profile &profile)
+    {
+        std::lock_guard guard(mutex_);
+        return profile.label_;
+    }
+
+    static instance_lock_profile snapshot(const lock_profile &profile)
+    {
+        std::lock_guard guard(mutex_);
+        return profile.snapshot_unlocked();
+    }
+
+    static lock_profile_snapshot snapshot()
+    {
+        lock_profile_snapshot result{.taken_at = std::chrono::steady_clock::now(), .instances = {}};
+
+        std::lock_guard guard(mutex_);
+        for (const auto *profile = head_; profile != nullptr; profile = profile->next_)
+        {
+            result.instances.push_back(profile->snapshot_unlocked());
+        }
+        return result;
+    }
+
+  private:
+    static inline std::mutex mutex_;
+    static inline lock_profile *head_ = nullptr;
+};
+
+}  // namespace detail
+
+inline lock_profile::lock_profile()
+{
+    detail::lock_profile_registry::add(*this);
+}
+
+inline lock_profile::lock_profile(const std::type_info &type) :
+    type_(&type)
+{
+    detail::lock_profile_registry::add(*this);
+}
+
+inline lock_profile::~lock_profile()
+{
+    detail::lock_profile_registry::remove(*this);
+}
+
+inline void lock_profile::set_label(std::string label)
+{
+    detail::lock_profile_registry::set_label(*this, std::move(label));
+}
+
+inline std::string lock_profile::label() const
+{
+    return detail::lock_profile_registry::label(*this);
+}
+
+inline instance_lock_profile lock_profile::snapshot() const
+{
+    return detail::lock_profile_registry::snapshot(*this);
+}
+
+inline instance_lock_profile lock_profile::snapshot_unlocked() const
+{
+    return {
+        .instance = this,
+        .type = type_,
+        .label = label_,
+        .exclusive_acquisitions = exclusive_acquisitions_.load(std::memory_order_relaxed),
+        .shared_acquisitions = shared_acquisitions_.load(std::memory_order_relaxed),
+        .contended_acquisitions = contended_acquisitions_.load(std::memory_order_relaxed),
+        .failed_attempts = failed_attempts_.load(std::memory_order_relaxed),
+        .wait_time = wait_time_.snapshot(),
+        .hold_time = hold_time_.snapshot(),
+    };
+}
+
+// Takes a consistent list of the live profiled instances, the counters of an instance are read one by one (not atomically together)
+inline lock_profile_snapshot take_lock_profile_snapshot()
+{
+    return detail::lock_profile_registry::snapshot();
+}
+
+// Exports the snapshot in the Prometheus text exposition format, the type is given by its (implementation specific) type name
+inline std::ostream &operator<<(std::ostream &stream, const lock_profile_snapshot &snapshot)
+{
+    const auto write_labels = [&](const instance_lock_profile &profile) -> std::ostream & {
+        return stream << "type=\"" << (profile.type != nullptr ? profile.type->name() : "") << "\",label=\"" << profile.label
+                      << "\",instance=\"" << profile.instance << '"';
+    };
+
+    const auto write_counter = [&](const char *name, const auto &value_of) {
+        stream << "# TYPE " << name << " counter\n";
+        for (const auto &profile : snapshot.instances)
+        {
+            stream << name << '{';
+            write_labels(profile) << "} " << value_of(profile) << '\n';
+        }
+    };
+
+    const auto write_histogram = [&](const char *name, const auto &histogram_of) {
+        stream << "# TYPE " << name << " histogram\n";
+        for (const auto &profile : snapshot.instances)
+        {
+            const lock_histogram_snapshot &histogram = histogram_of(profile);
+            std::uint64_t cumulative = 0;
+            for (std::size_t bucket = 0; bucket + 1 < lock_histogram_snapshot::bucket_count; ++bucket)
+            {
+                cumulative += histogram.buckets[bucket];
+                stream << name << "_bucket{";
+                write_labels(profile) << ",le=\"" << std::chrono::duration<double>(lock_histogram_snapshot::upper_bound(bucket)).count()
+                                      << "\"} " << cumulative << '\n';
+            }
+            stream << name << "_bucket{";
+            write_labels(profile) << ",le=\"+Inf\"} " << histogram.count << '\n';
+            stream << name << "_sum{";
+            write_labels(profile) << "} " << std::chrono::duration<double>(histogram.total).count() << '\n';
+            stream << name << "_count{";
+            write_labels(profile) << "} " << histogram.count << '\n';
+        }
+    };
+
+    write_counter("saam_lock_exclusive_acquisitions_total", [](const auto &profile) { return profile.exclusive_acquisitions; });
+    write_counter("saam_lock_shared_acquisitions_total", [](const auto &profile) { return profile.shared_acquisitions; });
+    write_counter("saam_lock_contended_acquisitions_total", [](const auto &profile) { return profile.contended_acquisitions; });
+    write_counter("saam_lock_failed_attempts_total", [](const auto &profile) { return profile.failed_attempts; });
+    write_histogram("saam_lock_wait_seconds", [](const auto &profile) -> const auto & { return profile.wait_time; });
+    write_histogram("saam_lock_hold_seconds", [](const auto &profile) -> const auto & { return profile.hold_time; });
+    return stream;
+}
+
+// Wraps a mutex, and records the acquisitions into a lock profile.
+// An acquisition tries the lock first, only the contended ones read the clock before waiting.
+// The exclusive locks are timed until their release, the hold time of the shared locks is not recorded.
+template <typename TMutex>
+class profiled_mutex
+{
+    using clock_t = std::chrono::steady_clock;
+
+  public:
+    using wrapped_mutex_t = TMutex;
+
+    profiled_mutex() = default;
+
+    // Called by the synchronized with the type of its instance
+    explicit profiled_mutex(const std::type_info &type) :
+        profile_(type)
+    {
+    }
+
+    profiled_mutex(const profiled_mutex &) = delete;
+    profiled_mutex &operator=(const profiled_mutex &) = delete;
+
+    void lock()
+    {
+        acquire(true, [&] { return mutex_.try_lock(); }, [&] {
+            mutex_.lock();
+            return true;
+        });
+    }
+
+    bool try_lock()
+    {
+        return try_acquire(true, [&] { return mutex_.try_lock(); });
+    }
+
+    template <typename TRep, typename TPeriod>
+    bool try_lock_for(const std::chrono::duration<TRep, TPeriod> &timeout)
+        requires requires(TMutex &mutex) { mutex.try_lock_for(timeout); }
+    {
+        return acquire(true, [&] { return mutex_.try_lock(); }, [&] { return mutex_.try_lock_for(timeout); });
+    }
+
+    template <typename TClock, typename TDuration>
+    bool try_lock_until(const std::chrono::time_point<TClock, TDuration> &deadline)
+        requires requires(TMutex &mutex) { mutex.try_lock_until(deadline); }
+    {
+        return acquire(true, [&] { return mutex_.try_lock(); }, [&] { return mutex_.try_lock_until(deadline); });
+    }
+
+    void unlock()
+    {
+        // The clock is read in the critical section, but the hold time is recorded after the release
+        const auto hold_time = clock_t::now() - locked_at_;
+        mutex_.unlock();
+        profile_.record_hold(hold_time);
+    }
+
+    void lock_shared()
+        requires requires(TMutex &mutex) { mutex.lock_shared(); }
+    {
+        acquire(false, [&] { return mutex_.try_lock_shared(); }, [&] {
+            mutex_.lock_shared();
+            return true;
+        });
+    }
+
+    bool try_lock_shared()
+        requires requires(TMutex &mutex) { mutex.try_lock_shared(); }
+    {
+        return try_acquire(false, [&] { return mutex_.try_lock_shared(); });
+    }
+
+    template <typename TRep, typename TPeriod>
+    bool try_lock_shared_for(const std::chrono::duration<TRep, TPeriod> &timeout)
+        requires requires(TMutex &mutex) { mutex.try_lock_shared_for(timeout); }
+    {
+        return acquire(false, [&] { return mutex_.try_lock_shared(); }, [&] { return mutex_.try_lock_shared_for(timeout); });
+    }
+
+    template <typename TClock, typename TDuration>
+    bool try_lock_shared_until(const std::chrono::time_point<TClock, TDuration> &deadline)
+        requires requires(TMutex &mutex) { mutex.try_lock_shared_until(deadline); }
+    {
+        return acquire(false, [&] { return mutex_.try_lock_shared(); }, [&] { return mutex_.try_lock_shared_until(deadline); });
+    }
+
+    void unlock_shared()
+        requires requires(TMutex &mutex) { mutex.unlock_shared(); }
+    {
+        mutex_.unlock_shared();
+    }
+
+    void lock_upgrade()
+        requires requires(TMutex &mutex) { mutex.lock_upgrade(); }
+    {
+        acquire(false, [&] { return mutex_.try_lock_upgrade(); }, [&] {
+            mutex_.lock_upgrade();
+            return true;
+        });
+    }
+
+    bool try_lock_upgrade()
+        requires requires(TMutex &mutex) { mutex.try_lock_upgrade(); }
+    {
+        return try_acquire(false, [&] { return mutex_.try_lock_upgrade(); });
+    }
+
+    void unlock_upgrade()
+        requires requires(TMutex &mutex) { mutex.unlock_upgrade(); }
+    {
+        mutex_.unlock_upgrade();
+    }
+
+    // The upgrade has no non-blocking attempt: its wait for the readers is recorded, but it is not counted as contended
+    void unlock_upgrade_and_lock()
+        requires requires(TMutex &mutex) { mutex.unlock_upgrade_and_lock(); }
+    {
+        const auto waiting_since = clock_t::now();
+        mutex_.unlock_upgrade_and_lock();
+        locked_at_ = clock_t::now();
+        profile_.record_acquisition(true, false, locked_at_ - waiting_since);
+    }
+
+    void unlock_and_lock_upgrade()
+        requires requires(TMutex &mutex) { mutex.unlock_and_lock_upgrade(); }
+    {
+        const auto hold_time = clock_t::now() - locked_at_;
+        mutex_.unlock_and_lock_upgrade();
+        profile_.record_hold(hold_time);
+    }
+
+    void unlock_and_lock_shared()
+        requires requires(TMutex &mutex) { mutex.unlock_and_lock_shared(); }
+    {
+        const auto hold_time = clock_t::now() - locked_at_;
+        mutex_.unlock_and_lock_shared();
+        profile_.record_hold(hold_time);
+    }
+
+    void unlock_upgrade_and_lock_shared()
+        requires requires(TMutex &mutex) { mutex.unlock_upgrade_and_lock_shared(); }
+    {
+        mutex_.unlock_upgrade_and_lock_shared();
+    }
+
+    // The optimistic reads are not profiled, they do not lock
+    [[nodiscard]] std::uint64_t read_begin() const noexcept
+        requires requires(const TMutex &mutex) { mutex.read_begin(); }
+    {
+        return mutex_.read_begin();
+    }
+
+    [[nodiscard]] bool read_retry(std::uint64_t sequence) const noexcept
+        requires requires(const TMutex &mutex) { mutex.read_retry(sequence); }
+    {
+        return mutex_.read_retry(sequence);
+    }
+
+    [[nodiscard]] lock_profile &profile() const noexcept
+    {
+        return profile_;
+    }
+
+  private:
+    template <typename TTryLock, typename TLock>
+    bool acquire(bool exclusive, TTryLock try_lock, TLock lock)
+    {
+        if (try_lock())
+        {
+            acquired(exclusive, false, clock_t::duration::zero());
+            return true;
+        }
+
+        const auto waiting_since = clock_t::now();
+        if (!lock())
+        {
+            profile_.record_failed_attempt();
+            return false;
+        }
+        acquired(exclusive, true, clock_t::now() - waiting_since);
+        return true;
+    }
+
+    template <typename TTryLock>
+    bool try_acquire(bool exclusive, TTryLock try_lock)
+    {
+        if (!try_lock())
+        {
+            profile_.record_failed_attempt();
+            return false;
+        }
+        acquired(exclusive, false, clock_t::duration::zero());
+        return true;
+    }
+
+    void acquired(bool exclusive, bool contended, clock_t::duration wait_time) noexcept
+    {
+        if (exclusive)
+        {
+            locked_at_ = clock_t::now();
+        }
+        profile_.record_acquisition(exclusive, contended, wait_time);
+    }
+
+    TMutex mutex_;
+    // Written by the exclusive owner only
+    clock_t::time_point locked_at_;
+    mutable lock_profile profile_;
+};
+
+namespace detail
+{
+
+template <typename TLockPolicy, typename TMutex>
+struct profiled_upgrade_lock
+{
+};
+
+template <typename TLockPolicy, typename TMutex>
+    requires upgradable_lock_policy<TLockPolicy>
+struct profiled_upgrade_lock<TLockPolicy, TMutex>
+{
+    using upgrade_lock_t = upgrade_lock<TMutex>;
+};
+
+}  // namespace detail
+
+// Lock policy with the mutex of the wrapped policy, profiled per synchronized instance (see take_lock_profile_snapshot).
+// The instances are tagged with the protected type, and the optional label (see synchronized::profile()).
+template <lock_policy TLockPolicy>
+struct profiled_lock_policy : detail::profiled_upgrade_lock<TLockPolicy, profiled_mutex<typename TLockPolicy::mutex_t>>
+{
+    using wrapped_lock_policy_t = TLockPolicy;
+    using mutex_t = profiled_mutex<typename TLockPolicy::mutex_t>;
+    using unique_lock_t = std::unique_lock<mutex_t>;
+    using shared_lock_t = std::conditional_t<TLockPolicy::is_shared, std::shared_lock<mutex_t>, std::unique_lock<mutex_t>>;
+
+    static constexpr bool is_shared = TLockPolicy::is_shared;
+};
+
+}  // namespace saam
@@ -0,0 +1,155 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/counted_borrow_manager.hpp>
+#include <saam/safe_ref.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+class rcu_writer;
+
+// Read-copy-update container for large, read-mostly data.
+// The readers never block: they pin the current immutable version with a borrow of it.
+// The writers copy the current version, modify the copy and publish it as the new current version (one writer at a time).
+// The replaced versions are retired, and reclaimed only when they are not borrowed anymore.
+// The versions are counted (counted_borrow_manager) independently of the borrow checking mode,
+// because the reclamation needs to know if a version is still borrowed.
+template <typename T>
+    requires(!std::is_const_v<T>)  // Only mutable types need synchronization
+class rcu_synchronized
+{
+  public:
+    using data_type_t = T;
+    using borrow_manager_t = counted_borrow_manager;
+    using reader_ref_t = ref<const T, borrow_manager_t>;
+
+    // Number of reader slots (per grace period parity), it must be a power of two
+    static constexpr std::size_t num_reader_slots = 16;
+    static_assert(num_reader_slots > 0 && (num_reader_slots & (num_reader_slots - 1)) == 0,
+                  "the number of reader slots must be a power of two");
+
+    rcu_synchronized();
+
+    template <typename... Args>
+    explicit rcu_synchronized(std::in_place_t, Args &&...args);
+
+    explicit rcu_synchronized(const T &instance);
+
+    explicit rcu_synchronized(T &&instance);
+
+    // The readers refer to the versions of this instance, so it is neither copied, nor moved
+    rcu_synchronized(const rcu_synchronized &other) = delete;
+    rcu_synchronized(rcu_synchronized &&other) = delete;
+    rcu_synchronized &operator=(const rcu_synchronized &other) = delete;
+    rcu_synchronized &operator=(rcu_synchronized &&other) = delete;
+
+    // All the versions are destroyed, a still borrowed version triggers the dangling reference panic
+    ~rcu_synchronized();
+
+    // Pins the current version, it stays valid (immutable) until the reference is released - even if newer versions are published
+    [[nodiscard]] reader_ref_t read() const;
+
+    // Copies the current version into a draft for modification, the draft is published when the writer is destroyed
+    [[nodiscard]] rcu_writer<T> commence_mut();
+
+    // Replaces the current version without copying it
+    rcu_synchronized &operator=(const T &instance);
+    rcu_synchronized &operator=(T &&instance);
+
+    // Reclaims the retired versions that are not borrowed anymore, returns the number of still borrowed retired versions.
+    // It is done on each publishing, so it is needed only, when the retired versions shall be released without a new publishing.
+    std::size_t reclaim();
+
+  private:
+    friend class rcu_writer<T>;
+
+    struct version
+    {
+        template <typename... Args>
+        explicit version(std::in_place_t, Args &&...args) :
+            instance(std::in_place, std::forward<Args>(args)...)
+        {
+        }
+
+        var<T, borrow_manager_t> instance;
+        version *next_retired = nullptr;
+    };
+
+    // Reader section counter, each on its own cache line, so the readers do not falsely share
+    struct alignas(64) reader_slot
+    {
+        std::atomic<std::size_t> counter = 0;
+    };
+
+    static std::size_t current_reader_slot_index() noexcept;
+
+    // The mutex of the writers must be locked
+    void publish(std::unique_ptr<version> new_version) noexcept;
+    void wait_for_readers() noexcept;
+    std::size_t reclaim_locked() noexcept;
+
+    std::mutex writer_mutex_;
+    std::atomic<version *> current_;
+    version *retired_ = nullptr;
+
+    // The readers count themselves into the slots of the current parity, only while they borrow the current version.
+    // A writer flips the parity twice after publishing a new version, and waits for the readers of the previous parity after each flip,
+    // after that, no reader can borrow the replaced version anymore.
+    std::atomic<std::size_t> grace_period_ = 0;
+    mutable std::array<std::array<reader_slot, num_reader_slots>, 2> reader_slots_;
+
+    static inline std::atomic<std::size_t> next_reader_slot_index_ = 0;
+};
+
+// Guard-like writer of an rcu_synchronized, it holds the lock of the writers and a draft copy of the current version.
+// The readers do not see the modifications of the draft, until the writer is destroyed and the draft is published.
+template <typename T>
+    requires(!std::is_const_v<T>)
+class rcu_writer
+{
+  public:
+    rcu_writer(const rcu_writer &other) = delete;
+    rcu_writer(rcu_writer &&other) noexcept = default;
+    rcu_writer &operator=(const rcu_writer &other) = delete;
+    rcu_writer &operator=(rcu_writer &&other) noexcept = delete;
+
+    // Publishes the draft
+    ~rcu_writer();
+
+    // Arrow operator
+    [[nodiscard]] T *operator->() const;
+
+    // Dereference operator
+    [[nodiscard]] T &operator*() const;
+
+  private:
+    friend class rcu_synchronized<T>;
+
+    using version_t = typename rcu_synchronized<T>::version;
+
+    rcu_writer(rcu_synchronized<T> &owner, std::unique_lock<std::mutex> lock);
+
+    std::unique_lock<std::mutex> lock_;
+    rcu_synchronized<T> *owner_;
+    std::unique_ptr<version_t> draft_;
+    // track the draft via a ref to keep the borrow checking of the draft also after its publishing
+    ref<T, counted_borrow_manager> draft_ref_;
+};
+
+}  // namespace saam
+
+#include <saam/detail/rcu_synchronized.ipp>
@@ -4,24 +4,34 @@
 
 #pragma once
 
+#include <saam/borrow_manager_for.hpp>
 #include <saam/detail/borrow_manager_traits.hpp>
-#include <saam/detail/default_borrow_manager.hpp>
 
 #include <type_traits>
 
-namespace saam
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
 template <underlying_type T, borrow_manager TBorrowManager>
 class var;
 
-template <underlying_type T, borrow_manager TBorrowManager = default_borrow_manager_t>
+template <underlying_type T, borrow_manager TBorrowManager>
+class var_vector;
+
+template <underlying_type T, borrow_manager TBorrowManager>
+class weak_ref;
+
+template <underlying_type T, borrow_manager TBorrowManager = borrow_manager_for_t<T>>
 class ref : private TBorrowManager::ref_base
 {
   public:
     using type_t = T;
     using borrow_manager_t = TBorrowManager;
 
+    // Without a reference management (unchecked mode), the ref is just a pointer: trivially copyable and destructible.
+    // Its copy and move are the same then, the moved-from ref keeps referring to the instance.
+    static constexpr bool is_trivially_copyable = std::is_trivially_copyable_v<typename TBorrowManager::ref_base>;
+
     // Unmanaged reference constructor
     ref(T &instance);
 
@@ -31,7 +41,11 @@ class ref : private TBorrowManager::ref_base
     ref(const ref<TOther, TBorrowManager> &other);
 
     // The conversion copy constructor does not cover the copy constructor, so we need to implement it explicitly
-    ref(const ref &other);
+    ref(const ref &other)
+        requires(!is_trivially_copyable);
+    ref(const ref &other)
+        requires is_trivially_copyable
+    = default;
 
     // The requirement for moved-from objects is specified in section [lib.types.movedfrom] of the C++20 standard (section 16.5.5.15), which
     // states: "Unless otherwise specified, such moved-from objects shall be placed in a valid but unspecified state."
@@ -46,7 +60,11 @@ class ref : private TBorrowManager::ref_base
     ref(ref<TOther, TBorrowManager> &&other) noexcept;
 
     // The conversion move constructor does not cover the move constructor, so we need to implement it explicitly
-    ref(ref &&other) noexcept;
+    ref(ref &&other) noexcept
+        requires(!is_trivially_copyable);
+    ref(ref &&other) noexcept
+        requires is_trivially_copyable
+    = default;
 
     // Conversion copy construction from var
     template <underlying_type TOther>
@@ -58,14 +76,22 @@ class ref : private TBorrowManager::ref_base
         requires std::is_convertible_v<TOther *, T *>
     ref &operator=(const ref<TOther, TBorrowManager> &other);
 
-    ref &operator=(const ref &other);
+    ref &operator=(const ref &other)
+        requires(!is_trivially_copyable);
+    ref &operator=(const ref &other)
+        requires is_trivially_copyable
+    = default;
 
     // Conversion move assignment operator from ref
     template <underlying_type TOther>
         requires std::is_convertible_v<TOther *, T *>
     ref &operator=(ref<TOther, TBorrowManager> &&other) noexcept;
 
-    ref &operator=(ref &&other) noexcept;
+    ref &operator=(ref &&other) noexcept
+        requires(!is_trivially_copyable);
+    ref &operator=(ref &&other) noexcept
+        requires is_trivially_copyable
+    = default;
 
     // Conversion assignment operator from var
     template <underlying_type TOther>
@@ -76,6 +102,7 @@ class ref : private TBorrowManager::ref_base
 
     // When the reference is in a moved-from state, it does not contain a valid address to an instance
     // Reassigning the reference will make it valid again
+    // A trivially copyable ref (unchecked mode) is never moved-from: all its moves, also the converting ones, are copies
     [[nodiscard]] bool is_moved_from() const noexcept;
 
     // Equality of references, not the underlying objects --> similar to smart pointers
@@ -116,6 +143,14 @@ class ref : private TBorrowManager::ref_base
     template <underlying_type TOther, borrow_manager TOtherBorrowManager>
     friend class ref;
 
+    // Its elements are borrowed with the borrow managers of a separate array
+    template <underlying_type TOther, borrow_manager TOtherBorrowManager>
+    friend class var_vector;
+
+    // Upgrades to a managed reference
+    template <underlying_type TOther, borrow_manager TOtherBorrowManager>
+    friend class weak_ref;
+
     T *instance_ = nullptr;
 };
 
@@ -0,0 +1,52 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/borrow_manager_traits.hpp>
+#include <saam/detail/constructor_destructor_traits.hpp>
+#include <saam/safe_ref.hpp>
+
+#include <cstddef>
+#include <type_traits>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// Opt-in trait: the bytes of a T can be copied to another address, and the copy is the same object as the source,
+// which is not destroyed afterwards (e.g. a type that holds only a pointer to its heap allocated state).
+// The trivially copyable types are trivially relocatable, other types can specialize the trait.
+template <typename T>
+struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>>
+{
+};
+
+// A var is relocatable with a single memcpy, if its instance is, if its borrow manager does not depend on its address while not borrowed,
+// and if the instance has no hooks to be called. Containers of vars can query it to relocate their elements in bulk.
+template <underlying_type T, borrow_manager TBorrowManager>
+struct is_trivially_relocatable<var<T, TBorrowManager>>
+    : std::bool_constant<is_trivially_relocatable<std::remove_cv_t<T>>::value && relocatable_when_unborrowed<TBorrowManager> &&
+                         !has_post_constructor<T, TBorrowManager> && !has_pre_destructor<T>>
+{
+};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<std::remove_cv_t<T>>::value;
+
+// Moves the var from the source into the raw storage at the destination, the lifetime of the source ends (it must not be destroyed).
+// The source must not be borrowed, otherwise the dangling reference panic of its borrow manager is raised.
+// A trivially relocatable T is copied bitwise under a new borrow manager, and its pre_destructor() and post_constructor() hooks are called,
+// if T declares them. Otherwise the var is move constructed into the destination, and the source is destroyed.
+// Returns the var at the destination.
+template <underlying_type T, borrow_manager TBorrowManager>
+var<T, TBorrowManager> *relocate(var<T, TBorrowManager> *source, void *destination) noexcept;
+
+// Relocates the count vars from the first one into the raw storage at the destination, the ranges must not overlap.
+// A trivially relocatable var is relocated by a single memcpy, after each source was checked not to be borrowed.
+template <underlying_type T, borrow_manager TBorrowManager>
+var<T, TBorrowManager> *relocate_n(var<T, TBorrowManager> *first, std::size_t count, void *destination) noexcept;
+
+}  // namespace saam
+
+#include <saam/detail/relocate.ipp>
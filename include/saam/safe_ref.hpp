@@ -5,4 +5,5 @@
 #pragma once
 
 #include <saam/ref.hpp>
+#include <saam/scoped_ref.hpp>
 #include <saam/var.hpp>
@@ -0,0 +1,83 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/borrow_manager_traits.hpp>
+
+#include <type_traits>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+template <underlying_type T, borrow_manager TBorrowManager>
+class ref;
+
+// Child borrow of a smart reference: it is valid as long as the parent smart reference is alive.
+// The parent ref keeps the var borrowed, so the scoped_ref does not register itself in the borrow manager,
+// creating and copying it costs the same as a raw pointer.
+// Against the most common mistakes with the lifetime of its parent:
+//  - it can be created only from a named (lvalue) parent, never from a temporary ref
+//  - it cannot be reassigned, nor default constructed
+// The binding is not checked, the scoped_ref dangles unnoticed when its parent is destroyed, reassigned or moved from before it.
+// Use it as a function parameter or as a local variable, do not store it (use a ref for that).
+template <underlying_type T>
+class scoped_ref
+{
+  public:
+    using type_t = T;
+
+    // Child borrow of a smart reference
+    template <underlying_type TOther, borrow_manager TBorrowManager>
+        requires std::is_convertible_v<TOther *, T *>
+    scoped_ref(const ref<TOther, TBorrowManager> &parent) noexcept;
+
+    // A temporary parent would die before the child borrow
+    template <underlying_type TOther, borrow_manager TBorrowManager>
+        requires std::is_convertible_v<TOther *, T *>
+    scoped_ref(const ref<TOther, TBorrowManager> &&parent) = delete;
+
+    // Child borrow of another child borrow - it is bound to the same parent
+    template <underlying_type TOther>
+        requires std::is_convertible_v<TOther *, T *>
+    scoped_ref(const scoped_ref<TOther> &other) noexcept;
+
+    scoped_ref(const scoped_ref &other) noexcept = default;
+
+    // No rebinding, the binding to the parent shall stay obvious
+    scoped_ref &operator=(const scoped_ref &other) = delete;
+
+    ~scoped_ref() noexcept = default;
+
+    // Equality of references, not the underlying objects --> similar to smart pointers
+    [[nodiscard]] bool operator==(const scoped_ref &other) const noexcept;
+
+    [[nodiscard]] bool operator!=(const scoped_ref &other) const noexcept;
+
+    // Arrow operator
+    [[nodiscard]] T *operator->() const noexcept;
+
+    // Dereference operator
+    [[nodiscard]] T &operator*() const noexcept;
+
+    // Cast to T reference
+    [[nodiscard]] explicit operator T &() const noexcept;
+
+    // Cast to T pointer
+    [[nodiscard]] explicit operator T *() const noexcept;
+
+  private:
+    template <underlying_type TOther>
+    friend class scoped_ref;
+
+    T *instance_;
+};
+
+// Deduction guide
+template <underlying_type T, borrow_manager TBorrowManager>
+scoped_ref(ref<T, TBorrowManager>) -> scoped_ref<T>;
+
+}  // namespace saam
+
+#include <saam/detail/scoped_ref.ipp>
@@ -0,0 +1,97 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/synchronized.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+// Default number of shards of a sharded_synchronized
+#ifndef SAAM_SHARD_COUNT
+#define SAAM_SHARD_COUNT 16
+#endif
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// Associative container split over independently locked synchronized shards, the shard of a key is selected by its hash.
+// The guards of disjoint keys usually lock different shards, so they do not wait for each other.
+// The shards have the full container interface, a key can be looked up only in its own shard (see commence and commence_mut).
+template <typename TContainer, std::size_t TShardCount = SAAM_SHARD_COUNT, lock_policy TLockPolicy = default_lock_policy,
+          typename THash = std::hash<typename TContainer::key_type>>
+    requires(!std::is_const_v<TContainer> && TShardCount > 0)
+class sharded_synchronized
+{
+  public:
+    using container_t = TContainer;
+    using key_t = typename TContainer::key_type;
+    using lock_policy_t = TLockPolicy;
+    using shard_t = synchronized<TContainer, TLockPolicy>;
+
+    static constexpr std::size_t shard_count = TShardCount;
+
+    sharded_synchronized() = default;
+
+    explicit sharded_synchronized(THash hash);
+
+    // The guards refer to the shards, so the container is neither copied, nor moved
+    sharded_synchronized(const sharded_synchronized &other) = delete;
+    sharded_synchronized(sharded_synchronized &&other) = delete;
+    sharded_synchronized &operator=(const sharded_synchronized &other) = delete;
+    sharded_synchronized &operator=(sharded_synchronized &&other) = delete;
+
+    ~sharded_synchronized() = default;
+
+    [[nodiscard]] std::size_t shard_index(const key_t &key) const noexcept;
+
+    // Guards of the shard of the key. Holding two of them at the same time can deadlock with the opposite order of another thread,
+    // use commence_all for that.
+    [[nodiscard]] guard<TContainer, TLockPolicy> commence_mut(const key_t &key);
+    [[nodiscard]] guard<const TContainer, TLockPolicy> commence(const key_t &key) const;
+
+    // Non-blocking variants, they return no guard if the shard of the key is locked
+    [[nodiscard]] std::optional<guard<TContainer, TLockPolicy>> try_commence_mut(const key_t &key);
+    [[nodiscard]] std::optional<guard<const TContainer, TLockPolicy>> try_commence(const key_t &key) const;
+
+    // Guards of all the shards in the shard order, for the rare operations on the whole container.
+    // The shards are locked in the order of their addresses like in commence_all, so the whole container guards cannot deadlock each other.
+    // The calling thread must not hold a guard of a shard.
+    [[nodiscard]] std::vector<guard<TContainer, TLockPolicy>> commence_all_mut();
+    [[nodiscard]] std::vector<guard<const TContainer, TLockPolicy>> commence_all() const;
+
+    // Number of elements of all the shards, counted under the immutable guards of all the shards
+    [[nodiscard]] std::size_t size() const;
+
+    // Direct access to a shard, e.g. for iterating the shards one by one without locking the others
+    [[nodiscard]] shard_t &shard(std::size_t index) noexcept;
+    [[nodiscard]] const shard_t &shard(std::size_t index) const noexcept;
+
+  private:
+    // Each shard is on its own cache lines, so the mutexes of the neighbour shards do not falsely share
+    struct alignas(64) padded_shard
+    {
+        shard_t instance;
+    };
+
+    [[nodiscard]] std::vector<shard_t *> shard_addresses() const;
+
+#ifdef _MSC_VER
+    [[msvc::no_unique_address]]
+#else
+    [[no_unique_address]]
+#endif
+    THash hash_;
+    std::array<padded_shard, TShardCount> shards_;
+};
+
+}  // namespace saam
+
+#include <saam/detail/sharded_synchronized.ipp>
@@ -5,25 +5,63 @@
 #pragma once
 
 #include <saam/guard.hpp>
+#include <saam/lock_policy.hpp>
 #include <saam/safe_ref.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <numeric>
 #include <optional>
+#include <ranges>
 #include <shared_mutex>
+#include <span>
 #include <tuple>
 #include <type_traits>
+#include <typeinfo>
 #include <utility>
+#include <vector>
 
-namespace saam
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
+
+// The user may define this function to handle a commence_all, which requests the same synchronized more than once,
+// but not only for immutable guards of a shared lock policy. Such a request would deadlock the calling thread.
+// After returning from this function, the process will be aborted.
+using commence_all_duplicate_panic_t = std::function<void(const std::type_info &synchronized_type, void *synchronized_instance)>;
+inline commence_all_duplicate_panic_t commence_all_duplicate_panic;
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+class synchronized;
+
+namespace detail
+{
+template <typename... T, lock_policy... TLockPolicy, std::size_t... Index>
+auto commence_all_in_order(std::index_sequence<Index...>, synchronized<std::remove_const_t<T>, TLockPolicy> &...syncs);
+
+template <typename T, lock_policy TLockPolicy>
+std::vector<guard<T, TLockPolicy>> commence_all_in_order(std::span<synchronized<std::remove_const_t<T>, TLockPolicy> *const> syncs);
+}  // namespace detail
+
 // Synchronized owns an instance of T and provides a thread-safe way to access it.
 // The lifetime of T is bound to the lifetime of the synchronized.
-template <typename T>
+// The lock policy defines the mutex and the locks of the guards (see lock_policy.hpp).
+template <typename T, lock_policy TLockPolicy = default_lock_policy>
     requires(!std::is_const_v<T>)  // Only mutable types need synchronization
 class synchronized
 {
   public:
-    using mutex_t = std::shared_mutex;
+    using lock_policy_t = TLockPolicy;
+    using mutex_t = typename TLockPolicy::mutex_t;
     using data_type_t = T;
 
     synchronized();
@@ -49,25 +87,103 @@ class synchronized
 
     // No race condition is possible during destruction
     // If another thread is in the class then it must have a smart reference (ref instance),
-    // so the smart owner (var instance) does not let wrapped the synchronized deleted destructed
+    // so the smart owner (var instance) does not let wrapped the synchronized deleted destructed.
+    // The guards do not borrow the protected instance, a guard that is still alive (holds the mutex) triggers the dangling guard panic.
     ~synchronized();
 
     // All borrowings are const operations, because borrowing just provides access to the underlying object - does not change the managed
     // wrapper.
 
     // Mutable unique lock
-    [[nodiscard]] guard<T> commence_mut();
+    [[nodiscard]] guard<T, TLockPolicy> commence_mut();
+
+    // Immutable shared lock, or unique lock with an exclusive lock policy
+    [[nodiscard]] guard<const T, TLockPolicy> commence() const;
+
+    // Non-blocking variants, they return no guard if the lock is not available right away
+    [[nodiscard]] std::optional<guard<T, TLockPolicy>> try_commence_mut();
+    [[nodiscard]] std::optional<guard<const T, TLockPolicy>> try_commence() const;
+
+    // Timed variants, they return no guard if the lock is not acquired in time
+    template <typename TRep, typename TPeriod>
+    [[nodiscard]] std::optional<guard<T, TLockPolicy>> try_commence_mut_for(const std::chrono::duration<TRep, TPeriod> &timeout)
+        requires timed_lock_policy<TLockPolicy>;
+
+    template <typename TClock, typename TDuration>
+    [[nodiscard]] std::optional<guard<T, TLockPolicy>> try_commence_mut_until(const std::chrono::time_point<TClock, TDuration> &deadline)
+        requires timed_lock_policy<TLockPolicy>;
+
+    template <typename TRep, typename TPeriod>
+    [[nodiscard]] std::optional<guard<const T, TLockPolicy>> try_commence_for(const std::chrono::duration<TRep, TPeriod> &timeout) const
+        requires timed_lock_policy<TLockPolicy>;
+
+    template <typename TClock, typename TDuration>
+    [[nodiscard]] std::optional<guard<const T, TLockPolicy>> try_commence_until(
+        const std::chrono::time_point<TClock, TDuration> &deadline) const
+        requires timed_lock_policy<TLockPolicy>;
+
+    // Immutable guard with the upgrade right, it can be upgraded to a mutable guard without unlocking in between
+    [[nodiscard]] upgrade_guard<T, TLockPolicy> commence_upgradable()
+        requires upgradable_lock_policy<TLockPolicy>;
+
+    // Waits until the predicate - called with const T & - is satisfied, the predicate is rechecked after each modification.
+    // The mutable guards notify the waiters on release, only when they accessed the protected instance.
+    template <std::predicate<const T &> TPredicate>
+    [[nodiscard]] guard<const T, TLockPolicy> commence_when(TPredicate predicate) const;
+
+    template <std::predicate<const T &> TPredicate>
+    [[nodiscard]] guard<T, TLockPolicy> commence_mut_when(TPredicate predicate);
 
-    // Immutable shared lock
-    [[nodiscard]] guard<const T> commence() const;
+    // Timed variants, they return no guard if the predicate is not satisfied in time
+    template <typename TRep, typename TPeriod, std::predicate<const T &> TPredicate>
+    [[nodiscard]] std::optional<guard<const T, TLockPolicy>> commence_when_for(const std::chrono::duration<TRep, TPeriod> &timeout,
+                                                                               TPredicate predicate) const;
+
+    template <typename TClock, typename TDuration, std::predicate<const T &> TPredicate>
+    [[nodiscard]] std::optional<guard<const T, TLockPolicy>> commence_when_until(
+        const std::chrono::time_point<TClock, TDuration> &deadline, TPredicate predicate) const;
+
+    template <typename TRep, typename TPeriod, std::predicate<const T &> TPredicate>
+    [[nodiscard]] std::optional<guard<T, TLockPolicy>> commence_mut_when_for(const std::chrono::duration<TRep, TPeriod> &timeout,
+                                                                             TPredicate predicate);
+
+    template <typename TClock, typename TDuration, std::predicate<const T &> TPredicate>
+    [[nodiscard]] std::optional<guard<T, TLockPolicy>> commence_mut_when_until(const std::chrono::time_point<TClock, TDuration> &deadline,
+                                                                               TPredicate predicate);
+
+    // Lock-free copy of the protected instance, it is retried when a writer interleaved.
+    // The readers do not write the shared memory: neither the mutex, nor the borrow manager of the protected instance.
+    [[nodiscard]] T snapshot() const
+        requires(optimistic_lock_policy<TLockPolicy> && std::is_trivially_copyable_v<T>);
+
+    // Awaitable variants for coroutines, they need an awaitable mutex (see async_mutex.hpp): co_await yields the guard.
+    // The coroutine is suspended while the lock is not available, and it is resumed by the executor, when the lock is handed over to it.
+    // The suspended coroutines are queued in the mutex, so destroying the synchronized under them triggers the dangling guard panic.
+    template <typename TExecutor>
+    [[nodiscard]] auto async_commence_mut(TExecutor executor)
+        requires requires(mutex_t &mutex) { mutex.async_lock(executor); };
+
+    template <typename TExecutor>
+    [[nodiscard]] auto async_commence(TExecutor executor) const
+        requires requires(mutex_t &mutex) { mutex.async_lock_shared(executor); };
+
+    // Calls the function with the mutable instance under the lock, and returns its result (it must not refer into the instance).
+    // With a combining lock policy, the threads finding the lock held publish their calls, and the thread holding the lock executes them,
+    // the calls of the same thread are executed in order (see combining_lock_policy.hpp). Otherwise it is the same as a commence_mut().
+    template <std::invocable<T &> TFunction>
+    std::invoke_result_t<TFunction &, T &> apply(TFunction &&function);
+
+    // Contention profile of this instance, only with a profiled lock policy (see profiled_lock_policy.hpp)
+    [[nodiscard]] auto &profile() const
+        requires requires(const mutex_t &mutex) { mutex.profile(); };
 
     // During the access to the underlying object, there must be a temporary smart reference. The lifetime of the temporary smart reference
     // starts before the operator-> is called and ends well after the call is completed. Without this, we use the underlying object without
     // administrating it in the borrow manager and a parallel destruction of the var would NOT consider this access for the final reference
     // check. The first operator-> provides a temporary smart reference. Then the call into the underlying object is done via the smart
     // reference's operator->. The two operators-> are collapsed into one operator-> by the C++ compiler.
-    [[nodiscard]] guard<T> operator->();
-    [[nodiscard]] guard<const T> operator->() const;
+    [[nodiscard]] guard<T, TLockPolicy> operator->();
+    [[nodiscard]] guard<const T, TLockPolicy> operator->() const;
 
     // Assignment from underlying type - internally uses the mutable guard
     synchronized &operator=(const T &instance);
@@ -77,81 +193,297 @@ class synchronized
     [[nodiscard]] operator T &() const = delete;
 
   private:
-    template <typename TOther>
+    template <typename TOther, lock_policy TOtherLockPolicy>
         requires(!std::is_const_v<TOther>)
     friend class synchronized;
 
-    template <typename TOther>
+    template <typename TOther, lock_policy TOtherLockPolicy>
     friend class guard;
 
-    mutable mutex_t mutex_;
+    template <typename TOther, lock_policy TOtherLockPolicy>
+    friend class upgrade_guard;
+
+    // A profiled mutex is tagged with the protected type
+    [[nodiscard]] static mutex_t make_mutex();
+    mutable mutex_t mutex_ = make_mutex();
 
     // When a synchronized instance is released in a locked state, the outstanding locks contain invalid reference.
-    // This case shall trigger a panic.
+    // This case shall trigger the dangling guard panic.
     var<T> protected_instance_;
+    // The live guards, they are verified at the destruction instead of probing the mutex
+#ifdef _MSC_VER
+    [[msvc::no_unique_address]]
+#else
+    [[no_unique_address]]
+#endif
+    detail::guard_counter<> guard_counter_;
 
-    template <typename... TOther>
-    friend auto commence_all(synchronized<std::remove_const_t<TOther>> &...syncs);
+    // Awaits the lock of the mutex, and wraps the acquired lock into a guard
+    template <typename TGuarded, typename TLockAwaiter>
+    class guard_awaiter
+    {
+      public:
+        guard_awaiter(const synchronized &owner, TLockAwaiter lock_awaiter) :
+            owner_(owner),
+            lock_awaiter_(std::move(lock_awaiter)),
+            token_(owner.guard_counter_)
+        {
+        }
+
+        [[nodiscard]] bool await_ready()
+        {
+            return lock_awaiter_.await_ready();
+        }
+
+        template <typename TPromise>
+        auto await_suspend(std::coroutine_handle<TPromise> coroutine)
+        {
+            return lock_awaiter_.await_suspend(coroutine);
+        }
+
+        [[nodiscard]] guard<TGuarded, TLockPolicy> await_resume()
+        {
+            lock_awaiter_.await_resume();
+            return guard<TGuarded, TLockPolicy>(owner_.instance(), typename guard<TGuarded, TLockPolicy>::lock_t(owner_.mutex_, std::adopt_lock),
+                                                std::move(token_));
+        }
+
+      private:
+        const synchronized &owner_;
+        TLockAwaiter lock_awaiter_;
+        // The suspended coroutine counts as a guard already, the lock may be handed over to it any time
+#ifdef _MSC_VER
+        [[msvc::no_unique_address]]
+#else
+        [[no_unique_address]]
+#endif
+        detail::guard_token<> token_;
+    };
+
+    // The protected instance without borrowing it, the guards are protected by the lock instead of a borrow
+    [[nodiscard]] T *instance() const noexcept;
+
+    // A guard outliving the synchronized would refer to the destroyed instance, the live guards are counted
+    void verify_dangling_guards() noexcept;
+
+    // Building block of the try_commence variants, the lock arguments follow the locks of the standard library
+    template <typename TGuarded, typename... TLockArgs>
+    [[nodiscard]] std::optional<guard<TGuarded, TLockPolicy>> try_commence_as(TLockArgs &&...lock_args) const;
+
+    // Building block of the commence_when variants, the predicate does not count as a modification of a mutable guard
+    template <typename TGuarded, typename TWait>
+    [[nodiscard]] std::optional<guard<TGuarded, TLockPolicy>> commence_as_when(TWait wait) const;
+
+    // Building blocks of commence_all, TGuarded is T or const T
+    template <typename TGuarded>
+    [[nodiscard]] typename guard<TGuarded, TLockPolicy>::lock_t lock_as() const;
+
+    template <typename TGuarded>
+    [[nodiscard]] guard<TGuarded, TLockPolicy> make_guard_as(typename guard<TGuarded, TLockPolicy>::lock_t lock) const;
+
+    // The guards of a synchronized requested more than once by a commence_all share a single lock (only immutable guards of a shared lock policy),
+    // the type erased shared lock is null for the other guards
+    template <typename TGuarded>
+    [[nodiscard]] static std::shared_ptr<void> share_lock_as(typename guard<TGuarded, TLockPolicy>::lock_t lock);
+
+    template <typename TGuarded>
+    [[nodiscard]] guard<TGuarded, TLockPolicy> make_guard_as(typename guard<TGuarded, TLockPolicy>::lock_t lock,
+                                                             const std::shared_ptr<void> &shared_lock) const;
+
+    template <typename... TOther, lock_policy... TOtherLockPolicy, std::size_t... Index>
+    friend auto detail::commence_all_in_order(std::index_sequence<Index...>,
+                                              synchronized<std::remove_const_t<TOther>, TOtherLockPolicy> &...syncs);
+
+    template <typename TOther, lock_policy TOtherLockPolicy>
+    friend std::vector<guard<TOther, TOtherLockPolicy>> detail::commence_all_in_order(
+        std::span<synchronized<std::remove_const_t<TOther>, TOtherLockPolicy> *const> syncs);
 };
 
-template <typename... T>
-auto commence_all(synchronized<std::remove_const_t<T>> &...syncs)
+namespace detail
+{
+
+// Sorts the positions of the mutexes by their addresses, equal addresses (the same synchronized) keep their argument order
+template <typename TPositions, typename TMutexes>
+void sort_by_lock_order(TPositions &order, const TMutexes &mutexes)
+{
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&mutexes](std::size_t lhs, std::size_t rhs) {
+        return std::less<const void *>{}(mutexes[lhs], mutexes[rhs]);
+    });
+}
+
+// Only the immutable guards of a shared lock policy can share the lock of the same synchronized, any other duplicate would deadlock
+inline void verify_lock_order_duplicate(bool shareable, const std::type_info &synchronized_type, void *synchronized_instance) noexcept
+{
+    if (!shareable)
+    {
+        if (commence_all_duplicate_panic)
+        {
+            commence_all_duplicate_panic(synchronized_type, synchronized_instance);
+        }
+        std::abort();
+    }
+}
+
+// Finds the requests of the same synchronized in the lock order: each request gets the index of the first request of its synchronized (the
+// leader, which takes the lock), and the leaders are marked, which are requested more than once
+template <typename TPositions, typename TMutexes, typename TFlags>
+void find_lock_leaders(const TPositions &order, const TMutexes &mutexes, TPositions &leaders, TFlags &duplicated)
 {
-    // This function can hang forever if the same synchronized object is passed more than once in an incompatible way,
-    // for example; a caller requests two mutable guards on the same object
-    while (true)
+    for (std::size_t position = 0; position < order.size(); position++)
     {
+        const std::size_t index = order[position];
+        const bool duplicate = position > 0 && mutexes[order[position - 1]] == mutexes[index];
+        leaders[index] = duplicate ? leaders[order[position - 1]] : index;
+        if (duplicate)
         {
-            // Try acquiring all locks into a tuple without blocking.
-            bool all_guards_acquired = true;
-            auto maybe_guards = std::make_tuple([&](const auto &sync) -> std::optional<guard<T>> {
-                if constexpr (std::is_const_v<T>)
-                {
-                    std::shared_lock lock(sync.mutex_, std::try_to_lock);
-                    if (lock.owns_lock())
-                    {
-                        return guard<T>(ref<T>(sync.protected_instance_), std::move(lock));
-                    }
-                }
-                else
-                {
-                    std::unique_lock lock(sync.mutex_, std::try_to_lock);
-                    if (lock.owns_lock())
-                    {
-                        return guard<T>(ref<T>(sync.protected_instance_), std::move(lock));
-                    }
-                }
-
-                all_guards_acquired = false;
-                return std::nullopt;
-            }(syncs)...);
-
-            if (all_guards_acquired)
-            {
-                // Strip the std::optional and keep only the guards
-                return std::apply([](auto &&...optionals) { return std::make_tuple(std::move(optionals.value())...); }, maybe_guards);
-            }
-
-            // The guards are not complete (failed to acquire them all), release them all here
+            duplicated[leaders[index]] = true;
         }
+    }
+}
 
-        // Let's probe the locks and wait for the ones, which are not available. This avoids a busy wait retry.
-        // Try to acquire the locks one by one with blocking to see if it is time to try to acquire them all again.
-        // Acquire them only one at a time (do not keep the guard) - so no race condition can happen.
-        // After a probing round, let's try to acquire them all again.
-        (..., [](const auto &sync) {
-            if constexpr (std::is_const_v<T>)
-            {
-                sync.mutex_.lock_shared();
-                sync.mutex_.unlock_shared();
-            }
-            else
-            {
-                sync.mutex_.lock();
-                sync.mutex_.unlock();
-            }
-        }(syncs));
+template <typename... T, lock_policy... TLockPolicy, std::size_t... Index>
+auto commence_all_in_order(std::index_sequence<Index...>, synchronized<std::remove_const_t<T>, TLockPolicy> &...syncs)
+{
+    constexpr std::size_t num_syncs = sizeof...(T);
+    constexpr std::array<bool, num_syncs> shareable{(std::is_const_v<T> && TLockPolicy::is_shared)...};
+    const std::array<const void *, num_syncs> mutexes{static_cast<const void *>(&syncs.mutex_)...};
+    const std::array<void *, num_syncs> instances{static_cast<void *>(&syncs)...};
+    const std::array<const std::type_info *, num_syncs> types{&typeid(syncs)...};
+
+    std::tuple<typename guard<T, TLockPolicy>::lock_t...> locks;
+    std::array<std::size_t, num_syncs> order;
+    sort_by_lock_order(order, mutexes);
+    std::array<std::size_t, num_syncs> leaders;
+    std::array<bool, num_syncs> duplicated{};
+    find_lock_leaders(order, mutexes, leaders, duplicated);
+
+    for (const std::size_t index : order)
+    {
+        if (leaders[index] != index)
+        {
+            verify_lock_order_duplicate(shareable[leaders[index]] && shareable[index], *types[index], instances[index]);
+            continue;
+        }
+
+        // Lock the synchronized at the runtime index, once per synchronized
+        ((Index == index ? void(std::get<Index>(locks) = syncs.template lock_as<T>()) : void()), ...);
     }
+
+    std::array<std::shared_ptr<void>, num_syncs> shared_locks;
+    ((duplicated[Index] ? void(shared_locks[Index] = syncs.template share_lock_as<T>(std::move(std::get<Index>(locks)))) : void()), ...);
+
+    return std::make_tuple(syncs.template make_guard_as<T>(std::move(std::get<Index>(locks)), shared_locks[leaders[Index]])...);
+}
+
+template <typename T, lock_policy TLockPolicy>
+std::vector<guard<T, TLockPolicy>> commence_all_in_order(std::span<synchronized<std::remove_const_t<T>, TLockPolicy> *const> syncs)
+{
+    constexpr bool shareable = std::is_const_v<T> && TLockPolicy::is_shared;
+    using synchronized_t = synchronized<std::remove_const_t<T>, TLockPolicy>;
+
+    std::vector<const void *> mutexes;
+    mutexes.reserve(syncs.size());
+    for (const auto *sync : syncs)
+    {
+        mutexes.push_back(&sync->mutex_);
+    }
+
+    std::vector<typename guard<T, TLockPolicy>::lock_t> locks(syncs.size());
+    std::vector<std::size_t> order(syncs.size());
+    sort_by_lock_order(order, mutexes);
+    std::vector<std::size_t> leaders(syncs.size());
+    std::vector<bool> duplicated(syncs.size());
+    find_lock_leaders(order, mutexes, leaders, duplicated);
+
+    for (const std::size_t index : order)
+    {
+        if (leaders[index] != index)
+        {
+            verify_lock_order_duplicate(shareable, typeid(synchronized_t), syncs[index]);
+            continue;
+        }
+        locks[index] = syncs[index]->template lock_as<T>();
+    }
+
+    std::vector<std::shared_ptr<void>> shared_locks(syncs.size());
+    for (std::size_t index = 0; index < syncs.size(); index++)
+    {
+        if (duplicated[index])
+        {
+            shared_locks[index] = synchronized_t::template share_lock_as<T>(std::move(locks[index]));
+        }
+    }
+
+    std::vector<guard<T, TLockPolicy>> guards;
+    guards.reserve(syncs.size());
+    for (std::size_t index = 0; index < syncs.size(); index++)
+    {
+        guards.push_back(syncs[index]->template make_guard_as<T>(std::move(locks[index]), shared_locks[leaders[index]]));
+    }
+    return guards;
+}
+
+// Address of the synchronized an element of a range refers to: the element itself, a pointer or a std::reference_wrapper
+template <typename TElement>
+[[nodiscard]] auto *synchronized_address(TElement &&element) noexcept
+{
+    if constexpr (std::is_pointer_v<std::remove_cvref_t<TElement>>)
+    {
+        return element;
+    }
+    else if constexpr (requires { element.get(); })
+    {
+        return &element.get();
+    }
+    else
+    {
+        return &element;
+    }
+}
+
+template <typename TSynchronized, typename T>
+inline constexpr bool is_synchronized_of_v = false;
+
+template <typename T, lock_policy TLockPolicy>
+inline constexpr bool is_synchronized_of_v<synchronized<T, TLockPolicy>, T> = true;
+
+template <typename TRange>
+using range_synchronized_t = std::remove_pointer_t<decltype(synchronized_address(std::declval<std::ranges::range_reference_t<TRange>>()))>;
+
+// The elements of the range refer to synchronized instances of T
+template <typename TRange, typename T>
+concept synchronized_range_of = std::ranges::input_range<TRange> && is_synchronized_of_v<range_synchronized_t<TRange>, T>;
+
+}  // namespace detail
+
+// The T types are given explicitly (const T for an immutable guard), the lock policies are deduced from the synchronized instances.
+// The mutexes are locked in the order of their addresses, so concurrent commence_all calls cannot deadlock each other,
+// and each mutex is waited for at most once.
+// The same synchronized can be passed more than once only for immutable guards with a shared lock policy, its shared lock is taken
+// once, and the guards of it share that lock until the last of them is released. Any other duplicate triggers the commence_all_duplicate_panic.
+template <typename... T, lock_policy... TLockPolicy>
+auto commence_all(synchronized<std::remove_const_t<T>, TLockPolicy> &...syncs)
+{
+    return detail::commence_all_in_order<T...>(std::index_sequence_for<T...>{}, syncs...);
+}
+
+// Runtime sized variant of commence_all, the T is given explicitly (const T for immutable guards).
+// The range contains synchronized instances, pointers or std::reference_wrappers to them, the guards are returned in the range order.
+// The locking order and the duplicate handling is the same as for the variadic commence_all.
+template <typename T, typename TRange>
+    requires detail::synchronized_range_of<TRange, std::remove_const_t<T>>
+auto commence_all(TRange &&syncs)
+{
+    using synchronized_t = detail::range_synchronized_t<TRange>;
+
+    std::vector<synchronized_t *> addresses;
+    for (auto &&element : syncs)
+    {
+        addresses.push_back(detail::synchronized_address(element));
+    }
+
+    return detail::commence_all_in_order<T, typename synchronized_t::lock_policy_t>(std::span<synchronized_t *const>(addresses));
 }
 
 }  // namespace saam
@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/abi.hpp>
+
+#include <atomic>
+#include <concepts>
+#include <type_traits>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// The type fits into a lock-free std::atomic on every target, e.g. an integer, a pointer or a small flag struct
+template <typename T>
+concept lock_free_atomic =
+    !std::is_const_v<T> && std::is_trivially_copyable_v<T> && std::is_copy_constructible_v<T> && std::atomic<T>::is_always_lock_free;
+
+// Sibling of synchronized for the lock-free atomic types: the instance is reachable only through the wrapper, like with synchronized,
+// but there is no mutex and no borrow managed var - the instance can only be read and replaced as a whole, at the cost of an atomic.
+// There is no guard: a function can work on a copy of the instance only, and update() publishes its result atomically.
+// The waiting is opt-in with TWaitable, otherwise the changes do not pay for the notification of the waiters.
+template <lock_free_atomic T, bool TWaitable = false>
+class synchronized_atomic
+{
+  public:
+    using data_type_t = T;
+
+    synchronized_atomic() noexcept;
+    explicit synchronized_atomic(T instance) noexcept;
+
+    // The copy gets a snapshot of the instance of the other
+    synchronized_atomic(const synchronized_atomic &other) noexcept;
+    synchronized_atomic &operator=(const synchronized_atomic &other) noexcept;
+
+    [[nodiscard]] T load(std::memory_order order = std::memory_order_seq_cst) const noexcept;
+    void store(T instance, std::memory_order order = std::memory_order_seq_cst) noexcept;
+    // Returns the replaced instance
+    T exchange(T instance, std::memory_order order = std::memory_order_seq_cst) noexcept;
+
+    // Replaces the instance with the desired one, if it equals the expected one (bitwise), otherwise the expected is set to the current instance
+    bool compare_exchange(T &expected, T desired, std::memory_order order = std::memory_order_seq_cst) noexcept;
+
+    // Replaces the instance with the result of the function called with the current instance, in a compare-and-swap loop.
+    // The function may be called more than once (when another thread updated the instance meanwhile), so it shall not have side effects.
+    // Returns the new instance.
+    template <typename TFunction>
+        requires std::is_invocable_r_v<T, TFunction &, T>
+    T update(TFunction &&function, std::memory_order order = std::memory_order_seq_cst);
+
+    // Blocks until the instance differs from the old one (bitwise), the instance is changed by store(), exchange(), compare_exchange()
+    // and update(), they wake the waiters
+    void wait(T old, std::memory_order order = std::memory_order_seq_cst) const noexcept
+        requires TWaitable;
+
+    // No direct access to the instance
+    operator T &() = delete;
+    operator const T &() const = delete;
+
+  private:
+    void notify_waiters() noexcept;
+
+    std::atomic<T> instance_;
+};
+
+}  // namespace saam
+
+#include <saam/detail/synchronized_atomic.ipp>
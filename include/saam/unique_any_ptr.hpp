@@ -0,0 +1,181 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/any_ptr.hpp>
+#include <saam/safe_ref.hpp>
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// Move-only type erased pointer: it refers to an instance of T, and owns whatever the instance is borrowed from (a unique_ptr, a var, ...).
+// An exclusive dependency costs no reference counting, the owner is moved and never copied.
+// Convert it into a copyable any_ptr with share(), when the dependency shall be shared.
+template <typename T>
+class unique_any_ptr
+{
+  private:
+    T *ptr_ = nullptr;
+    detail::unique_any_ptr_owner owner_;
+
+    template <typename U>
+    friend class unique_any_ptr;
+
+    template <typename U, typename TBorrowManager>
+    friend unique_any_ptr<U> make_unique_any_ptr(saam::var<U, TBorrowManager> &&var);
+
+  public:
+    unique_any_ptr() = default;
+
+    // Non-owning, the instance must outlive the unique_any_ptr
+    explicit unique_any_ptr(T *ptr) noexcept :
+        ptr_(ptr)
+    {
+    }
+
+    // The owner keeps the instance alive, e.g. a unique_ptr or a ref to it. The instance must not move, when the owner moves.
+    template <typename TOwner>
+        requires std::is_move_constructible_v<std::remove_cvref_t<TOwner>>
+    unique_any_ptr(T *ptr, TOwner &&owner) :
+        ptr_(ptr)
+    {
+        owner_.template emplace<std::remove_cvref_t<TOwner>>(std::forward<TOwner>(owner));
+    }
+
+    unique_any_ptr(const unique_any_ptr &other) = delete;
+
+    unique_any_ptr(unique_any_ptr &&other) noexcept :
+        ptr_(std::exchange(other.ptr_, nullptr)),
+        owner_(std::move(other.owner_))
+    {
+    }
+
+    template <typename U>
+        requires std::is_convertible_v<U *, T *>
+    unique_any_ptr(unique_any_ptr<U> &&other) noexcept :
+        ptr_(std::exchange(other.ptr_, nullptr)),
+        owner_(std::move(other.owner_))
+    {
+    }
+
+    unique_any_ptr &operator=(const unique_any_ptr &other) = delete;
+
+    // Move assignment releases the current owner, and moves the owner of the other one
+    unique_any_ptr &operator=(unique_any_ptr &&other) noexcept
+    {
+        if (this != &other)
+        {
+            ptr_ = std::exchange(other.ptr_, nullptr);
+            owner_ = std::move(other.owner_);
+        }
+        return *this;
+    }
+
+    template <typename U>
+        requires std::is_convertible_v<U *, T *>
+    unique_any_ptr &operator=(unique_any_ptr<U> &&other) noexcept
+    {
+        return *this = unique_any_ptr(std::move(other));
+    }
+
+    ~unique_any_ptr() = default;
+
+    T *operator->() const noexcept
+    {
+        return ptr_;
+    }
+
+    T &operator*() const noexcept
+    {
+        return *ptr_;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return ptr_ != nullptr;
+    }
+
+    bool operator!() const noexcept
+    {
+        return ptr_ == nullptr;
+    }
+
+    void reset() noexcept
+    {
+        ptr_ = nullptr;
+        owner_.reset();
+    }
+
+    // The owner is moved into a shared_ptr (a single allocation), which is shared by the copies of the returned any_ptr
+    [[nodiscard]] any_ptr<T> share() &&
+    {
+        if (!owner_.has_value())
+        {
+            return any_ptr<T>(std::exchange(ptr_, nullptr));
+        }
+
+        auto shared_owner = std::make_shared<detail::unique_any_ptr_owner>(std::move(owner_));
+        return any_ptr<T>(std::exchange(ptr_, nullptr), std::move(shared_owner));
+    }
+};
+
+// Raw unique_any_ptr factory function
+template <typename T>
+auto make_unique_any_ptr(T &instance)
+{
+    return unique_any_ptr<T>(&instance);
+}
+
+template <typename T>
+auto make_unique_any_ptr(T *ptr)
+{
+    return unique_any_ptr<T>(ptr);
+}
+
+// Smart pointer unique_any_ptr factory function, the unique_ptr is stored inline
+template <typename T, typename TDeleter>
+auto make_unique_any_ptr(std::unique_ptr<T, TDeleter> ptr)
+{
+    auto *instance = ptr.get();
+    return unique_any_ptr<T>(instance, std::move(ptr));
+}
+
+template <typename T>
+auto make_unique_any_ptr(std::shared_ptr<T> ptr)
+{
+    auto *instance = ptr.get();
+    return unique_any_ptr<T>(instance, std::move(ptr));
+}
+
+// Smart reference unique_any_ptr factory function, the var is owned by the unique_any_ptr.
+// It is allocated on the heap, so it does not move (and the refs borrowed from it stay valid), when the unique_any_ptr moves.
+template <typename T, typename TBorrowManager>
+unique_any_ptr<T> make_unique_any_ptr(saam::var<T, TBorrowManager> &&var)
+{
+    unique_any_ptr<T> result;
+    auto &owner = result.owner_.template emplace<saam::var<T, TBorrowManager>, true>(std::move(var));
+    result.ptr_ = &(*owner.borrow());
+    return result;
+}
+
+// The var is only borrowed, it must outlive the unique_any_ptr (otherwise the borrow checking panics)
+template <typename T, typename TBorrowManager>
+auto make_unique_any_ptr(saam::var<T, TBorrowManager> &var)
+{
+    return make_unique_any_ptr(var.borrow());
+}
+
+template <typename T, typename TBorrowManager>
+auto make_unique_any_ptr(saam::ref<T, TBorrowManager> ref)
+{
+    auto *instance = &(*ref);
+    return unique_any_ptr<T>(instance, std::move(ref));
+}
+
+}  // namespace saam
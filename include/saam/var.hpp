@@ -4,18 +4,40 @@
 
 #pragma once
 
+#include <saam/borrow_manager_for.hpp>
 #include <saam/detail/borrow_manager_traits.hpp>
-#include <saam/detail/default_borrow_manager.hpp>
+#include <saam/detail/lock_policy_traits.hpp>
 
+#include <cstddef>
+#include <type_traits>
 #include <utility>
 
-namespace saam
+namespace saam::inline SAAM_ABI_NAMESPACE
 {
 
 template <underlying_type T, borrow_manager TBorrowManager>
 class ref;
 
-template <underlying_type T, borrow_manager TBorrowManager = default_borrow_manager_t>
+template <underlying_type T>
+class scoped_ref;
+
+template <typename T>
+    requires(!std::is_const_v<T>)
+class rcu_synchronized;
+
+template <typename T, lock_policy TLockPolicy>
+    requires(!std::is_const_v<T>)
+class synchronized;
+
+template <underlying_type T, borrow_manager TBorrowManager>
+class weak_ref;
+
+namespace detail
+{
+struct var_relocation;
+}  // namespace detail
+
+template <underlying_type T, borrow_manager TBorrowManager = borrow_manager_for_t<T>>
 class var
 {
   public:
@@ -96,6 +118,21 @@ class var
     // reference's operator->. The two operators-> are collapsed into one operator-> by the C++ compiler.
     [[nodiscard]] ref<T, TBorrowManager> operator->() const noexcept;
 
+    // Borrows the underlying object once for the whole call of the function, instead of borrowing it for each operator-> access.
+    // The function receives a scoped_ref (child borrow of the single ref), which is free to create and copy.
+    // Returns the result of the function.
+    template <typename TFunction>
+        requires std::is_invocable_v<TFunction, scoped_ref<T>>
+    decltype(auto) with(TFunction &&function) const;
+
+    // Number of the live references, a snapshot for diagnostics - e.g. to spot a growing pile of refs that pins the var
+    [[nodiscard]] std::size_t num_borrows() const noexcept
+        requires has_num_borrows<TBorrowManager>;
+
+    // The live references grouped by their creation sites (tracked mode)
+    [[nodiscard]] auto borrow_census() const
+        requires has_borrow_census<TBorrowManager>;
+
     // Compare with underlying type
     [[nodiscard]] bool operator==(const T &other) const noexcept;
     [[nodiscard]] bool operator!=(const T &other) const noexcept;
@@ -106,6 +143,8 @@ class var
   private:
     void call_post_constructor() noexcept;
     void call_post_assignment() noexcept;
+    // Constructs a new borrow manager in place, the previous one must have been destroyed (or relocated bitwise)
+    void renew_borrow_manager() noexcept;
 
     template <underlying_type TOther, borrow_manager TOtherBorrowManager>
     friend class var;
@@ -113,6 +152,23 @@ class var
     template <underlying_type TOther, borrow_manager TOtherBorrowManager>
     friend class ref;
 
+    // Reclaims its retired versions, when their borrow managers are not borrowed anymore
+    template <typename TOther>
+        requires(!std::is_const_v<TOther>)
+    friend class rcu_synchronized;
+
+    // Its guards access the instance without borrowing it, they are protected by the lock
+    template <typename TOther, lock_policy TLockPolicy>
+        requires(!std::is_const_v<TOther>)
+    friend class synchronized;
+
+    // Observes the instance via the anchor of its borrow manager
+    template <underlying_type TOther, borrow_manager TOtherBorrowManager>
+    friend class weak_ref;
+
+    // Relocates the instance bitwise, and renews the borrow manager (see relocate.hpp)
+    friend struct detail::var_relocation;
+
     T instance_;
     // if TBorrowManager is unchecked_borrow_manager, this member is optimized away
 #ifdef _MSC_VER
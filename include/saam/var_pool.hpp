@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/safe_ref.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Number of vars in a slab of a var_pool
+#ifndef SAAM_VAR_POOL_SLAB_SIZE
+#define SAAM_VAR_POOL_SLAB_SIZE 256
+#endif
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// Arena of vars: the vars are placed in contiguous slabs, and the slots of the destroyed vars are recycled without
+// going back to the global allocator. Each var can be borrowed individually, just like a standalone var.
+// clear() (and the destructor) tears down all vars in one sequential pass over the slabs, checking their borrows on the way.
+// The pool itself is not thread-safe, it is meant to be owned by a single thread (e.g. per-request state).
+template <underlying_type T, borrow_manager TBorrowManager = borrow_manager_for_t<T>>
+class var_pool
+{
+  public:
+    using var_t = var<T, TBorrowManager>;
+
+    explicit var_pool(std::size_t slab_size = SAAM_VAR_POOL_SLAB_SIZE);
+
+    // The vars do not move, they are referred to by address
+    var_pool(const var_pool &other) = delete;
+    var_pool(var_pool &&other) noexcept = delete;
+    var_pool &operator=(const var_pool &other) = delete;
+    var_pool &operator=(var_pool &&other) noexcept = delete;
+
+    ~var_pool();
+
+    // In-place construction of a var in a free slot, the var lives until it is destroyed or the pool is cleared
+    template <typename... Args>
+    [[nodiscard]] var_t &emplace(Args &&...args);
+
+    // Destroys a var of this pool (with the usual dangling reference check), its slot is reused by the next emplace()
+    void destroy(var_t &var) noexcept;
+
+    // Destroys all vars, the slabs are kept for the reuse
+    void clear() noexcept;
+
+    // Releases the slabs, if there are no vars in the pool
+    void shrink_to_fit();
+
+    // Number of vars in the pool
+    [[nodiscard]] std::size_t size() const noexcept;
+
+    // Number of slots in the slabs
+    [[nodiscard]] std::size_t capacity() const noexcept;
+
+  private:
+    struct slot
+    {
+        // The storage is the first member, so the address of the var is the address of the slot
+        alignas(var_t) std::byte storage[sizeof(var_t)];
+        slot *next_free = nullptr;
+        bool occupied = false;
+
+        var_t &get() noexcept;
+    };
+
+    [[nodiscard]] slot *acquire_slot();
+
+    std::size_t slab_size_;
+    std::vector<std::unique_ptr<slot[]>> slabs_;
+    // Slots of the destroyed vars
+    slot *free_list_ = nullptr;
+    // Slots of the last slab, which were never used
+    std::size_t used_of_last_slab_ = 0;
+    std::size_t size_ = 0;
+};
+
+}  // namespace saam
+
+#include <saam/detail/var_pool.ipp>
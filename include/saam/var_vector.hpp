@@ -0,0 +1,115 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/counted_borrow_manager.hpp>
+#include <saam/detail/unchecked_borrow_manager.hpp>
+#include <saam/safe_ref.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// The user may define this function to handle the structural modification (reallocation, erase, ...) of a borrowed var_vector.
+// The borrowed_index is the first borrowed element that would be moved or destroyed, or npos, if the elements are viewed via with().
+// After returning from this function, the process will be aborted.
+using var_vector_borrowed_panic_t = std::function<void(const std::type_info &element_type, std::size_t borrowed_index)>;
+inline var_vector_borrowed_panic_t var_vector_borrowed_panic;
+
+// The elements are counted (counted_borrow_manager, or a layout variant of it) in the managed modes,
+// because a modification needs to know if they are borrowed
+template <typename T>
+using var_vector_borrow_manager_t =
+    std::conditional_t<std::is_same_v<borrow_manager_for_t<T>, unchecked_borrow_manager>, unchecked_borrow_manager, counted_borrow_manager>;
+
+// Contiguous container of smartly referenced elements. Unlike std::vector<var<T>>, the elements are stored without their borrow managers,
+// which are kept in a separate, compact array: the iteration over the elements has the stride of T, and the reallocation moves only the T's.
+// The elements are borrowed individually. The modifications, which would move or destroy a borrowed element (a reallocation, an erase, ...)
+// panic instead - the handler is var_vector_borrowed_panic.
+// Like std::vector, it is not thread-safe to modify it, while it is used from another thread.
+template <underlying_type T, borrow_manager TBorrowManager = var_vector_borrow_manager_t<T>>
+class var_vector
+{
+  public:
+    static_assert(std::is_same_v<TBorrowManager, unchecked_borrow_manager> ||
+                      requires(const TBorrowManager &borrow_manager) { borrow_manager.is_borrowed(); },
+                  "The borrow manager of the elements must tell if they are borrowed");
+
+    using type_t = T;
+    using borrow_manager_t = TBorrowManager;
+
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    var_vector() = default;
+    explicit var_vector(std::size_t count);
+    var_vector(std::initializer_list<T> values);
+
+    // The copy has its own borrow managers, the borrows are not copied
+    var_vector(const var_vector &other);
+    var_vector(var_vector &&other) noexcept;
+    var_vector &operator=(const var_vector &other);
+    var_vector &operator=(var_vector &&other) noexcept;
+
+    // Panics, if an element is still borrowed
+    ~var_vector();
+
+    // Borrowing is a const operation, like for a var
+    [[nodiscard]] ref<T, TBorrowManager> borrow(std::size_t index) const noexcept;
+    [[nodiscard]] ref<T, TBorrowManager> operator[](std::size_t index) const noexcept;
+
+    // Contiguous view of all elements for the duration of the call, without borrowing them one by one.
+    // The vector cannot be modified structurally during the call. Returns the result of the function.
+    template <typename TFunction>
+        requires std::is_invocable_v<TFunction, std::span<T>>
+    decltype(auto) with(TFunction &&function) const;
+
+    template <typename... Args>
+    ref<T, TBorrowManager> emplace_back(Args &&...args);
+    void push_back(const T &value);
+    void push_back(T &&value);
+    void pop_back() noexcept;
+
+    // Erases the element at the index, the following elements are moved
+    void erase(std::size_t index) noexcept;
+    void clear() noexcept;
+
+    void reserve(std::size_t capacity);
+    void resize(std::size_t size);
+    void shrink_to_fit();
+
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] std::size_t capacity() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+
+  private:
+    static constexpr bool is_checked = !std::is_same_v<TBorrowManager, unchecked_borrow_manager>;
+
+    // Panics, if an element from the index on is borrowed, or the elements are viewed
+    void verify_not_borrowed(std::size_t first) const noexcept;
+    void verify_not_borrowed_before_growing_to(std::size_t size) const noexcept;
+
+    // The borrow managers follow the capacity of the values, they can be replaced only when none of them is borrowed
+    void fit_borrow_managers();
+
+    std::vector<T> values_;
+    std::unique_ptr<TBorrowManager[]> borrow_managers_;
+    std::size_t borrow_managers_capacity_ = 0;
+    // Number of the running with() calls
+    mutable std::atomic<std::size_t> views_ = 0;
+};
+
+}  // namespace saam
+
+#include <saam/detail/var_vector.ipp>
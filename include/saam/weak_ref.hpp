@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <saam/detail/counted_borrow_manager.hpp>
+#include <saam/safe_ref.hpp>
+
+#include <concepts>
+#include <optional>
+#include <type_traits>
+
+namespace saam::inline SAAM_ABI_NAMESPACE
+{
+
+// The borrow manager can be observed by weak_refs, e.g. weak_counted_borrow_manager
+template <typename TBorrowManager>
+concept observable_borrow_manager = requires(const TBorrowManager &borrow_manager) {
+    { borrow_manager.acquire_weak_anchor() } -> std::same_as<detail::counted_weak_anchor *>;
+};
+
+// Observes a var without borrowing it: the var can be destroyed while weak_refs to it exist.
+// lock() upgrades it to a ref, only if the var is still alive. The upgraded ref borrows the var as usual.
+// The var must have an observable borrow manager, e.g. via borrow_manager_for:
+//
+//   template <>
+//   struct saam::borrow_manager_for<session> { using type = saam::weak_counted_borrow_manager; };
+template <underlying_type T, borrow_manager TBorrowManager = borrow_manager_for_t<T>>
+class weak_ref
+{
+  public:
+    static_assert(observable_borrow_manager<TBorrowManager>, "The borrow manager cannot be observed, use e.g. weak_counted_borrow_manager");
+
+    using type_t = T;
+    using borrow_manager_t = TBorrowManager;
+
+    weak_ref() noexcept = default;
+
+    template <underlying_type TOther>
+        requires std::is_convertible_v<TOther *, T *>
+    weak_ref(const var<TOther, TBorrowManager> &other);
+
+    // The ref must be managed (not a legacy ref of an instance)
+    template <underlying_type TOther>
+        requires std::is_convertible_v<TOther *, T *>
+    weak_ref(const ref<TOther, TBorrowManager> &other);
+
+    weak_ref(const weak_ref &other) noexcept;
+    weak_ref(weak_ref &&other) noexcept;
+
+    template <underlying_type TOther>
+        requires std::is_convertible_v<TOther *, T *>
+    weak_ref(const weak_ref<TOther, TBorrowManager> &other) noexcept;
+
+    weak_ref &operator=(const weak_ref &other) noexcept;
+    weak_ref &operator=(weak_ref &&other) noexcept;
+
+    ~weak_ref();
+
+    // A borrow of the var, or empty if the var is already destroyed (or the weak_ref is empty)
+    [[nodiscard]] std::optional<ref<T, TBorrowManager>> lock() const;
+
+    // Exact at the moment of the call, the var may be destroyed right after it
+    [[nodiscard]] bool expired() const;
+
+    void reset() noexcept;
+
+  private:
+    template <underlying_type TOther, borrow_manager TOtherBorrowManager>
+    friend class weak_ref;
+
+    weak_ref(T *instance, TBorrowManager *borrow_manager);
+
+    T *instance_ = nullptr;
+    TBorrowManager *borrow_manager_ = nullptr;
+    detail::counted_weak_anchor *anchor_ = nullptr;
+};
+
+// Deduction guide
+template <underlying_type T, borrow_manager TBorrowManager>
+weak_ref(var<T, TBorrowManager>) -> weak_ref<T, TBorrowManager>;
+
+template <underlying_type T, borrow_manager TBorrowManager>
+weak_ref(ref<T, TBorrowManager>) -> weak_ref<T, TBorrowManager>;
+
+}  // namespace saam
+
+#include <saam/detail/weak_ref.ipp>
@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/borrow_manager_for.hpp>
+#include <saam/detail/sampled_borrow_manager.hpp>
+#include <saam/detail/unchecked_borrow_manager.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <iostream>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace saam::test
+{
+
+struct hot_type
+{
+    int value = 0;
+};
+
+struct suspect_type
+{
+    int value = 0;
+};
+
+}  // namespace saam::test
+
+template <>
+struct saam::borrow_manager_for<saam::test::hot_type>
+{
+    using type = saam::unchecked_borrow_manager;
+};
+
+template <>
+struct saam::borrow_manager_for<saam::test::suspect_type>
+{
+    using type = saam::sampled_borrow_manager;
+};
+
+#include <saam/safe_ref.hpp>
+
+namespace saam::test
+{
+
+static_assert(std::is_same_v<var<int>::borrow_manager_t, default_borrow_manager_t>);
+static_assert(std::is_same_v<var<hot_type>::borrow_manager_t, unchecked_borrow_manager>);
+static_assert(std::is_same_v<ref<const hot_type>::borrow_manager_t, unchecked_borrow_manager>);
+static_assert(std::is_same_v<var<suspect_type>::borrow_manager_t, sampled_borrow_manager>);
+static_assert(sizeof(ref<hot_type>) < sizeof(ref<int>));
+
+TEST(counted_borrow_manager_for_test, const_ref_of_specialized_type)
+{
+    var<hot_type> hot{hot_type{42}};
+    ref<const hot_type> hot_ref = hot.borrow();
+
+    ASSERT_EQ(hot_ref->value, 42);
+}
+
+TEST(counted_borrow_manager_for_test, specialized_type_panics_with_its_own_handler)
+{
+    auto dangling_ref_outlives_var = []() {
+        saam::sampled_creation_stack_rate = 1;
+        saam::sampled_dangling_reference_panic = [](const std::type_info &,
+                                                    void *,
+                                                    std::size_t num_dangling_references,
+                                                    const std::vector<saam::raw_stacktrace> &sampled_ref_creation_stacks) {
+            std::cerr << num_dangling_references << " dangling references, " << sampled_ref_creation_stacks.size() << " sampled\n";
+        };
+
+        std::optional<ref<suspect_type>> suspect_ref;
+        var<suspect_type> suspect;
+        suspect_ref = suspect.borrow();
+    };
+
+    EXPECT_DEATH({ dangling_ref_outlives_var(); }, "1 dangling references, 1 sampled");
+}
+
+}  // namespace saam::test
@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/channel.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+namespace saam::test
+{
+
+TEST(counted_channel_test, push_and_pop_in_order)
+{
+    channel<std::string> messages(3);
+    ASSERT_EQ(messages.capacity(), 4);
+    ASSERT_FALSE(messages.try_pop().has_value());
+
+    for (std::size_t i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(messages.try_push(std::to_string(i)));
+    }
+    // The channel is full
+    ASSERT_FALSE(messages.try_emplace("4"));
+
+    for (std::size_t i = 0; i < 4; i++)
+    {
+        ASSERT_EQ(messages.try_pop(), std::to_string(i));
+    }
+    ASSERT_FALSE(messages.try_pop().has_value());
+}
+
+TEST(counted_channel_test, receive_in_place)
+{
+    channel<std::unique_ptr<int>> messages(2);
+    ASSERT_TRUE(messages.try_emplace(std::make_unique<int>(42)));
+
+    {
+        auto received = messages.try_receive();
+        ASSERT_TRUE(received.has_value());
+        ASSERT_EQ(**received->borrow(), 42);
+
+        // The received message occupies its slot until it is released
+        ASSERT_TRUE(messages.try_emplace(std::make_unique<int>(43)));
+        ASSERT_FALSE(messages.try_emplace(std::make_unique<int>(44)));
+    }
+
+    ASSERT_TRUE(messages.try_emplace(std::make_unique<int>(44)));
+    ASSERT_EQ(*messages.try_pop().value(), 43);
+    ASSERT_EQ(*messages.try_pop().value(), 44);
+}
+
+TEST(counted_channel_test, pending_messages_are_destroyed)
+{
+    auto counter = std::make_shared<int>(0);
+    {
+        channel<std::shared_ptr<int>> messages(4);
+        ASSERT_TRUE(messages.try_push(counter));
+        ASSERT_TRUE(messages.try_push(counter));
+        ASSERT_TRUE(messages.try_push(counter));
+        messages.try_receive()->release();
+        ASSERT_EQ(counter.use_count(), 3);
+    }
+    ASSERT_EQ(counter.use_count(), 1);
+}
+
+TEST(counted_channel_test, parallel_producers_and_consumers)
+{
+    constexpr std::size_t num_threads = 4;
+    constexpr std::size_t num_messages = 20000;
+
+    channel<std::size_t> messages(64);
+    std::atomic<std::size_t> sum = 0;
+    std::atomic<std::size_t> consumed = 0;
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t thread = 0; thread < num_threads; thread++)
+        {
+            threads.emplace_back([&messages, thread]() {
+                for (std::size_t message = thread; message < num_messages; message += num_threads)
+                {
+                    while (!messages.try_push(message))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+            threads.emplace_back([&messages, &sum, &consumed, thread]() {
+                while (consumed.load() < num_messages)
+                {
+                    // Half of the consumers borrow the messages in place
+                    if (thread % 2 == 0)
+                    {
+                        if (auto message = messages.try_pop())
+                        {
+                            sum += *message;
+                            consumed++;
+                        }
+                    }
+                    else if (auto received = messages.try_receive())
+                    {
+                        sum += *received->borrow();
+                        consumed++;
+                    }
+                }
+            });
+        }
+    }
+
+    ASSERT_EQ(sum.load(), num_messages * (num_messages - 1) / 2);
+}
+
+TEST(counted_channel_death_test, ref_outlives_received_message)
+{
+    auto recycle_borrowed_slot = []() {
+        channel<std::string> messages(2);
+        ASSERT_TRUE(messages.try_push("Hello world"));
+
+        std::optional<ref<std::string>> dangling_ref;
+        {
+            auto received = messages.try_receive();
+            dangling_ref = received->borrow();
+        }
+    };
+
+    EXPECT_DEATH({ recycle_borrowed_slot(); }, ".*");
+}
+
+TEST(counted_channel_death_test, channel_destroyed_with_received_message)
+{
+    auto destroy_channel = []() {
+        channel_destroyed_panic = [](const std::type_info &, std::size_t num_received_messages) {
+            std::cerr << num_received_messages << " received\n";
+        };
+
+        std::optional<channel<std::string>::received_message> received;
+        channel<std::string> messages(2);
+        ASSERT_TRUE(messages.try_push("Hello world"));
+        received = messages.try_receive();
+    };
+
+    EXPECT_DEATH({ destroy_channel(); }, "1 received");
+}
+
+}  // namespace saam::test
@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/detail/counted_borrow_manager.hpp>
+#include <saam/safe_ref.hpp>
+#include <saam/var_vector.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace saam::test
+{
+
+// The compact counter packs with small types
+static_assert(sizeof(saam::var<std::uint32_t, saam::compact_counted_borrow_manager>) == 8);
+static_assert(sizeof(saam::var<std::uint32_t, saam::counted_borrow_manager>) == 16);
+
+// The padded counter has its own cache line
+static_assert(alignof(saam::var<std::uint32_t, saam::padded_counted_borrow_manager>) == 64);
+static_assert(sizeof(saam::var<std::uint32_t, saam::padded_counted_borrow_manager>) == 128);
+
+TEST(counted_layout_test, compact_borrow)
+{
+    saam::var<std::uint32_t, saam::compact_counted_borrow_manager> number(41);
+    {
+        saam::ref<std::uint32_t, saam::compact_counted_borrow_manager> number_ref = number;
+        auto copied_ref = number_ref;
+        (*copied_ref)++;
+    }
+    ASSERT_EQ(*number.borrow(), 42);
+
+    saam::var_vector<std::uint32_t, saam::compact_counted_borrow_manager> numbers{1, 2, 3};
+    ASSERT_EQ(*numbers[2], 3);
+}
+
+TEST(counted_layout_test, padded_borrow_from_threads)
+{
+    std::array<saam::var<std::uint64_t, saam::padded_counted_borrow_manager>, 4> counters;
+
+    std::vector<std::thread> threads;
+    for (auto &counter : counters)
+    {
+        counter = 0;
+        threads.emplace_back([&counter]() {
+            for (int i = 0; i < 1000; i++)
+            {
+                (*counter.borrow())++;
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    for (auto &counter : counters)
+    {
+        ASSERT_EQ(*counter.borrow(), 1000);
+    }
+}
+
+TEST(counted_layout_test, compact_dangling_ref_outlives_var)
+{
+    auto dangling_ref_outlives_var = []() {
+        std::optional<saam::ref<std::uint32_t, saam::compact_counted_borrow_manager>> number_ref;
+        saam::var<std::uint32_t, saam::compact_counted_borrow_manager> number(5);
+        number_ref = number;
+    };
+
+    EXPECT_DEATH({ dangling_ref_outlives_var(); }, ".*");
+}
+
+}  // namespace saam::test
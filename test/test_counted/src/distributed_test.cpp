@@ -0,0 +1,124 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/detail/distributed_counted_borrow_manager.hpp>
+#include <saam/safe_ref.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace saam::test
+{
+
+template <typename T>
+using distributed_var = saam::var<T, saam::distributed_counted_borrow_manager>;
+
+template <typename T>
+using distributed_ref = saam::ref<T, saam::distributed_counted_borrow_manager>;
+
+TEST(distributed_counted_test, borrow_from_many_threads)
+{
+    distributed_var<std::string> text("Hello world");
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&text]() {
+            for (std::size_t i = 0; i < 10000; i++)
+            {
+                ASSERT_EQ(text->length(), 11);
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+TEST(distributed_counted_test, release_ref_on_another_thread)
+{
+    distributed_var<std::string> text("Hello world");
+
+    // The ref is counted in the slot of this thread, but it is released in the slot of the other thread
+    std::optional<distributed_ref<std::string>> text_ref = text.borrow();
+    std::thread other_thread([&text_ref]() { text_ref.reset(); });
+    other_thread.join();
+    ASSERT_EQ(text.num_borrows(), 0);
+}
+
+TEST(distributed_counted_test, num_borrows_sums_up_the_slots)
+{
+    distributed_var<std::string> text("Hello world");
+
+    std::vector<distributed_ref<std::string>> refs;
+    refs.emplace_back(text.borrow());
+    std::thread other_thread([&text, &refs]() { refs.emplace_back(text.borrow()); });
+    other_thread.join();
+
+    ASSERT_EQ(text.num_borrows(), 2);
+}
+
+TEST(distributed_counted_test, copy_into_a_closed_slot_panics)
+{
+    auto copy_while_destroyed = []() {
+        // The dangling reference panic is called after all the slots were closed, there the ref is copied
+        std::optional<distributed_ref<std::string>> text_ref;
+        saam::dangling_reference_panic = [&text_ref](const std::type_info &, void *, std::size_t) {
+            [[maybe_unused]] const auto copied_ref = *text_ref;
+        };
+        saam::distributed_closed_borrow_panic = []() { std::cerr << "borrowed after the slots were closed\n"; };
+
+        auto text = std::make_unique<distributed_var<std::string>>("Hello world");
+        text_ref.emplace(text->borrow());
+        text.reset();
+    };
+
+    EXPECT_DEATH({ copy_while_destroyed(); }, "borrowed after the slots were closed");
+}
+
+TEST(distributed_counted_test, copy_and_move_refs)
+{
+    distributed_var<std::string> text("Hello world");
+    distributed_var<std::string> other_text("Welcome");
+
+    distributed_ref<std::string> text_ref = text.borrow();
+    auto copied_ref = text_ref;
+    auto moved_ref = std::move(copied_ref);
+    moved_ref = other_text.borrow();
+    text_ref = std::move(moved_ref);
+
+    ASSERT_EQ(*text_ref, "Welcome");
+}
+
+TEST(distributed_counted_test, dangling_ref_outlives_var)
+{
+    auto dangling_refs_outlive_var = []() {
+        saam::dangling_reference_panic = [](const std::type_info &, void *, std::size_t num_dangling_references) {
+            std::cerr << num_dangling_references << " dangling references\n";
+        };
+
+        std::vector<distributed_ref<const std::string>> text_refs;
+        distributed_var<std::string> text{"hello"};
+
+        // Borrow from different threads, so the references are counted in different slots
+        text_refs.emplace_back(text);
+        std::thread other_thread([&]() { text_refs.emplace_back(text); });
+        other_thread.join();
+    };
+
+    EXPECT_DEATH({ dangling_refs_outlive_var(); }, "2 dangling references");
+}
+
+}  // namespace saam::test
@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/detail/counted_borrow_manager.hpp>
+#include <saam/safe_ref.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <latch>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace saam::test
+{
+
+// Short timeout, so the panic is reached quickly
+using short_draining_borrow_manager = saam::basic_counted_borrow_manager<std::size_t, alignof(std::atomic<std::size_t>), false, 50>;
+
+TEST(drain_test, destruction_waits_for_in_flight_borrow)
+{
+    std::optional<saam::var<std::string, saam::draining_counted_borrow_manager>> shared(std::in_place, "shared");
+    std::latch borrowed(1);
+
+    std::thread worker([pinned = std::optional(shared->borrow()), &borrowed]() mutable {
+        borrowed.count_down();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_EQ(**pinned, "shared");
+        // The release of the last reference wakes the destruction
+        pinned.reset();
+    });
+
+    borrowed.wait();
+    const auto before = std::chrono::steady_clock::now();
+    shared.reset();
+    ASSERT_GE(std::chrono::steady_clock::now() - before, std::chrono::milliseconds(10));
+
+    worker.join();
+}
+
+TEST(drain_test, destruction_without_borrows_does_not_wait)
+{
+    std::vector<saam::var<int, saam::draining_counted_borrow_manager>> numbers(1000);
+    for (auto &number : numbers)
+    {
+        [[maybe_unused]] auto number_ref = number.borrow();
+    }
+    numbers.clear();
+}
+
+TEST(drain_test, borrow_of_a_draining_var_panics)
+{
+    auto borrow_while_draining = []() {
+        saam::draining_borrow_panic = [](std::size_t num_outstanding_references) {
+            std::cerr << "borrowed while draining " << num_outstanding_references << " references\n";
+        };
+
+        std::optional<saam::var<int, saam::draining_counted_borrow_manager>> number(std::in_place, 5);
+        std::latch destroying(1);
+        // The pinned ref is never released, so the destruction keeps draining, until the worker copies it
+        std::thread worker([pinned = number->borrow(), &destroying]() {
+            destroying.wait();
+            while (true)
+            {
+                // Until the draining starts, a copy is a plain borrow, afterwards it panics
+                [[maybe_unused]] const auto copied = pinned;
+            }
+        });
+
+        destroying.count_down();
+        number.reset();
+        worker.join();
+    };
+
+    EXPECT_DEATH({ borrow_while_draining(); }, "borrowed while draining 1 references");
+}
+
+TEST(drain_test, leaked_ref_panics_after_the_timeout)
+{
+    auto leak_ref = []() {
+        std::optional<saam::ref<int, short_draining_borrow_manager>> leaked;
+        saam::var<int, short_draining_borrow_manager> number(5);
+        leaked = number;
+    };
+
+    EXPECT_DEATH({ leak_ref(); }, ".*");
+}
+
+}  // namespace saam::test
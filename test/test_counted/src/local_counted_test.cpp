@@ -0,0 +1,90 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+// The owner thread check is opt-in, this translation unit is in its own ABI namespace with it
+#define SAAM_LOCAL_COUNTED_THREAD_CHECK 1
+
+#include <saam/detail/local_counted_borrow_manager.hpp>
+#include <saam/safe_ref.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace saam::test
+{
+
+template <typename T>
+using local_var = saam::var<T, saam::local_counted_borrow_manager>;
+
+template <typename T>
+using local_ref = saam::ref<T, saam::local_counted_borrow_manager>;
+
+TEST(local_counted_test, copy_and_move_refs)
+{
+    local_var<std::string> text("Hello world");
+    local_var<std::string> other_text("Welcome");
+
+    local_ref<std::string> text_ref = text.borrow();
+    auto copied_ref = text_ref;
+    auto moved_ref = std::move(copied_ref);
+    moved_ref = other_text.borrow();
+    text_ref = std::move(moved_ref);
+
+    ASSERT_EQ(*text_ref, "Welcome");
+    ASSERT_EQ(text->length(), 11);
+}
+
+TEST(local_counted_test, dangling_ref_outlives_var)
+{
+    auto dangling_refs_outlive_var = []() {
+        saam::dangling_reference_panic = [](const std::type_info &, void *, std::size_t num_dangling_references) {
+            std::cerr << num_dangling_references << " dangling references\n";
+        };
+
+        std::vector<local_ref<const std::string>> text_refs;
+        local_var<std::string> text{"hello"};
+        text_refs.emplace_back(text);
+        text_refs.emplace_back(text);
+    };
+
+    EXPECT_DEATH({ dangling_refs_outlive_var(); }, "2 dangling references");
+}
+
+TEST(local_counted_test, destroyed_on_another_thread)
+{
+    auto text = std::make_unique<local_var<std::string>>("Hello world");
+    {
+        local_ref<const std::string> text_ref(*text);
+        ASSERT_EQ(text_ref->length(), 11);
+    }
+
+    // Only the released references are verified, not the thread
+    std::thread other_thread([&text]() { text.reset(); });
+    other_thread.join();
+    ASSERT_FALSE(text);
+}
+
+#ifndef NDEBUG
+TEST(local_counted_test, borrow_on_another_thread)
+{
+    auto borrow_on_another_thread = []() {
+        local_var<std::string> text("Hello world");
+        std::thread other_thread([&text]() { auto text_ref = text.borrow(); });
+        other_thread.join();
+    };
+
+    EXPECT_DEATH({ borrow_on_another_thread(); }, "thread local var is borrowed on another thread");
+}
+#endif
+
+}  // namespace saam::test
@@ -0,0 +1,170 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/detail/statistics_borrow_manager.hpp>
+#include <saam/relocate.hpp>
+#include <saam/safe_ref.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace
+{
+
+// Holds only a pointer to its heap allocated state, so it can be relocated bitwise
+struct boxed_text
+{
+    std::unique_ptr<std::string> text = std::make_unique<std::string>();
+};
+
+// Counts its hooks, the self references must not outlive the relocation
+struct hooked_counter
+{
+    void post_constructor(saam::ref<hooked_counter> self) noexcept
+    {
+        post_constructions++;
+        self_ref.emplace_back(std::move(self));
+    }
+
+    void pre_destructor() noexcept
+    {
+        pre_destructions++;
+        self_ref.clear();
+    }
+
+    int post_constructions = 0;
+    int pre_destructions = 0;
+    std::vector<saam::ref<hooked_counter>> self_ref;
+};
+
+}  // namespace
+
+template <>
+struct saam::is_trivially_relocatable<boxed_text> : std::true_type
+{
+};
+
+template <>
+struct saam::is_trivially_relocatable<hooked_counter> : std::true_type
+{
+};
+
+namespace saam::test
+{
+
+static_assert(is_trivially_relocatable_v<var<int>>);
+static_assert(is_trivially_relocatable_v<var<boxed_text>>);
+static_assert(!is_trivially_relocatable_v<var<std::string>>);
+// The hooks are called one by one
+static_assert(!is_trivially_relocatable_v<var<hooked_counter>>);
+// The anchor of the weak_refs and the registry of the statistics refer to the address of the var
+static_assert(!is_trivially_relocatable_v<var<int, weak_counted_borrow_manager>>);
+static_assert(!is_trivially_relocatable_v<var<int, statistics_borrow_manager<counted_borrow_manager>>>);
+
+template <typename TVar>
+struct raw_storage
+{
+    TVar *get()
+    {
+        return reinterpret_cast<TVar *>(bytes);
+    }
+
+    alignas(TVar) std::byte bytes[sizeof(TVar) * 4];
+};
+
+TEST(counted_relocate_test, relocate_n_bitwise)
+{
+    raw_storage<var<boxed_text>> source;
+    for (std::size_t i = 0; i < 4; i++)
+    {
+        auto *constructed = ::new (source.get() + i) var<boxed_text>();
+        *constructed->borrow()->text = std::to_string(i);
+    }
+    const auto *first_text = source.get()->borrow()->text.get();
+
+    raw_storage<var<boxed_text>> destination;
+    auto *relocated = relocate_n(source.get(), 4, destination.bytes);
+
+    // The heap state is not reallocated, and the relocated vars can be borrowed
+    ASSERT_EQ(relocated->borrow()->text.get(), first_text);
+    for (std::size_t i = 0; i < 4; i++)
+    {
+        ASSERT_EQ(*relocated[i]->text, std::to_string(i));
+        ASSERT_EQ(relocated[i].num_borrows(), 0);
+        std::destroy_at(relocated + i);
+    }
+}
+
+TEST(counted_relocate_test, relocate_by_move)
+{
+    raw_storage<var<std::string>> source;
+    ::new (source.get()) var<std::string>("Hello world");
+
+    raw_storage<var<std::string>> destination;
+    auto *relocated = relocate(source.get(), destination.bytes);
+
+    ASSERT_EQ(*relocated, "Hello world");
+    std::destroy_at(relocated);
+}
+
+TEST(counted_relocate_test, hooks_are_called)
+{
+    raw_storage<var<hooked_counter>> source;
+    ::new (source.get()) var<hooked_counter>();
+
+    raw_storage<var<hooked_counter>> destination;
+    auto *relocated = relocate(source.get(), destination.bytes);
+
+    ASSERT_EQ(relocated->borrow()->post_constructions, 2);
+    ASSERT_EQ(relocated->borrow()->pre_destructions, 1);
+    // Only the self ref of the relocated var is alive
+    ASSERT_EQ(relocated->num_borrows(), 1);
+    std::destroy_at(relocated);
+}
+
+TEST(counted_relocate_test, statistics_follow_the_relocated_var)
+{
+    struct relocated_type
+    {
+        int value = 0;
+    };
+    using statistics_var = var<relocated_type, statistics_borrow_manager<counted_borrow_manager>>;
+
+    raw_storage<statistics_var> source;
+    ::new (source.get()) statistics_var();
+
+    raw_storage<statistics_var> destination;
+    auto *relocated = relocate(source.get(), destination.bytes);
+    {
+        const auto pinning_ref = relocated->borrow();
+
+        auto census = take_borrow_census(100).vars;
+        std::erase_if(census, [](const auto &var_census) { return *var_census.var_type != typeid(relocated_type); });
+        EXPECT_EQ(census.size(), 1);
+        EXPECT_TRUE(!census.empty() && census.front().var_instance == relocated);
+    }
+    std::destroy_at(relocated);
+}
+
+TEST(counted_relocate_death_test, relocate_borrowed_var)
+{
+    auto relocate_borrowed = []() {
+        raw_storage<var<int>> source;
+        auto *constructed = ::new (source.get()) var<int>(42);
+        const auto dangling_ref = constructed->borrow();
+
+        raw_storage<var<int>> destination;
+        relocate(constructed, destination.bytes);
+    };
+
+    EXPECT_DEATH({ relocate_borrowed(); }, ".*");
+}
+
+}  // namespace saam::test
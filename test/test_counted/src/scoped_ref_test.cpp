@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/safe_ref.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace
+{
+
+class base
+{
+  public:
+    virtual ~base() = default;
+    [[nodiscard]] virtual std::string name() const
+    {
+        return "base";
+    }
+};
+
+class derived : public base
+{
+  public:
+    [[nodiscard]] std::string name() const override
+    {
+        return "derived";
+    }
+};
+
+}  // namespace
+
+namespace saam::test
+{
+
+TEST(counted_scoped_ref_test, costs_a_raw_pointer)
+{
+    static_assert(sizeof(saam::scoped_ref<std::string>) == sizeof(std::string *));
+    static_assert(std::is_trivially_copy_constructible_v<saam::scoped_ref<std::string>>);
+    static_assert(std::is_trivially_destructible_v<saam::scoped_ref<std::string>>);
+}
+
+TEST(counted_scoped_ref_test, bound_to_named_parent)
+{
+    // A temporary parent ref would die before the child borrow
+    static_assert(std::is_constructible_v<saam::scoped_ref<std::string>, saam::ref<std::string> &>);
+    static_assert(!std::is_constructible_v<saam::scoped_ref<std::string>, saam::ref<std::string> &&>);
+    // No way to rebind or detach it from the scope
+    static_assert(!std::is_copy_assignable_v<saam::scoped_ref<std::string>>);
+    static_assert(!std::is_default_constructible_v<saam::scoped_ref<std::string>>);
+}
+
+TEST(counted_scoped_ref_test, child_borrow_of_ref)
+{
+    saam::var<std::string> text("Hello world");
+    saam::ref<std::string> text_ref = text;
+
+    saam::scoped_ref<std::string> child(text_ref);
+    saam::scoped_ref<const std::string> const_child(child);
+    child->at(0) = 'Y';
+
+    ASSERT_EQ(const_child->at(0), 'Y');
+    ASSERT_EQ(*child, "Yello world");
+    ASSERT_TRUE(child == saam::scoped_ref<std::string>(text_ref));
+}
+
+TEST(counted_scoped_ref_test, child_borrow_upcast)
+{
+    saam::var<derived> instance;
+    saam::ref<derived> instance_ref = instance;
+
+    auto get_name = [](saam::scoped_ref<const base> object) { return object->name(); };
+    ASSERT_EQ(get_name(instance_ref), "derived");
+}
+
+TEST(counted_scoped_ref_test, with_borrows_once_for_the_scope)
+{
+    saam::var<std::string> text("Hello world");
+
+    auto length = text.with([](saam::scoped_ref<std::string> pinned_text) {
+        pinned_text->at(0) = 'Y';
+        pinned_text->append("!");
+        return pinned_text->length();
+    });
+
+    ASSERT_EQ(length, 12);
+    ASSERT_EQ(text, "Yello world!");
+}
+
+}  // namespace saam::test
@@ -0,0 +1,182 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/detail/statistics_borrow_manager.hpp>
+#include <saam/safe_ref.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace saam::test
+{
+
+template <typename T>
+using statistics_var = saam::var<T, saam::statistics_borrow_manager<saam::counted_borrow_manager>>;
+
+template <typename T>
+using statistics_ref = saam::ref<T, saam::statistics_borrow_manager<saam::counted_borrow_manager>>;
+
+template <typename T>
+type_borrow_statistics statistics_of()
+{
+    const auto snapshot = take_borrow_statistics_snapshot();
+    const auto found = std::ranges::find_if(snapshot.types, [](const auto &statistics) { return *statistics.var_type == typeid(T); });
+    return found != snapshot.types.end() ? *found : type_borrow_statistics{};
+}
+
+TEST(counted_statistics_test, borrows_and_peak_live_refs)
+{
+    struct counted_type
+    {
+        int value = 0;
+    };
+
+    {
+        statistics_var<counted_type> instance;
+        statistics_ref<counted_type> first_ref = instance.borrow();
+        auto copied_ref = first_ref;
+        // A move is not a new borrow
+        auto moved_ref = std::move(copied_ref);
+    }
+
+    {
+        statistics_var<counted_type> instance;
+        auto only_ref = instance.borrow();
+    }
+
+    const auto statistics = statistics_of<counted_type>();
+    ASSERT_EQ(statistics.vars_created, 2);
+    ASSERT_EQ(statistics.vars_destroyed, 2);
+    ASSERT_EQ(statistics.borrows, 3);
+    ASSERT_EQ(statistics.releases, 3);
+    ASSERT_EQ(statistics.peak_live_refs, 2);
+    ASSERT_EQ(statistics.refs_outstanding_at_destruction, 0);
+}
+
+TEST(counted_statistics_test, ref_lifetime)
+{
+    struct long_lived_type
+    {
+    };
+
+    statistics_var<long_lived_type> instance;
+    std::optional<statistics_ref<long_lived_type>> long_lived_ref = instance.borrow();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    long_lived_ref.reset();
+
+    const auto statistics = statistics_of<long_lived_type>();
+    ASSERT_GE(statistics.max_ref_lifetime, std::chrono::milliseconds(10));
+    ASSERT_GE(statistics.total_ref_lifetime, statistics.max_ref_lifetime);
+}
+
+TEST(counted_statistics_test, refs_outstanding_at_destruction)
+{
+    struct dangling_type
+    {
+    };
+
+    auto dangling_refs_outlive_var = []() {
+        saam::counted_dangling_reference_panic = [](const std::type_info &, void *, std::size_t) {
+            std::cerr << statistics_of<dangling_type>().refs_outstanding_at_destruction << " refs outstanding\n";
+        };
+
+        std::vector<statistics_ref<dangling_type>> refs;
+        statistics_var<dangling_type> instance;
+        refs.emplace_back(instance);
+        refs.emplace_back(instance);
+    };
+
+    EXPECT_DEATH({ dangling_refs_outlive_var(); }, "2 refs outstanding");
+}
+
+TEST(counted_statistics_test, export)
+{
+    struct exported_type
+    {
+    };
+
+    statistics_var<exported_type> instance;
+    auto instance_ref = instance.borrow();
+
+    std::stringstream exported;
+    exported << take_borrow_statistics_snapshot();
+
+    const auto expected_line = std::string("saam_borrows_total{type=\"") + typeid(exported_type).name() + "\"} 1\n";
+    ASSERT_NE(exported.str().find(expected_line), std::string::npos);
+}
+
+TEST(counted_statistics_test, num_borrows)
+{
+    saam::var<std::string> text("Hello world");
+    ASSERT_EQ(text.num_borrows(), 0);
+
+    saam::ref<std::string> text_ref(text);
+    auto copied_ref = text_ref;
+    // A move is not a new borrow
+    auto moved_ref = std::move(copied_ref);
+    ASSERT_EQ(text.num_borrows(), 2);
+
+    text_ref = saam::ref<std::string>(text);
+    ASSERT_EQ(text.num_borrows(), 2);
+}
+
+TEST(counted_statistics_test, census_of_the_most_borrowed_vars)
+{
+    struct pinned_type
+    {
+    };
+
+    statistics_var<pinned_type> rarely_borrowed;
+    statistics_var<pinned_type> often_borrowed;
+    statistics_var<pinned_type> not_borrowed;
+    std::vector<statistics_ref<pinned_type>> refs;
+    refs.emplace_back(rarely_borrowed);
+    for (std::size_t i = 0; i < 3; i++)
+    {
+        refs.emplace_back(often_borrowed);
+    }
+    ASSERT_EQ(often_borrowed.num_borrows(), 3);
+
+    const auto census_of_pinned = [](std::size_t top_n) {
+        auto census = take_borrow_census(top_n).vars;
+        std::erase_if(census, [](const auto &var_census) { return *var_census.var_type != typeid(pinned_type); });
+        return census;
+    };
+
+    const auto census = census_of_pinned(100);
+    ASSERT_EQ(census.size(), 2);
+    ASSERT_EQ(census[0].var_instance, &often_borrowed);
+    ASSERT_EQ(census[0].live_refs, 3);
+    ASSERT_EQ(census[1].var_instance, &rarely_borrowed);
+    ASSERT_EQ(census[1].live_refs, 1);
+
+    // Only the top of the list is taken
+    const auto top_census = take_borrow_census(1).vars;
+    ASSERT_EQ(top_census.size(), 1);
+    ASSERT_GE(top_census[0].live_refs, 3);
+
+    std::stringstream exported;
+    exported << take_borrow_census(100);
+    std::stringstream expected_line;
+    expected_line << "saam_var_live_refs{type=\"" << typeid(pinned_type).name() << "\",var=\"" << static_cast<const void *>(&often_borrowed)
+                  << "\"} 3\n";
+    ASSERT_NE(exported.str().find(expected_line.str()), std::string::npos);
+
+    // The vars without live refs are not listed
+    refs.clear();
+    ASSERT_TRUE(census_of_pinned(100).empty());
+}
+
+}  // namespace saam::test
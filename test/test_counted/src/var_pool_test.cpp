@@ -0,0 +1,83 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/var_pool.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace saam::test
+{
+
+TEST(var_pool_test, emplace_and_borrow)
+{
+    saam::var_pool<std::string> pool(2);
+
+    auto &hello = pool.emplace("hello");
+    auto &world = pool.emplace(5, 'w');
+    auto &third = pool.emplace();
+
+    saam::ref<std::string> hello_ref = hello.borrow();
+    ASSERT_EQ(*hello_ref, "hello");
+    ASSERT_EQ(*world.borrow(), "wwwww");
+    ASSERT_TRUE(third.borrow()->empty());
+
+    // Two slabs of two slots
+    ASSERT_EQ(pool.size(), 3);
+    ASSERT_EQ(pool.capacity(), 4);
+}
+
+TEST(var_pool_test, destroyed_slots_are_reused)
+{
+    saam::var_pool<std::string> pool(4);
+
+    auto *first = &pool.emplace("first");
+    [[maybe_unused]] auto &second = pool.emplace("second");
+    pool.destroy(*first);
+    ASSERT_EQ(pool.size(), 1);
+
+    auto &reused = pool.emplace("reused");
+    ASSERT_EQ(&reused, first);
+    ASSERT_EQ(*reused.borrow(), "reused");
+    ASSERT_EQ(pool.capacity(), 4);
+}
+
+TEST(var_pool_test, clear)
+{
+    saam::var_pool<std::string> pool(8);
+    std::vector<saam::var<std::string> *> vars;
+    for (int i = 0; i < 20; i++)
+    {
+        vars.push_back(&pool.emplace(std::to_string(i)));
+    }
+    pool.destroy(*vars[3]);
+
+    pool.clear();
+    ASSERT_EQ(pool.size(), 0);
+    ASSERT_EQ(pool.capacity(), 24);
+
+    // The slabs are reused from the beginning
+    ASSERT_EQ(&pool.emplace("again"), vars[0]);
+
+    pool.clear();
+    pool.shrink_to_fit();
+    ASSERT_EQ(pool.capacity(), 0);
+}
+
+TEST(var_pool_test, dangling_ref_outlives_pool)
+{
+    auto dangling_ref_outlives_pool = []() {
+        std::optional<saam::ref<std::string>> dangling_ref;
+        saam::var_pool<std::string> pool;
+        dangling_ref = pool.emplace("hello").borrow();
+    };
+
+    EXPECT_DEATH({ dangling_ref_outlives_pool(); }, ".*");
+}
+
+}  // namespace saam::test
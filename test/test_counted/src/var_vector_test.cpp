@@ -0,0 +1,124 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/var_vector.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+
+namespace saam::test
+{
+
+TEST(var_vector_test, borrow_elements)
+{
+    saam::var_vector<std::string> texts{"hello", "world"};
+    // No reallocation while the elements are borrowed
+    texts.reserve(3);
+    saam::ref<std::string> hello = texts.borrow(0);
+    saam::ref<const std::string> world = texts[1];
+
+    *hello = "Hello";
+    ASSERT_EQ(*texts[0], "Hello");
+    ASSERT_EQ(*world, "world");
+
+    auto appended = texts.emplace_back(3, '!');
+    ASSERT_EQ(*appended, "!!!");
+    ASSERT_EQ(texts.size(), 3);
+}
+
+TEST(var_vector_test, with_contiguous_view)
+{
+    saam::var_vector<int> numbers;
+    for (int i = 1; i <= 100; i++)
+    {
+        numbers.push_back(i);
+    }
+
+    const int sum = numbers.with([](std::span<int> values) { return std::accumulate(values.begin(), values.end(), 0); });
+    ASSERT_EQ(sum, 5050);
+}
+
+TEST(var_vector_test, not_borrowed_modifications)
+{
+    saam::var_vector<int> numbers{1, 2, 3, 4};
+    {
+        // The elements before the erased one are not moved
+        auto first = numbers.borrow(0);
+        numbers.erase(2);
+        numbers.pop_back();
+        ASSERT_EQ(*first, 1);
+    }
+
+    numbers.reserve(100);
+    numbers.resize(10);
+    ASSERT_EQ(numbers.size(), 10);
+    ASSERT_EQ(*numbers[1], 2);
+
+    saam::var_vector<int> moved(std::move(numbers));
+    ASSERT_EQ(*moved[1], 2);
+    moved.clear();
+    ASSERT_TRUE(moved.empty());
+}
+
+TEST(var_vector_test, moved_vector_keeps_borrows)
+{
+    saam::var_vector<int> numbers{1, 2, 3};
+    saam::var_vector<int> moved;
+    {
+        auto second = numbers.borrow(1);
+        moved = std::move(numbers);
+        ASSERT_EQ(&*second, &*moved[1]);
+    }
+}
+
+TEST(var_vector_test, reallocation_of_borrowed_element)
+{
+    auto reallocate_borrowed = []() {
+        saam::var_vector<int> numbers{1};
+        auto first = numbers.borrow(0);
+        numbers.reserve(numbers.capacity() * 2);
+    };
+
+    EXPECT_DEATH({ reallocate_borrowed(); }, ".*");
+}
+
+TEST(var_vector_test, erase_of_borrowed_element)
+{
+    auto erase_borrowed = []() {
+        saam::var_vector<int> numbers{1, 2, 3};
+        auto last = numbers.borrow(2);
+        numbers.erase(0);
+    };
+
+    EXPECT_DEATH({ erase_borrowed(); }, ".*");
+}
+
+TEST(var_vector_test, modification_during_view)
+{
+    auto modify_during_view = []() {
+        saam::var_vector<int> numbers{1, 2, 3};
+        numbers.with([&numbers](std::span<int>) { numbers.clear(); });
+    };
+
+    EXPECT_DEATH({ modify_during_view(); }, ".*");
+}
+
+TEST(var_vector_test, dangling_ref_outlives_vector)
+{
+    auto dangling_ref_outlives_vector = []() {
+        std::optional<saam::ref<int>> dangling_ref;
+        saam::var_vector<int> numbers{1};
+        dangling_ref = numbers.borrow(0);
+    };
+
+    EXPECT_DEATH({ dangling_ref_outlives_vector(); }, ".*");
+}
+
+}  // namespace saam::test
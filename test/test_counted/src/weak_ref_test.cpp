@@ -0,0 +1,135 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/weak_ref.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+class session
+{
+  public:
+    explicit session(std::string name) :
+        name_(std::move(name))
+    {
+    }
+
+    std::string name_;
+};
+
+class admin_session : public session
+{
+  public:
+    using session::session;
+};
+
+}  // namespace
+
+template <>
+struct saam::borrow_manager_for<session>
+{
+    using type = saam::weak_counted_borrow_manager;
+};
+
+template <>
+struct saam::borrow_manager_for<admin_session>
+{
+    using type = saam::weak_counted_borrow_manager;
+};
+
+namespace saam::test
+{
+
+TEST(weak_ref_test, lock_alive_var)
+{
+    saam::var<session> alive(std::in_place, "alice");
+    saam::weak_ref<session> observer(alive);
+    ASSERT_FALSE(observer.expired());
+
+    auto locked = observer.lock();
+    ASSERT_TRUE(locked.has_value());
+    ASSERT_EQ((*locked)->name_, "alice");
+}
+
+TEST(weak_ref_test, var_is_not_pinned)
+{
+    std::vector<saam::weak_ref<session>> observers;
+    {
+        saam::var<session> short_lived(std::in_place, "bob");
+        for (int i = 0; i < 1000; i++)
+        {
+            observers.emplace_back(short_lived);
+        }
+    }
+    // The destruction did not panic, the observers see the var gone
+    for (const auto &observer : observers)
+    {
+        ASSERT_TRUE(observer.expired());
+        ASSERT_FALSE(observer.lock().has_value());
+    }
+}
+
+TEST(weak_ref_test, copy_convert_and_reset)
+{
+    saam::weak_ref<const session> empty;
+    ASSERT_TRUE(empty.expired());
+
+    saam::var<admin_session> admin(std::in_place, "root");
+    saam::weak_ref<admin_session> from_ref(admin.borrow());
+    saam::weak_ref<const admin_session> copied(from_ref);
+    saam::weak_ref<const admin_session> moved(std::move(copied));
+    ASSERT_TRUE(copied.expired());
+    ASSERT_EQ((*moved.lock())->name_, "root");
+
+    from_ref.reset();
+    ASSERT_TRUE(from_ref.expired());
+    ASSERT_FALSE(moved.expired());
+}
+
+TEST(weak_ref_test, lock_from_another_thread)
+{
+    for (int round = 0; round < 100; round++)
+    {
+        std::optional<saam::var<session>> racing(std::in_place, std::in_place, "carol");
+        saam::weak_ref<session> observer(*racing);
+
+        std::thread locker([observer]() {
+            // The copied observer shares the anchor with the one of this thread
+            for (int i = 0; i < 100; i++)
+            {
+                if (auto locked = observer.lock(); !locked.has_value())
+                {
+                    break;
+                }
+            }
+        });
+
+        locker.join();
+        racing.reset();
+        ASSERT_TRUE(observer.expired());
+    }
+}
+
+TEST(weak_ref_test, locked_ref_pins_the_var)
+{
+    auto destroy_locked_var = []() {
+        std::optional<saam::ref<session>> locked;
+        saam::var<session> pinned(std::in_place, "dave");
+        saam::weak_ref<session> observer(pinned);
+        locked = observer.lock();
+    };
+
+    EXPECT_DEATH({ destroy_locked_var(); }, ".*");
+}
+
+}  // namespace saam::test
@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/async_mutex.hpp>
+#include <saam/synchronized.hpp>
+
+#include <gtest/gtest.h>
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace saam::test
+{
+
+static_assert(lock_policy<async_mutex_policy> && async_mutex_policy::is_shared);
+
+namespace
+{
+
+// Eagerly started coroutine, its frame is destroyed when it completes
+struct detached_task
+{
+    struct promise_type
+    {
+        detached_task get_return_object() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() noexcept
+        {
+        }
+
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+    };
+};
+
+// Collects the coroutines to be resumed, the test resumes them explicitly
+struct queued_executor
+{
+    std::deque<std::coroutine_handle<>> *queue;
+
+    void operator()(std::coroutine_handle<> coroutine) const
+    {
+        queue->push_back(coroutine);
+    }
+};
+
+void run_all(std::deque<std::coroutine_handle<>> &queue)
+{
+    while (!queue.empty())
+    {
+        auto coroutine = queue.front();
+        queue.pop_front();
+        coroutine.resume();
+    }
+}
+
+template <typename TExecutor>
+detached_task append(synchronized<std::string, async_mutex_policy> &text, char letter, TExecutor executor)
+{
+    auto text_guard = co_await text.async_commence_mut(executor);
+    text_guard->push_back(letter);
+}
+
+template <typename TExecutor>
+detached_task read(const synchronized<std::string, async_mutex_policy> &text, std::string &copy, TExecutor executor)
+{
+    const auto text_guard = co_await text.async_commence(executor);
+    copy = *text_guard;
+}
+
+}  // namespace
+
+TEST(async_commence_test, uncontended_guard_does_not_suspend)
+{
+    synchronized<std::string, async_mutex_policy> text(std::string("ab"));
+    append(text, 'c', inline_executor{});
+
+    std::string copy;
+    read(text, copy, inline_executor{});
+    ASSERT_EQ(copy, "abc");
+}
+
+TEST(async_commence_test, coroutine_is_resumed_by_its_executor)
+{
+    synchronized<std::string, async_mutex_policy> text;
+    std::deque<std::coroutine_handle<>> queue;
+    {
+        auto holding = text.commence_mut();
+        append(text, 'a', queued_executor{&queue});
+        holding->push_back('b');
+        ASSERT_TRUE(queue.empty());
+    }
+
+    // The lock is handed over to the coroutine on the release, but it runs only when the executor resumes it
+    ASSERT_EQ(queue.size(), 1);
+    ASSERT_FALSE(text.try_commence().has_value());
+    run_all(queue);
+    ASSERT_EQ(*text.commence(), "ba");
+}
+
+TEST(async_commence_test, readers_share_the_lock)
+{
+    synchronized<std::string, async_mutex_policy> text(std::string("shared"));
+    const auto reading = text.commence();
+
+    std::string copy;
+    read(text, copy, inline_executor{});
+    ASSERT_EQ(copy, "shared");
+}
+
+TEST(async_commence_test, coroutines_get_the_lock_in_their_order)
+{
+    synchronized<std::string, async_mutex_policy> text;
+    std::deque<std::coroutine_handle<>> queue;
+    std::string first_copy;
+    std::string second_copy;
+    {
+        auto holding = text.commence_mut();
+        append(text, 'a', queued_executor{&queue});
+        read(text, first_copy, queued_executor{&queue});
+        read(text, second_copy, queued_executor{&queue});
+    }
+
+    // The writer first, then the readers together
+    ASSERT_EQ(queue.size(), 1);
+    queue.front().resume();
+    queue.pop_front();
+    ASSERT_EQ(queue.size(), 2);
+    run_all(queue);
+
+    ASSERT_EQ(first_copy, "a");
+    ASSERT_EQ(second_copy, "a");
+}
+
+TEST(async_commence_test, coroutines_and_threads_are_mutually_exclusive)
+{
+    synchronized<int, async_mutex_policy> counter(0);
+
+    const auto increment = [](synchronized<int, async_mutex_policy> &counter) -> detached_task {
+        auto counter_guard = co_await counter.async_commence_mut(inline_executor{});
+        (*counter_guard)++;
+    };
+
+    std::vector<std::jthread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&counter, &increment, i]() {
+            for (int j = 0; j < 5000; j++)
+            {
+                if ((i + j) % 2 == 0)
+                {
+                    increment(counter);
+                }
+                else
+                {
+                    (*counter.commence_mut())++;
+                }
+            }
+        });
+    }
+    threads.clear();
+
+    ASSERT_EQ(*counter.commence(), 20000);
+}
+
+TEST(async_commence_death_test, synchronized_destroyed_under_a_suspended_coroutine)
+{
+    const auto destroyed_under_coroutine = []() {
+        std::deque<std::coroutine_handle<>> queue;
+        auto *text = new synchronized<std::string, async_mutex_policy>();
+        {
+            auto holding = text->commence_mut();
+            append(*text, 'a', queued_executor{&queue});
+        }
+        // The lock is handed over to the suspended coroutine
+        delete text;
+    };
+    EXPECT_DEATH(destroyed_under_coroutine(), ".*");
+}
+
+}  // namespace saam::test
@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/combining_lock_policy.hpp>
+#include <saam/synchronized.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace saam::test
+{
+
+using combining_mutex_policy = combining_lock_policy<mutex_policy>;
+
+static_assert(lock_policy<combining_mutex_policy> && !combining_mutex_policy::is_shared);
+static_assert(timed_lock_policy<combining_lock_policy<shared_timed_mutex_policy>>);
+
+TEST(combining_test, apply_without_combining)
+{
+    synchronized<std::string> text(std::string("Hello"));
+    const auto length = text.apply([](std::string &instance) {
+        instance += " world";
+        return instance.size();
+    });
+
+    ASSERT_EQ(length, 11);
+    ASSERT_EQ(*text.commence(), "Hello world");
+}
+
+TEST(combining_test, apply_returns_the_result)
+{
+    synchronized<std::vector<int>, combining_mutex_policy> numbers;
+    numbers.apply([](std::vector<int> &instance) { instance.push_back(1); });
+
+    ASSERT_EQ(numbers.apply([](std::vector<int> &instance) { return instance.size(); }), 1);
+}
+
+TEST(combining_test, exception_is_rethrown_to_the_caller)
+{
+    synchronized<int, combining_mutex_policy> number(0);
+    ASSERT_THROW(number.apply([](int &) -> int { throw std::runtime_error("failed"); }), std::runtime_error);
+
+    // The lock is not left locked
+    ASSERT_TRUE(number.try_commence_mut().has_value());
+}
+
+TEST(combining_test, parallel_apply_is_atomic_and_ordered_per_thread)
+{
+    constexpr int num_threads = 8;
+    constexpr int num_operations = 5000;
+
+    synchronized<std::vector<std::pair<int, int>>, combining_mutex_policy> log;
+
+    std::vector<std::vector<std::size_t>> positions(num_threads);
+    std::vector<std::jthread> threads;
+    for (int thread = 0; thread < num_threads; thread++)
+    {
+        threads.emplace_back([&, thread]() {
+            for (int operation = 0; operation < num_operations; operation++)
+            {
+                positions[thread].push_back(log.apply([&](auto &entries) {
+                    entries.emplace_back(thread, operation);
+                    return entries.size();
+                }));
+            }
+        });
+    }
+    threads.clear();
+
+    const auto entries = log.commence();
+    ASSERT_EQ(entries->size(), num_threads * num_operations);
+
+    // The calls of a thread are executed in their order
+    std::vector<int> next_operation(num_threads, 0);
+    for (const auto &[thread, operation] : *entries)
+    {
+        ASSERT_EQ(operation, next_operation[thread]);
+        next_operation[thread]++;
+    }
+    for (const auto &thread_positions : positions)
+    {
+        ASSERT_TRUE(std::ranges::is_sorted(thread_positions));
+    }
+}
+
+TEST(combining_test, apply_notifies_the_waiters)
+{
+    synchronized<int, combining_mutex_policy> number(0);
+
+    std::jthread producer([&number]() {
+        for (int i = 0; i < 10; i++)
+        {
+            number.apply([](int &instance) { instance++; });
+        }
+    });
+
+    const auto number_guard = number.commence_when([](int instance) { return instance == 10; });
+    ASSERT_EQ(*number_guard, 10);
+}
+
+}  // namespace saam::test
@@ -0,0 +1,184 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/synchronized.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <latch>
+#include <thread>
+#include <vector>
+
+namespace saam::test
+{
+
+TEST(condition_test, wait_on_condition_shared_lock)
+{
+    saam::synchronized<int> synced_m(5);
+    std::condition_variable_any above_5_condition;
+    bool stop_thread = false;
+
+    std::thread thread_worker([&]() {
+        for (; !stop_thread;)
+        {
+            {
+                auto locked_m = synced_m.commence_mut();
+                (*locked_m)++;
+            }
+            above_5_condition.notify_all();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+
+    {
+        auto guard = synced_m.commence();
+        above_5_condition.wait(guard.get_lock(), [&guard]() { return *guard > 5; });
+        ASSERT_GT(*guard, 5);
+    }
+
+    stop_thread = true;
+    thread_worker.join();
+}
+
+TEST(condition_test, wait_on_condition_unique_lock)
+{
+    saam::synchronized<int> synced_m(5);
+    std::condition_variable_any above_5_condition;
+    bool stop_thread = false;
+
+    std::thread thread_worker([&]() {
+        for (; !stop_thread;)
+        {
+            {
+                auto locked_m = synced_m.commence_mut();
+                (*locked_m)++;
+            }
+            above_5_condition.notify_all();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+
+    {
+        auto guard = synced_m.commence_mut();
+        above_5_condition.wait(guard.get_lock(), [&guard]() { return *guard > 5; });
+        *guard = -*guard;
+        ASSERT_LT(*guard, -5);
+    }
+
+    stop_thread = true;
+    thread_worker.join();
+}
+
+TEST(condition_test, commence_when)
+{
+    saam::synchronized<int> synced_m(5);
+
+    std::thread thread_worker([&]() {
+        for (int i = 0; i < 5; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            (*synced_m.commence_mut())++;
+        }
+    });
+
+    {
+        auto guard = synced_m.commence_when([](const int &value) { return value >= 10; });
+        ASSERT_EQ(*guard, 10);
+    }
+
+    thread_worker.join();
+}
+
+TEST(condition_test, commence_mut_when)
+{
+    saam::synchronized<std::vector<int>> queue;
+
+    std::thread consumer([&]() {
+        auto guard = queue.commence_mut_when([](const std::vector<int> &items) { return !items.empty(); });
+        guard->clear();
+    });
+
+    queue.commence_mut()->push_back(42);
+    consumer.join();
+
+    ASSERT_TRUE(queue.commence()->empty());
+}
+
+TEST(condition_test, assignments_notify)
+{
+    saam::synchronized<int> target(0);
+    saam::synchronized<int> source(7);
+    saam::synchronized<std::vector<int>> moved_from(std::vector<int>{1, 2});
+    saam::synchronized<std::vector<int>> moved_to;
+
+    std::thread copy_waiter([&]() {
+        auto guard = target.commence_when([](const int &value) { return value == 7; });
+        ASSERT_EQ(*guard, 7);
+    });
+    std::thread move_waiter([&]() {
+        // The moved-from source changes too
+        auto guard = moved_from.commence_when([](const std::vector<int> &items) { return items.empty(); });
+        ASSERT_TRUE(guard->empty());
+    });
+
+    // Let the waiters wait, a missed notification would block them forever
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    target = source;
+    moved_to = std::move(moved_from);
+
+    copy_waiter.join();
+    move_waiter.join();
+    ASSERT_EQ(moved_to.commence()->size(), 2);
+}
+
+TEST(condition_test, commence_when_timeout)
+{
+    saam::synchronized<int> synced_m(5);
+
+    const auto timeout = std::chrono::milliseconds(20);
+    const auto before = std::chrono::steady_clock::now();
+    auto guard = synced_m.commence_when_for(timeout, [](const int &value) { return value > 5; });
+    ASSERT_GE(std::chrono::steady_clock::now() - before, timeout);
+    ASSERT_FALSE(guard.has_value());
+
+    synced_m = 6;
+    auto mut_guard = synced_m.commence_mut_when_for(timeout, [](const int &value) { return value > 5; });
+    ASSERT_TRUE(mut_guard.has_value());
+    ASSERT_EQ(**mut_guard, 6);
+}
+
+TEST(condition_test, unmodified_guard_does_not_notify)
+{
+    saam::synchronized<int> synced_m(0);
+    std::atomic<int> predicate_calls = 0;
+    std::latch waiting(1);
+
+    std::thread waiter([&]() {
+        waiting.count_down();
+        auto guard = synced_m.commence_when([&](const int &value) {
+            predicate_calls++;
+            return value > 0;
+        });
+    });
+
+    waiting.wait();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    // Not accessed mutable guards do not wake the waiter
+    for (int i = 0; i < 100; i++)
+    {
+        [[maybe_unused]] auto guard = synced_m.commence_mut();
+    }
+    synced_m = 1;
+    waiter.join();
+
+    // The initial check and the one after the modification, spurious wakeups aside
+    ASSERT_LE(predicate_calls, 4);
+}
+
+}  // namespace saam::test
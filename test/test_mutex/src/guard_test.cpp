@@ -0,0 +1,194 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/guard.hpp>
+#include <saam/synchronized.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+
+namespace saam::test
+{
+
+class guard_test : public ::testing::Test
+{
+  public:
+    guard_test() :
+        text_(std::string("Hello world"))
+    {
+    }
+
+    saam::synchronized<std::string> text_;
+};
+
+TEST_F(guard_test, create_immutable_from_synchronized)
+{
+    saam::guard<const std::string> locked_text(text_);
+    ASSERT_EQ(locked_text->length(), 11);
+}
+
+TEST_F(guard_test, create_mutable_from_synchronized)
+{
+    saam::guard<std::string> locked_text(text_);
+    locked_text->at(0) = 'Y';
+    ASSERT_EQ(locked_text->at(0), 'Y');
+}
+
+TEST_F(guard_test, assign_immutable_from_synchronized)
+{
+    saam::synchronized<std::string> other_text("Other text");
+    saam::guard<const std::string> locked_text(other_text);
+
+    locked_text = text_;
+
+    ASSERT_EQ(locked_text->length(), 11);
+    locked_text = text_;
+    ASSERT_EQ(locked_text->length(), 11);
+}
+
+TEST_F(guard_test, assign_mutable_from_synchronized)
+{
+    saam::synchronized<std::string> other_text("Other text");
+    saam::guard<std::string> locked_text(other_text);
+
+    locked_text = text_;
+    locked_text->at(0) = 'Y';
+    ASSERT_EQ(locked_text->at(0), 'Y');
+
+    locked_text = text_;
+    ASSERT_EQ(locked_text->at(0), 'Y');
+}
+
+TEST_F(guard_test, dereferencing)
+{
+    saam::synchronized<int> number(5);
+
+    {
+        saam::guard<int> locked_number(number);
+
+        // Assign an lvalue ref
+        *locked_number = 23;
+        ASSERT_EQ(*locked_number, 23);
+    }
+
+    // Assign an rvalue ref
+    *number.commence_mut() = 24;
+    ASSERT_EQ(*number.commence(), 24);
+}
+
+TEST_F(guard_test, copy_construct_immutable)
+{
+    saam::guard<const std::string> locked_text(text_);
+    saam::guard<const std::string> locked_text_copy(locked_text);
+    ASSERT_EQ(locked_text_copy->length(), 11);
+}
+
+TEST_F(guard_test, copy_assignment_immutable)
+{
+    saam::guard<const std::string> locked_text(text_);
+    saam::guard<const std::string> locked_text_copy(locked_text);
+    locked_text_copy = locked_text;
+    ASSERT_EQ(locked_text_copy->length(), 11);
+}
+
+TEST_F(guard_test, move_construct_immutable)
+{
+    saam::guard<const std::string> locked_text(text_);
+    saam::guard<const std::string> locked_text_move(std::move(locked_text));
+    ASSERT_EQ(locked_text_move->length(), 11);
+}
+
+TEST_F(guard_test, move_assignment_immutable)
+{
+    saam::guard<const std::string> locked_text(text_);
+    saam::guard<const std::string> locked_text_move(locked_text);
+    locked_text_move = std::move(locked_text);
+    ASSERT_EQ(locked_text_move->length(), 11);
+}
+
+TEST_F(guard_test, move_construct_mutable)
+{
+    saam::guard<std::string> locked_text(text_);
+    saam::guard<std::string> locked_text_move(std::move(locked_text));
+    ASSERT_EQ(locked_text_move->length(), 11);
+}
+
+TEST_F(guard_test, move_assignment_mutable)
+{
+    saam::guard<std::string> locked_text(text_);
+    saam::synchronized<std::string> other_text;
+    saam::guard<std::string> locked_text_move(other_text);
+    locked_text_move = std::move(locked_text);
+    ASSERT_EQ(locked_text_move->length(), 11);
+}
+
+TEST_F(guard_test, comparison)
+{
+    saam::synchronized<std::string> text("Hello world");
+    saam::synchronized<std::string> text2("Welcome world");
+
+    // Non-const guard can be only one at a time, otherwise there is a deadlock
+
+    // Only const (immutable) guards can be compared
+    saam::guard<const std::string> text1_const_sent(text);
+    saam::guard<const std::string> text1_const_sent2(text);
+    saam::guard<const std::string> text2_const_sent(text2);
+
+    ASSERT_TRUE(text1_const_sent == text1_const_sent2);
+    ASSERT_TRUE(text1_const_sent != text2_const_sent);
+}
+
+// The guard is protected by its lock (or the lock shared by the guards of a commence_all), it does not borrow the protected instance,
+// only its synchronized counts it
+static_assert(sizeof(saam::guard<const std::string>) == sizeof(std::shared_lock<std::shared_mutex>) +
+                                                            sizeof(std::shared_ptr<std::shared_lock<std::shared_mutex>>) +
+                                                            sizeof(const std::string *) + sizeof(detail::guard_token<>));
+
+TEST(guard_death_test, guard_outlives_synchronized)
+{
+    const auto guard_outlives_synchronized = []() {
+        auto *text = new saam::synchronized<std::string>("Hello world");
+        [[maybe_unused]] auto locked_text = text->commence();
+        delete text;
+    };
+    EXPECT_DEATH(guard_outlives_synchronized(), ".*");
+}
+
+TEST(guard_death_test, held_exclusive_guard_outlives_synchronized)
+{
+    // The destroying thread holds the guard, the mutex is not probed for it
+    const auto guard_outlives_synchronized = []() {
+        saam::dangling_guard_panic = [](const std::type_info &, void *) { std::cerr << "dangling guard\n"; };
+        auto *text = new saam::synchronized<std::string, saam::mutex_policy>("Hello world");
+        [[maybe_unused]] auto locked_text = text->commence_mut();
+        delete text;
+    };
+    EXPECT_DEATH(guard_outlives_synchronized(), "dangling guard");
+}
+
+TEST(guard_counting_test, moved_and_copied_guards_are_counted_once)
+{
+    auto text = std::make_unique<saam::synchronized<std::string>>("Hello world");
+    {
+        auto locked_text = text->commence();
+        auto copied_text = locked_text;
+        auto moved_text = std::move(copied_text);
+        copied_text = moved_text;
+    }
+    {
+        std::optional<saam::guard<std::string>> mutable_text(text->commence_mut());
+        auto moved_text = std::move(*mutable_text);
+        *mutable_text = std::move(moved_text);
+    }
+    text.reset();
+}
+
+}  // namespace saam::test
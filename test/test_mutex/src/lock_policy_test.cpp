@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/synchronized.hpp>
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace saam::test
+{
+
+static_assert(std::is_same_v<synchronized<int>::mutex_t, std::shared_mutex>);
+static_assert(std::is_same_v<synchronized<int, mutex_policy>::mutex_t, std::mutex>);
+static_assert(sizeof(synchronized<int, spinlock_policy>) < sizeof(synchronized<int>));
+
+// The immutable guard of an exclusive policy holds the exclusive lock, so it cannot be copied
+static_assert(std::is_copy_constructible_v<guard<const int>>);
+static_assert(!std::is_copy_constructible_v<guard<const int, mutex_policy>>);
+static_assert(std::is_same_v<guard<const int, mutex_policy>::lock_t, std::unique_lock<std::mutex>>);
+
+template <typename TLockPolicy>
+class lock_policy_test : public ::testing::Test
+{
+};
+
+using lock_policies = ::testing::Types<shared_mutex_policy, mutex_policy, spinlock_policy, reader_biased_mutex_policy>;
+TYPED_TEST_SUITE(lock_policy_test, lock_policies);
+
+TYPED_TEST(lock_policy_test, commence)
+{
+    synchronized<std::string, TypeParam> text(std::string("Hello"));
+    *text.commence_mut() += " world";
+
+    const auto text_guard = text.commence();
+    ASSERT_EQ(*text_guard, "Hello world");
+}
+
+TYPED_TEST(lock_policy_test, parallel_increments)
+{
+    synchronized<int, TypeParam> counter(0);
+
+    std::vector<std::jthread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&counter]() {
+            for (int j = 0; j < 10000; j++)
+            {
+                (*counter.commence_mut())++;
+            }
+        });
+    }
+    threads.clear();
+
+    ASSERT_EQ(*counter.commence(), 40000);
+}
+
+TYPED_TEST(lock_policy_test, commence_all)
+{
+    synchronized<std::string, TypeParam> text(std::string("Hello"));
+    synchronized<int> number(5);
+
+    auto [text_guard, number_guard] = commence_all<const std::string, int>(text, number);
+    *number_guard += 1;
+
+    ASSERT_EQ(*text_guard, "Hello");
+    ASSERT_EQ(*number_guard, 6);
+}
+
+TYPED_TEST(lock_policy_test, copy_and_move_assignment)
+{
+    synchronized<std::string, TypeParam> text(std::string("Hello"));
+    synchronized<std::string, TypeParam> other_text(std::string("world"));
+
+    text = other_text;
+    ASSERT_EQ(*text.commence(), "world");
+
+    other_text = std::string("again");
+    text = std::move(other_text);
+    ASSERT_EQ(*text.commence(), "again");
+}
+
+TEST(lock_policy_test, condition_with_spinlock)
+{
+    synchronized<int, spinlock_policy> number(0);
+    std::condition_variable_any above_5_condition;
+
+    std::jthread producer([&]() {
+        for (int i = 0; i < 10; i++)
+        {
+            (*number.commence_mut())++;
+            above_5_condition.notify_all();
+        }
+    });
+
+    auto number_guard = number.commence_mut();
+    above_5_condition.wait(number_guard.get_lock(), [&number_guard]() { return *number_guard > 5; });
+    ASSERT_GT(*number_guard, 5);
+}
+
+}  // namespace saam::test
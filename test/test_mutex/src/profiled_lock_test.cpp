@@ -0,0 +1,170 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/profiled_lock_policy.hpp>
+#include <saam/synchronized.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <typeinfo>
+
+namespace saam::test
+{
+
+using profiled_shared_policy = profiled_lock_policy<shared_mutex_policy>;
+using profiled_timed_policy = profiled_lock_policy<timed_mutex_policy>;
+using profiled_upgrade_policy = profiled_lock_policy<upgrade_mutex_policy>;
+
+// The capabilities of the wrapped policy are kept
+static_assert(lock_policy<profiled_shared_policy> && profiled_shared_policy::is_shared);
+static_assert(!profiled_lock_policy<mutex_policy>::is_shared);
+static_assert(timed_lock_policy<profiled_timed_policy> && !timed_lock_policy<profiled_shared_policy>);
+static_assert(upgradable_lock_policy<profiled_upgrade_policy> && !upgradable_lock_policy<profiled_shared_policy>);
+static_assert(optimistic_lock_policy<profiled_lock_policy<seqlock_policy>>);
+
+namespace
+{
+
+const instance_lock_profile *find_profile(const lock_profile_snapshot &snapshot, const void *instance)
+{
+    const auto found = std::ranges::find(snapshot.instances, instance, &instance_lock_profile::instance);
+    return found != snapshot.instances.end() ? &*found : nullptr;
+}
+
+}  // namespace
+
+TEST(profiled_lock_test, acquisitions_are_counted)
+{
+    synchronized<int, profiled_shared_policy> number(0);
+    for (int i = 0; i < 3; i++)
+    {
+        (*number.commence_mut())++;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        ASSERT_EQ(*number.commence(), 3);
+    }
+
+    const auto profile = number.profile().snapshot();
+    ASSERT_EQ(profile.type, &typeid(int));
+    ASSERT_EQ(profile.exclusive_acquisitions, 3);
+    ASSERT_EQ(profile.shared_acquisitions, 2);
+    ASSERT_EQ(profile.contended_acquisitions, 0);
+    ASSERT_EQ(profile.wait_time.count, 5);
+    ASSERT_EQ(profile.wait_time.buckets[0], 5);
+    // Only the exclusive locks are timed until the release
+    ASSERT_EQ(profile.hold_time.count, 3);
+}
+
+TEST(profiled_lock_test, contended_wait_is_recorded)
+{
+    synchronized<int, profiled_lock_policy<mutex_policy>> number(0);
+
+    std::jthread waiter;
+    {
+        auto holding = number.commence_mut();
+        waiter = std::jthread([&number]() { (*number.commence_mut())++; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    waiter.join();
+
+    const auto profile = number.profile().snapshot();
+    ASSERT_EQ(profile.exclusive_acquisitions, 2);
+    ASSERT_EQ(profile.contended_acquisitions, 1);
+    ASSERT_GE(profile.wait_time.quantile(1.0), std::chrono::milliseconds(10));
+    ASSERT_GE(profile.hold_time.quantile(1.0), std::chrono::milliseconds(10));
+    ASSERT_GE(profile.hold_time.total, std::chrono::milliseconds(20));
+}
+
+TEST(profiled_lock_test, failed_attempts_are_counted)
+{
+    synchronized<int, profiled_timed_policy> number(0);
+
+    auto holding = number.commence_mut();
+    std::jthread([&number]() {
+        ASSERT_FALSE(number.try_commence_mut().has_value());
+        ASSERT_FALSE(number.try_commence_mut_for(std::chrono::milliseconds(1)).has_value());
+    }).join();
+
+    const auto profile = number.profile().snapshot();
+    ASSERT_EQ(profile.exclusive_acquisitions, 1);
+    ASSERT_EQ(profile.failed_attempts, 2);
+}
+
+TEST(profiled_lock_test, upgrade_is_profiled)
+{
+    synchronized<int, profiled_upgrade_policy> number(0);
+    {
+        auto checked = number.commence_upgradable();
+        auto modifying = std::move(checked).upgrade();
+        (*modifying)++;
+        const auto reading = std::move(modifying).downgrade();
+        ASSERT_EQ(*reading, 1);
+    }
+
+    const auto profile = number.profile().snapshot();
+    ASSERT_EQ(profile.shared_acquisitions, 1);
+    ASSERT_EQ(profile.exclusive_acquisitions, 1);
+    ASSERT_EQ(profile.hold_time.count, 1);
+}
+
+TEST(profiled_lock_test, snapshot_contains_the_live_instances)
+{
+    const void *instance = nullptr;
+    {
+        synchronized<std::string, profiled_shared_policy> text(std::string("Hello"));
+        text.profile().set_label("greeting");
+        *text.commence_mut() += " world";
+        instance = text.profile().snapshot().instance;
+
+        const auto snapshot = take_lock_profile_snapshot();
+        const auto *profile = find_profile(snapshot, instance);
+        ASSERT_NE(profile, nullptr);
+        ASSERT_EQ(profile->label, "greeting");
+        ASSERT_EQ(profile->type, &typeid(std::string));
+        ASSERT_EQ(profile->exclusive_acquisitions, 1);
+    }
+
+    ASSERT_EQ(find_profile(take_lock_profile_snapshot(), instance), nullptr);
+}
+
+TEST(profiled_lock_test, snapshot_is_exported)
+{
+    synchronized<int, profiled_shared_policy> number(0);
+    number.profile().set_label("exported");
+    (*number.commence_mut())++;
+
+    std::ostringstream stream;
+    stream << take_lock_profile_snapshot();
+    const auto text = stream.str();
+
+    ASSERT_NE(text.find("# TYPE saam_lock_wait_seconds histogram"), std::string::npos);
+    ASSERT_NE(text.find("saam_lock_hold_seconds_count{"), std::string::npos);
+    ASSERT_NE(text.find("label=\"exported\""), std::string::npos);
+    ASSERT_NE(text.find("le=\"+Inf\""), std::string::npos);
+}
+
+TEST(profiled_lock_test, histogram_quantile)
+{
+    lock_histogram_snapshot histogram;
+    ASSERT_EQ(histogram.quantile(0.5), std::chrono::nanoseconds(0));
+
+    // 1 ns, 2 ns, 3 ns and 1000 ns
+    histogram.buckets[1] = 1;
+    histogram.buckets[2] = 2;
+    histogram.buckets[10] = 1;
+    histogram.count = 4;
+
+    ASSERT_EQ(histogram.quantile(0.0), std::chrono::nanoseconds(1));
+    ASSERT_EQ(histogram.quantile(0.5), std::chrono::nanoseconds(3));
+    ASSERT_EQ(histogram.quantile(1.0), std::chrono::nanoseconds(1023));
+    ASSERT_EQ(lock_histogram_snapshot::upper_bound(lock_histogram_snapshot::bucket_count - 1), std::chrono::nanoseconds::max());
+}
+
+}  // namespace saam::test
@@ -0,0 +1,160 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/rcu_synchronized.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace saam::test
+{
+
+struct routing_table
+{
+    std::vector<std::string> routes;
+    std::size_t generation = 0;
+};
+
+TEST(rcu_test, read_and_publish)
+{
+    rcu_synchronized<routing_table> table(routing_table{{"a"}, 0});
+
+    ASSERT_EQ(table.read()->routes.size(), 1);
+
+    {
+        auto writer = table.commence_mut();
+        writer->routes.push_back("b");
+        writer->generation++;
+
+        // The draft is not visible until the writer is done
+        ASSERT_EQ(table.read()->routes.size(), 1);
+    }
+
+    ASSERT_EQ(table.read()->routes.size(), 2);
+    ASSERT_EQ(table.read()->generation, 1);
+
+    table = routing_table{{"c"}, 7};
+    ASSERT_EQ(table.read()->routes.front(), "c");
+}
+
+TEST(rcu_test, pinned_version_survives_publishing)
+{
+    rcu_synchronized<routing_table> table(routing_table{{"a"}, 0});
+
+    {
+        auto pinned = table.read();
+
+        table.commence_mut()->generation = 1;
+        table.commence_mut()->generation = 2;
+
+        // The pinned version is immutable, and not reclaimed while borrowed
+        ASSERT_EQ(pinned->generation, 0);
+        ASSERT_EQ(table.read()->generation, 2);
+        ASSERT_EQ(table.reclaim(), 1);
+    }
+
+    ASSERT_EQ(table.reclaim(), 0);
+}
+
+TEST(rcu_test, concurrent_readers_and_writer)
+{
+    rcu_synchronized<routing_table> table;
+    std::atomic<bool> stop = false;
+    std::atomic<bool> inconsistent = false;
+
+    std::vector<std::jthread> readers;
+    for (int i = 0; i < 4; i++)
+    {
+        readers.emplace_back([&]() {
+            while (!stop)
+            {
+                const auto version = table.read();
+                if (version->routes.size() != version->generation)
+                {
+                    inconsistent = true;
+                }
+            }
+        });
+    }
+
+    for (std::size_t i = 1; i <= 200; i++)
+    {
+        auto writer = table.commence_mut();
+        writer->routes.push_back(std::to_string(i));
+        writer->generation = i;
+    }
+
+    stop = true;
+    readers.clear();
+
+    ASSERT_FALSE(inconsistent);
+    ASSERT_EQ(table.read()->generation, 200);
+    ASSERT_EQ(table.reclaim(), 0);
+}
+
+// Its destructor poisons it, so a reader of a reclaimed version sees the poison (unless the memory is already reused)
+struct poisoned_on_destruction
+{
+    static constexpr std::uint64_t alive = 0xA11FE;
+    static constexpr std::uint64_t destroyed = 0xDEAD;
+
+    std::uint64_t state = alive;
+
+    poisoned_on_destruction() = default;
+    poisoned_on_destruction(const poisoned_on_destruction &other) = default;
+    poisoned_on_destruction &operator=(const poisoned_on_destruction &other) = default;
+
+    ~poisoned_on_destruction()
+    {
+        state = destroyed;
+    }
+};
+
+TEST(rcu_test, back_to_back_publishing_against_readers)
+{
+    rcu_synchronized<poisoned_on_destruction> instance;
+    std::atomic<bool> stop = false;
+    std::atomic<bool> reclaimed_while_read = false;
+
+    std::vector<std::jthread> readers;
+    for (int i = 0; i < 4; i++)
+    {
+        readers.emplace_back([&]() {
+            while (!stop)
+            {
+                if (instance.read()->state != poisoned_on_destruction::alive)
+                {
+                    reclaimed_while_read = true;
+                }
+            }
+        });
+    }
+
+    // Two writers, each publishing twice in a row, so the parity flips back while the readers are in the middle of borrowing
+    std::vector<std::jthread> writers;
+    for (int i = 0; i < 2; i++)
+    {
+        writers.emplace_back([&]() {
+            for (int j = 0; j < 2000; j++)
+            {
+                instance = poisoned_on_destruction{};
+                instance = poisoned_on_destruction{};
+            }
+        });
+    }
+    writers.clear();
+
+    stop = true;
+    readers.clear();
+
+    ASSERT_FALSE(reclaimed_while_read);
+    ASSERT_EQ(instance.reclaim(), 0);
+}
+
+}  // namespace saam::test
@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/synchronized.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+namespace saam::test
+{
+
+static_assert(lock_policy<reader_biased_mutex_policy> && reader_biased_mutex_policy::is_shared);
+static_assert(std::is_copy_constructible_v<guard<const int, reader_biased_mutex_policy>>);
+
+TEST(reader_biased_test, writer_revokes_the_bias)
+{
+    reader_biased_mutex mutex;
+    ASSERT_TRUE(mutex.is_read_biased());
+
+    mutex.lock_shared();
+    mutex.unlock_shared();
+    ASSERT_TRUE(mutex.is_read_biased());
+
+    mutex.lock();
+    ASSERT_FALSE(mutex.is_read_biased());
+    mutex.unlock();
+}
+
+TEST(reader_biased_test, reader_restores_the_bias_later)
+{
+    reader_biased_mutex mutex;
+    {
+        std::unique_lock writer(mutex);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    {
+        std::shared_lock reader(mutex);
+    }
+    ASSERT_TRUE(mutex.is_read_biased());
+}
+
+TEST(reader_biased_test, try_lock_fails_beside_biased_readers)
+{
+    reader_biased_mutex mutex;
+    std::shared_lock reader(mutex);
+
+    std::jthread([&mutex]() { ASSERT_FALSE(mutex.try_lock()); }).join();
+    ASSERT_FALSE(mutex.is_read_biased());
+
+    reader.unlock();
+    ASSERT_TRUE(mutex.try_lock());
+    mutex.unlock();
+}
+
+TEST(reader_biased_test, writer_waits_for_the_biased_readers)
+{
+    reader_biased_mutex mutex;
+    std::atomic<bool> written = false;
+
+    std::shared_lock reader(mutex);
+    std::jthread writer([&]() {
+        std::unique_lock lock(mutex);
+        written = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_FALSE(written);
+    reader.unlock();
+    writer.join();
+    ASSERT_TRUE(written);
+}
+
+TEST(reader_biased_test, more_shared_locks_than_held_biased_locks)
+{
+    synchronized<int, reader_biased_mutex_policy> number(5);
+
+    std::vector<guard<const int, reader_biased_mutex_policy>> guards;
+    for (std::size_t i = 0; i < 2 * reader_biased_mutex::max_held_biased_locks; i++)
+    {
+        guards.push_back(number.commence());
+    }
+    ASSERT_FALSE(number.try_commence_mut().has_value());
+
+    guards.clear();
+    ASSERT_TRUE(number.try_commence_mut().has_value());
+}
+
+TEST(reader_biased_test, readers_see_consistent_writes)
+{
+    struct pair
+    {
+        int first = 0;
+        int second = 0;
+    };
+    synchronized<pair, reader_biased_mutex_policy> numbers;
+
+    std::atomic<bool> stop = false;
+    std::vector<std::jthread> readers;
+    for (int i = 0; i < 4; i++)
+    {
+        readers.emplace_back([&]() {
+            while (!stop)
+            {
+                const auto reading = numbers.commence();
+                ASSERT_EQ(reading->first, reading->second);
+            }
+        });
+    }
+
+    for (int i = 0; i < 1000; i++)
+    {
+        auto writing = numbers.commence_mut();
+        writing->first++;
+        writing->second++;
+    }
+    stop = true;
+    readers.clear();
+
+    ASSERT_EQ(numbers.commence()->first, 1000);
+}
+
+}  // namespace saam::test
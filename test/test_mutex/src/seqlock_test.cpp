@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/synchronized.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace saam::test
+{
+
+struct telemetry
+{
+    telemetry(std::uint64_t sample) :
+        sample(sample),
+        sample_squared(sample * sample)
+    {
+    }
+
+    std::uint64_t sample;
+    std::uint64_t sample_squared;
+};
+
+// The optimistic read needs no extra state, when the lock policy does not support it
+static_assert(sizeof(synchronized<telemetry, mutex_policy>) == sizeof(std::mutex) + sizeof(var<telemetry>) + sizeof(detail::guard_counter<>));
+
+TEST(seqlock_test, snapshot)
+{
+    synchronized<telemetry, seqlock_policy> state(telemetry{3});
+
+    ASSERT_EQ(state.snapshot().sample_squared, 9);
+
+    state = telemetry{4};
+    ASSERT_EQ(state.snapshot().sample_squared, 16);
+
+    state.commence_mut()->sample = 5;
+    ASSERT_EQ(state.snapshot().sample, 5);
+}
+
+TEST(seqlock_test, snapshot_is_never_torn)
+{
+    synchronized<telemetry, seqlock_policy> state(telemetry{0});
+    std::atomic<bool> stop = false;
+    std::atomic<bool> torn = false;
+
+    std::vector<std::jthread> readers;
+    for (int i = 0; i < 4; i++)
+    {
+        readers.emplace_back([&]() {
+            while (!stop)
+            {
+                const auto copy = state.snapshot();
+                if (copy.sample * copy.sample != copy.sample_squared)
+                {
+                    torn = true;
+                }
+            }
+        });
+    }
+
+    for (std::uint64_t sample = 1; sample < 100000; sample++)
+    {
+        auto state_guard = state.commence_mut();
+        state_guard->sample = sample;
+        state_guard->sample_squared = sample * sample;
+    }
+
+    stop = true;
+    readers.clear();
+
+    ASSERT_FALSE(torn);
+    ASSERT_EQ(state.snapshot().sample, 99999);
+}
+
+}  // namespace saam::test
@@ -0,0 +1,122 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/sharded_synchronized.hpp>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace saam::test
+{
+
+static_assert(sharded_synchronized<std::unordered_map<int, int>>::shard_count == SAAM_SHARD_COUNT);
+static_assert(alignof(sharded_synchronized<std::map<int, int>, 4, mutex_policy>) >= 64);
+
+TEST(sharded_synchronized_test, key_is_in_its_shard)
+{
+    sharded_synchronized<std::unordered_map<std::string, int>> counts;
+    counts.commence_mut("apple")->emplace("apple", 1);
+    counts.commence_mut("pear")->emplace("pear", 2);
+
+    ASSERT_EQ(counts.commence("apple")->at("apple"), 1);
+    ASSERT_EQ(counts.commence("pear")->at("pear"), 2);
+    ASSERT_EQ(counts.shard(counts.shard_index("pear")).commence()->count("pear"), 1);
+    ASSERT_EQ(counts.size(), 2);
+}
+
+TEST(sharded_synchronized_test, keys_are_spread_over_the_shards)
+{
+    // std::hash of the integers may be the identity, the multiples of the shard count must not end up in the same shard
+    const sharded_synchronized<std::unordered_map<std::size_t, int>, 8> map;
+    std::set<std::size_t> used_shards;
+    for (std::size_t key = 0; key < 64 * 8; key += 8)
+    {
+        used_shards.insert(map.shard_index(key));
+    }
+    ASSERT_EQ(used_shards.size(), 8);
+}
+
+TEST(sharded_synchronized_test, disjoint_keys_are_updated_in_parallel)
+{
+    sharded_synchronized<std::unordered_map<int, int>, 4> map;
+    int other_key = 1;
+    while (map.shard_index(other_key) == map.shard_index(0))
+    {
+        other_key++;
+    }
+
+    // The guard of a key does not block the other shards
+    auto holding = map.commence_mut(0);
+    std::jthread([&map, other_key]() {
+        auto other_guard = map.try_commence_mut(other_key);
+        ASSERT_TRUE(other_guard.has_value());
+        (**other_guard)[other_key] = 1;
+    }).join();
+}
+
+TEST(sharded_synchronized_test, parallel_increments)
+{
+    sharded_synchronized<std::unordered_map<int, int>> map;
+
+    std::vector<std::jthread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&map]() {
+            for (int j = 0; j < 10000; j++)
+            {
+                (*map.commence_mut(j % 100))[j % 100]++;
+            }
+        });
+    }
+    threads.clear();
+
+    std::size_t elements = 0;
+    for (const auto &shard_guard : map.commence_all())
+    {
+        for (const auto &[key, count] : *shard_guard)
+        {
+            ASSERT_EQ(count, 400);
+            elements++;
+        }
+    }
+    ASSERT_EQ(elements, 100);
+}
+
+TEST(sharded_synchronized_test, whole_container_guards_do_not_deadlock)
+{
+    sharded_synchronized<std::map<int, int>, 8, mutex_policy> map;
+
+    std::vector<std::jthread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&map, i]() {
+            for (int j = 0; j < 200; j++)
+            {
+                if (j % 2 == 0)
+                {
+                    auto shard_guards = map.commence_all_mut();
+                    ASSERT_EQ(shard_guards.size(), 8);
+                    for (auto &shard_guard : shard_guards)
+                    {
+                        shard_guard->clear();
+                    }
+                }
+                else
+                {
+                    (*map.commence_mut(i * 1000 + j))[i * 1000 + j] = j;
+                }
+            }
+        });
+    }
+}
+
+}  // namespace saam::test
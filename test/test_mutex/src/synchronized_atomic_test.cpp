@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/synchronized_atomic.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace saam::test
+{
+
+namespace
+{
+
+struct flags
+{
+    bool running = false;
+    bool paused = false;
+    std::uint16_t generation = 0;
+};
+
+template <typename TSynchronizedAtomic>
+concept waitable = requires(const TSynchronizedAtomic &instance) { instance.wait(false); };
+
+}  // namespace
+
+static_assert(lock_free_atomic<int> && lock_free_atomic<std::uint64_t> && lock_free_atomic<flags>);
+static_assert(!lock_free_atomic<std::string> && !lock_free_atomic<const int>);
+// The instance is not reachable directly
+static_assert(!std::is_convertible_v<synchronized_atomic<int> &, int &>);
+// Only the waitable instances can be waited for
+static_assert(waitable<synchronized_atomic<bool, true>> && !waitable<synchronized_atomic<bool>>);
+
+TEST(synchronized_atomic_test, load_store_exchange)
+{
+    synchronized_atomic<int> number(1);
+    ASSERT_EQ(number.load(), 1);
+
+    number.store(2);
+    ASSERT_EQ(number.exchange(3), 2);
+
+    int expected = 2;
+    ASSERT_FALSE(number.compare_exchange(expected, 4));
+    ASSERT_EQ(expected, 3);
+    ASSERT_TRUE(number.compare_exchange(expected, 4));
+
+    const synchronized_atomic<int> copied(number);
+    ASSERT_EQ(copied.load(), 4);
+}
+
+TEST(synchronized_atomic_test, update_struct)
+{
+    synchronized_atomic<flags> state;
+    const auto updated = state.update([](flags current) {
+        current.running = true;
+        current.generation++;
+        return current;
+    });
+
+    ASSERT_TRUE(updated.running);
+    ASSERT_EQ(state.load().generation, 1);
+}
+
+TEST(synchronized_atomic_test, parallel_updates_are_not_lost)
+{
+    synchronized_atomic<std::uint64_t> counter;
+    {
+        std::vector<std::jthread> threads;
+        for (int thread = 0; thread < 8; thread++)
+        {
+            threads.emplace_back([&counter]() {
+                for (int i = 0; i < 10000; i++)
+                {
+                    counter.update([](std::uint64_t current) { return current + 1; });
+                }
+            });
+        }
+    }
+
+    ASSERT_EQ(counter.load(), 80000);
+}
+
+TEST(synchronized_atomic_test, wait_for_a_change)
+{
+    synchronized_atomic<bool, true> ready(false);
+    std::jthread producer([&ready]() { ready.store(true); });
+
+    ready.wait(false);
+    ASSERT_TRUE(ready.load());
+}
+
+TEST(synchronized_atomic_test, wait_for_an_update)
+{
+    synchronized_atomic<std::uint64_t, true> counter;
+    std::jthread producer([&counter]() { counter.update([](std::uint64_t current) { return current + 1; }); });
+
+    counter.wait(0);
+    ASSERT_EQ(counter.load(), 1);
+}
+
+}  // namespace saam::test
@@ -0,0 +1,307 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/synchronized.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <latch>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace saam::test
+{
+
+TEST(synchronized_test, emplace_creation)
+{
+    struct non_default_or_implicit_constructible
+    {
+        non_default_or_implicit_constructible(int value, std::string text) :
+            value(value),
+            text(std::move(text))
+        {
+        }
+
+        int value;
+        std::string text;
+    };
+
+    // Test the emplacement with a multi parameter constructor to check if the perfect forwarding of the arguments works correctly.
+    // With single argument constructor, the we may instantiate an implicit temporary object that gets copied/moved into the synchronized
+    // instead of emplaced.
+    saam::synchronized<non_default_or_implicit_constructible> numstr(std::in_place, 5, "Hello world");
+    ASSERT_EQ(numstr->value, 5);
+    ASSERT_EQ(numstr->text.length(), 11);
+}
+
+TEST(synchronized_test, instance_copy_creation)
+{
+    std::string hello{"Hello world"};
+    saam::synchronized<std::string> text(hello);
+    ASSERT_EQ(text->length(), 11);
+}
+
+TEST(synchronized_test, instance_move_creation)
+{
+    saam::synchronized<std::string> text(std::string("Hello world"));
+    ASSERT_EQ(text->length(), 11);
+}
+
+TEST(synchronized_test, copy_constructor)
+{
+    saam::synchronized<std::string> text(std::string("Hello world"));
+    saam::synchronized<std::string> text_copied(text);
+    ASSERT_EQ(text->length(), 11);
+    ASSERT_EQ(text_copied->length(), 11);
+}
+
+TEST(synchronized_test, move_constructor)
+{
+    saam::synchronized<std::string> text(std::string("Hello world"));
+    saam::synchronized<std::string> text_moved(std::move(text));
+    ASSERT_TRUE(text->empty());
+    ASSERT_EQ(text_moved->length(), 11);
+}
+
+TEST(synchronized_test, copy_assignment)
+{
+    saam::synchronized<std::string> text("Hello world");
+    saam::synchronized<std::string> text_copy;
+    text_copy = text;
+    ASSERT_EQ(*text.commence(), "Hello world");
+    ASSERT_EQ(*text_copy.commence(), "Hello world");
+}
+
+TEST(synchronized_test, move_assignment)
+{
+    saam::synchronized<std::string> text("Hello world");
+    saam::synchronized<std::string> text_moved;
+    text_moved = std::move(text);
+    ASSERT_TRUE(text->empty());
+    ASSERT_EQ(*text_moved.commence(), "Hello world");
+}
+
+TEST(synchronized_test, access_with_mutable_content)
+{
+    saam::synchronized<std::string> text("Hello world");
+
+    ASSERT_EQ(text.commence()->at(0), 'H');
+
+    text.commence_mut()->at(0) = 'Y';
+    ASSERT_EQ(text.commence()->at(0), 'Y');
+}
+
+TEST(synchronized_test, access_with_immutable_content)
+{
+    const saam::synchronized<std::string> text("Hello world");
+
+    ASSERT_EQ(text.commence()->at(0), 'H');
+}
+
+TEST(synchronized_test, copy_assignment_from_underlying)
+{
+    saam::synchronized<std::string> text("Hello world");
+    std::string text2("Hi There");
+    text = text2;
+    ASSERT_EQ(text2, "Hi There");
+    ASSERT_EQ(*text.commence(), "Hi There");
+}
+
+TEST(synchronized_test, move_assignment_from_underlying)
+{
+    saam::synchronized<std::string> text("Hello world");
+    std::string text2("Hi There");
+    text = std::move(text2);
+    ASSERT_TRUE(text2.empty());
+    ASSERT_EQ(*text.commence(), "Hi There");
+}
+
+TEST(synchronized_test, content_assignment)
+{
+    saam::synchronized<std::string> text("Hello world");
+    saam::synchronized<std::string> text_copy;
+    *text_copy.commence_mut() = *text.commence();
+    ASSERT_EQ(*text_copy.commence(), "Hello world");
+}
+
+TEST(synchronized_test, commence_all)
+{
+    saam::synchronized<std::string> text("Hello world");
+    saam::synchronized<int> number(42);
+
+    auto [text_guard, number_guard] = commence_all<const std::string, int>(text, number);
+
+    ASSERT_EQ(text_guard->at(0), 'H');
+
+    ASSERT_EQ(*number_guard, 42);
+    *number_guard = 43;
+    ASSERT_EQ(*number_guard, 43);
+}
+
+TEST(synchronized_test, commence_all_with_retry)
+{
+    saam::synchronized<std::string> text("Hello world");
+    saam::synchronized<int> number(42);
+
+    const auto acquisition_delay = std::chrono::milliseconds(100);
+
+    // This thread holds the mutex for a while, so the main thread acquisition does not succeed for the first time.
+    std::latch other_thread_started(1);
+    std::thread other_thread([&]() {
+        auto text_guard = text.commence_mut();
+        other_thread_started.count_down();
+        std::this_thread::sleep_for(acquisition_delay);
+    });
+
+    other_thread_started.wait();
+
+    auto before = std::chrono::steady_clock::now();
+    auto [text_guard, number_guard] = commence_all<const std::string, int>(text, number);
+    auto after = std::chrono::steady_clock::now();
+
+    const auto acquisition_duration = std::chrono::duration_cast<std::chrono::milliseconds>(after - before);
+    ASSERT_GE(acquisition_duration, acquisition_delay);
+
+    other_thread.join();
+}
+
+TEST(synchronized_test, commence_all_in_opposite_orders)
+{
+    saam::synchronized<int> first(0);
+    saam::synchronized<int> second(0);
+
+    // The locks are acquired in the same global order, independently of the argument order, so the threads cannot deadlock
+    std::thread other_thread([&]() {
+        for (int i = 0; i < 1000; i++)
+        {
+            auto [second_guard, first_guard] = commence_all<int, int>(second, first);
+            (*first_guard)++;
+            (*second_guard)++;
+        }
+    });
+
+    for (int i = 0; i < 1000; i++)
+    {
+        auto [first_guard, second_guard] = commence_all<int, int>(first, second);
+        (*first_guard)++;
+        (*second_guard)++;
+    }
+
+    other_thread.join();
+
+    ASSERT_EQ(*first.commence(), 2000);
+    ASSERT_EQ(*second.commence(), 2000);
+}
+
+TEST(synchronized_test, commence_all_same_synchronized_shared)
+{
+    saam::synchronized<std::string> text("Hello world");
+    saam::synchronized<int> number(42);
+
+    auto [text_guard, number_guard, other_text_guard] = commence_all<const std::string, int, const std::string>(text, number, text);
+
+    ASSERT_EQ(*text_guard, *other_text_guard);
+    ASSERT_EQ(*number_guard, 42);
+}
+
+TEST(synchronized_test, commence_all_same_synchronized_shares_one_lock)
+{
+    saam::synchronized<std::string> text("Hello world");
+
+    auto [text_guard, other_text_guard] = commence_all<const std::string, const std::string>(text, text);
+    ASSERT_EQ(text_guard.get_lock().mutex(), other_text_guard.get_lock().mutex());
+
+    // The lock is held until the last guard sharing it is released
+    {
+        [[maybe_unused]] auto released = std::move(text_guard);
+    }
+    ASSERT_FALSE(text.try_commence_mut().has_value());
+    ASSERT_EQ(*other_text_guard, "Hello world");
+
+    {
+        [[maybe_unused]] auto released = std::move(other_text_guard);
+    }
+    ASSERT_TRUE(text.try_commence_mut().has_value());
+
+    std::vector<saam::synchronized<std::string> *> duplicates{&text, &text, &text};
+    auto guards = commence_all<const std::string>(duplicates);
+    ASSERT_EQ(guards[0].get_lock().mutex(), guards[2].get_lock().mutex());
+    guards.pop_back();
+    ASSERT_FALSE(text.try_commence_mut().has_value());
+    guards.clear();
+    ASSERT_TRUE(text.try_commence_mut().has_value());
+}
+
+TEST(synchronized_death_test, commence_all_same_synchronized_mutable)
+{
+    saam::synchronized<std::string> text("Hello world");
+    const auto mixed_duplicate = [&text]() { [[maybe_unused]] auto guards = commence_all<const std::string, std::string>(text, text); };
+    EXPECT_DEATH(mixed_duplicate(), ".*");
+
+    const auto mutable_duplicates = [&text]() {
+        std::vector<saam::synchronized<std::string> *> duplicates{&text, &text};
+        [[maybe_unused]] auto guards = commence_all<std::string>(duplicates);
+    };
+    EXPECT_DEATH(mutable_duplicates(), ".*");
+}
+
+TEST(synchronized_test, commence_all_range)
+{
+    std::vector<saam::synchronized<int>> shards(4);
+
+    {
+        auto guards = commence_all<int>(shards);
+        ASSERT_EQ(guards.size(), 4);
+        for (int i = 0; i < 4; i++)
+        {
+            *guards[i] = i;
+        }
+    }
+
+    // A runtime selected subset, in any order
+    std::vector<saam::synchronized<int> *> touched{&shards[3], &shards[1]};
+    auto guards = commence_all<const int>(touched);
+    ASSERT_EQ(*guards[0], 3);
+    ASSERT_EQ(*guards[1], 1);
+}
+
+TEST(synchronized_test, commence_all_range_in_opposite_orders)
+{
+    std::vector<saam::synchronized<int>> shards(8);
+
+    std::vector<std::reference_wrapper<saam::synchronized<int>>> forward(shards.begin(), shards.end());
+    std::vector<std::reference_wrapper<saam::synchronized<int>>> backward(shards.rbegin(), shards.rend());
+
+    std::thread other_thread([&]() {
+        for (int i = 0; i < 1000; i++)
+        {
+            for (auto &guard : commence_all<int>(backward))
+            {
+                (*guard)++;
+            }
+        }
+    });
+
+    for (int i = 0; i < 1000; i++)
+    {
+        for (auto &guard : commence_all<int>(forward))
+        {
+            (*guard)++;
+        }
+    }
+
+    other_thread.join();
+
+    for (const auto &shard : shards)
+    {
+        ASSERT_EQ(*shard.commence(), 2000);
+    }
+}
+
+}  // namespace saam::test
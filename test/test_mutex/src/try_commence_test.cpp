@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/synchronized.hpp>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <latch>
+#include <string>
+#include <thread>
+
+namespace saam::test
+{
+
+// Timed acquisition needs a timed mutex
+static_assert(!timed_lock_policy<shared_mutex_policy>);
+static_assert(timed_lock_policy<shared_timed_mutex_policy>);
+static_assert(timed_lock_policy<timed_mutex_policy>);
+
+TEST(try_commence_test, available)
+{
+    synchronized<std::string> text("Hello world");
+
+    {
+        auto mut_guard = text.try_commence_mut();
+        ASSERT_TRUE(mut_guard.has_value());
+        **mut_guard = "Welcome world";
+    }
+
+    auto guard = text.try_commence();
+    ASSERT_TRUE(guard.has_value());
+    ASSERT_EQ(**guard, "Welcome world");
+}
+
+TEST(try_commence_test, held_by_other_thread)
+{
+    synchronized<std::string, shared_timed_mutex_policy> text("Hello world");
+
+    std::latch locked(1);
+    std::latch done(1);
+    std::thread batch_job([&]() {
+        auto guard = text.commence_mut();
+        locked.count_down();
+        done.wait();
+    });
+    locked.wait();
+
+    ASSERT_FALSE(text.try_commence().has_value());
+    ASSERT_FALSE(text.try_commence_mut().has_value());
+
+    const auto timeout = std::chrono::milliseconds(20);
+    const auto before = std::chrono::steady_clock::now();
+    ASSERT_FALSE(text.try_commence_for(timeout).has_value());
+    ASSERT_GE(std::chrono::steady_clock::now() - before, timeout);
+    ASSERT_FALSE(text.try_commence_mut_until(std::chrono::steady_clock::now() + timeout).has_value());
+
+    done.count_down();
+    batch_job.join();
+
+    ASSERT_TRUE(text.try_commence_mut_for(timeout).has_value());
+    ASSERT_TRUE(text.try_commence_until(std::chrono::steady_clock::now() + timeout).has_value());
+}
+
+TEST(try_commence_test, timed_exclusive)
+{
+    synchronized<int, timed_mutex_policy> number(42);
+
+    auto guard = number.try_commence_for(std::chrono::milliseconds(10));
+    ASSERT_TRUE(guard.has_value());
+    ASSERT_EQ(**guard, 42);
+}
+
+}  // namespace saam::test
@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/synchronized.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace saam::test
+{
+
+using cache_t = std::map<int, std::string>;
+
+TEST(upgrade_test, upgrade_on_miss)
+{
+    synchronized<cache_t, upgrade_mutex_policy> cache;
+
+    auto checked = cache.commence_upgradable();
+    ASSERT_FALSE(checked->contains(1));
+
+    auto inserting = std::move(checked).upgrade();
+    inserting->emplace(1, "one");
+
+    auto reading = std::move(inserting).downgrade();
+    ASSERT_EQ(reading->at(1), "one");
+}
+
+TEST(upgrade_test, coexists_with_shared_guards)
+{
+    synchronized<cache_t, upgrade_mutex_policy> cache(cache_t{{1, "one"}});
+
+    auto reader = cache.commence();
+    auto upgrader = cache.commence_upgradable();
+    ASSERT_EQ(reader->at(1), upgrader->at(1));
+
+    // Only one upgrader at a time
+    std::atomic<bool> other_upgraded = false;
+    std::thread other_upgrader([&]() {
+        [[maybe_unused]] auto other = cache.commence_upgradable();
+        other_upgraded = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_FALSE(other_upgraded);
+
+    auto downgraded = std::move(upgrader).downgrade();
+    other_upgrader.join();
+    ASSERT_TRUE(other_upgraded);
+}
+
+TEST(upgrade_test, insert_once_under_contention)
+{
+    synchronized<cache_t, upgrade_mutex_policy> cache;
+    std::atomic<int> num_inserts = 0;
+
+    std::vector<std::jthread> threads;
+    for (int i = 0; i < 8; i++)
+    {
+        threads.emplace_back([&]() {
+            for (int key = 0; key < 100; key++)
+            {
+                auto checked = cache.commence_upgradable();
+                if (checked->contains(key))
+                {
+                    continue;
+                }
+
+                // No other writer can insert between the check and the upgrade
+                auto inserting = std::move(checked).upgrade();
+                inserting->emplace(key, std::to_string(key));
+                num_inserts++;
+            }
+        });
+    }
+    threads.clear();
+
+    ASSERT_EQ(num_inserts, 100);
+    ASSERT_EQ(cache.commence()->size(), 100);
+}
+
+}  // namespace saam::test
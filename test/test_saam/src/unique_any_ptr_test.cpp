@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/unique_any_ptr.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace
+{
+
+class base
+{
+  public:
+    base() = default;
+    virtual ~base() = default;
+    virtual std::string get_name() const
+    {
+        return "base";
+    }
+};
+
+class derived : public base
+{
+  public:
+    derived() = default;
+    ~derived() override = default;
+    std::string get_name() const override
+    {
+        return "derived";
+    }
+};
+
+}  // namespace
+
+namespace saam::test
+{
+
+class unique_any_ptr_test : public ::testing::Test
+{
+};
+
+static_assert(!std::is_copy_constructible_v<saam::unique_any_ptr<base>>);
+static_assert(std::is_nothrow_move_constructible_v<saam::unique_any_ptr<base>>);
+// The unique_ptr is stored inline, there is no control block
+static_assert(saam::detail::unique_any_ptr_owner::is_stored_inline<std::unique_ptr<base>>);
+
+TEST_F(unique_any_ptr_test, unique_ptr_is_owned)
+{
+    saam::unique_any_ptr<base> base_ptr = saam::make_unique_any_ptr(std::make_unique<derived>());
+    ASSERT_EQ(base_ptr->get_name(), "derived");
+
+    auto *instance = &*base_ptr;
+    saam::unique_any_ptr<const base> moved(std::move(base_ptr));
+    ASSERT_FALSE(base_ptr);
+    ASSERT_EQ(&*moved, instance);
+
+    moved.reset();
+    ASSERT_FALSE(moved);
+}
+
+TEST_F(unique_any_ptr_test, var_is_owned)
+{
+    saam::var<derived> instance;
+    saam::unique_any_ptr<derived> derived_ptr = saam::make_unique_any_ptr(std::move(instance));
+    auto *address = &*derived_ptr;
+
+    // The owned var does not move with the unique_any_ptr
+    saam::unique_any_ptr<base> base_ptr = std::move(derived_ptr);
+    ASSERT_EQ(&*base_ptr, address);
+    ASSERT_EQ(base_ptr->get_name(), "derived");
+}
+
+TEST_F(unique_any_ptr_test, ref_is_owned)
+{
+    saam::var<derived> instance;
+    {
+        saam::unique_any_ptr<base> base_ptr = saam::make_unique_any_ptr(instance);
+        ASSERT_EQ(base_ptr->get_name(), "derived");
+    }
+    // The ref is released, the var can be destroyed
+}
+
+TEST_F(unique_any_ptr_test, share)
+{
+    saam::unique_any_ptr<base> base_ptr = saam::make_unique_any_ptr(std::make_unique<derived>());
+    auto *instance = &*base_ptr;
+
+    saam::any_ptr<base> shared = std::move(base_ptr).share();
+    ASSERT_FALSE(base_ptr);
+
+    saam::any_ptr<base> copy = shared;
+    shared.reset();
+    ASSERT_EQ(&*copy, instance);
+    ASSERT_EQ(copy->get_name(), "derived");
+
+    derived raw;
+    ASSERT_EQ(&*saam::make_unique_any_ptr(raw).share(), &raw);
+}
+
+}  // namespace saam::test
@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/safe_ref.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace saam::test
+{
+
+namespace
+{
+
+void print_panic(const std::type_info &,
+                 void *,
+                 std::size_t num_dangling_references,
+                 const std::vector<saam::raw_stacktrace> &sampled_ref_creation_stacks)
+{
+    std::size_t num_captured_stacks = 0;
+    for (const auto &creation_stack : sampled_ref_creation_stacks)
+    {
+        num_captured_stacks += creation_stack.empty() ? 0 : 1;
+    }
+    std::cerr << num_dangling_references << " dangling references, " << num_captured_stacks << " sampled\n";
+}
+
+}  // namespace
+
+TEST(sampled_test, copy_and_move_sampled_refs)
+{
+    saam::sampled_creation_stack_rate = 1;
+
+    saam::var<std::string> text("Hello world");
+    saam::var<std::string> other_text("Welcome");
+
+    saam::ref<std::string> text_ref = text.borrow();
+    auto copied_ref = text_ref;
+    auto moved_ref = std::move(copied_ref);
+    moved_ref = other_text.borrow();
+    text_ref = std::move(moved_ref);
+
+    ASSERT_EQ(*text_ref, "Welcome");
+
+    saam::sampled_creation_stack_rate = 64;
+}
+
+TEST(sampled_test, all_refs_are_sampled)
+{
+    auto leave_dangling_refs = []() {
+        saam::sampled_creation_stack_rate = 1;
+        saam::dangling_reference_panic = print_panic;
+
+        std::vector<saam::ref<std::string>> refs;
+        saam::var<std::string> text("Hello world");
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            refs.emplace_back(text.borrow());
+        }
+        // The released refs are not reported
+        auto released_ref = text.borrow();
+    };
+
+    EXPECT_DEATH({ leave_dangling_refs(); }, "3 dangling references, 3 sampled");
+}
+
+TEST(sampled_test, part_of_the_refs_are_sampled)
+{
+    auto leave_dangling_refs = []() {
+        saam::sampled_creation_stack_rate = 4;
+        saam::dangling_reference_panic = print_panic;
+
+        std::vector<saam::ref<std::string>> refs;
+        saam::var<std::string> text("Hello world");
+        for (std::size_t i = 0; i < 8; i++)
+        {
+            refs.emplace_back(text.borrow());
+        }
+    };
+
+    // All the dangling refs are counted, but only 1 in 4 has a creation stack
+    EXPECT_DEATH({ leave_dangling_refs(); }, "8 dangling references, 2 sampled");
+}
+
+TEST(sampled_test, no_refs_are_sampled)
+{
+    auto leave_dangling_refs = []() {
+        saam::sampled_creation_stack_rate = 0;
+        saam::dangling_reference_panic = print_panic;
+
+        std::optional<saam::ref<const std::string>> text_ref;
+        saam::var<std::string> text{"hello"};
+        text_ref = text;
+    };
+
+    EXPECT_DEATH({ leave_dangling_refs(); }, "1 dangling references, 0 sampled");
+}
+
+}  // namespace saam::test
@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/safe_ref.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace saam::test
+{
+
+TEST(tracked_chain_test, release_refs_in_any_order)
+{
+    saam::var<std::string> text("Hello world");
+
+    std::vector<std::optional<saam::ref<std::string>>> refs;
+    for (std::size_t i = 0; i < 100; i++)
+    {
+        refs.emplace_back(text.borrow());
+    }
+
+    // Release the middle, then the oldest, then the newest ones
+    for (std::size_t i = 25; i < 75; i++)
+    {
+        refs[i].reset();
+    }
+    for (std::size_t i = 0; i < 25; i++)
+    {
+        refs[i].reset();
+    }
+    for (std::size_t i = 99; i >= 75; i--)
+    {
+        refs[i].reset();
+    }
+}
+
+TEST(tracked_chain_test, move_refs_inside_the_chain)
+{
+    saam::var<std::string> text("Hello world");
+
+    auto first = text.borrow();
+    auto middle = text.borrow();
+    auto last = text.borrow();
+
+    // Move construction and move assignment replace the ref in its chain position
+    auto moved_middle = std::move(middle);
+    std::optional<saam::ref<std::string>> assigned;
+    assigned = std::move(first);
+    assigned = std::move(last);
+
+    ASSERT_EQ(*moved_middle, "Hello world");
+    ASSERT_EQ(**assigned, "Hello world");
+}
+
+TEST(tracked_chain_test, borrow_census)
+{
+    saam::var<std::string> text("Hello world");
+    ASSERT_TRUE(text.borrow_census().empty());
+
+    std::vector<saam::ref<std::string>> refs;
+    for (std::size_t i = 0; i < 2; i++)
+    {
+        refs.emplace_back(text.borrow());
+    }
+    refs.emplace_back(text.borrow());
+    ASSERT_EQ(text.num_borrows(), 3);
+
+    // The refs are counted per creation site
+    const auto census = text.borrow_census();
+    ASSERT_EQ(census.size(), 2);
+    ASSERT_EQ(census[0].num_references + census[1].num_references, 3);
+    ASSERT_FALSE(census[0].creation_stack->empty());
+    ASSERT_NE(*census[0].creation_stack, *census[1].creation_stack);
+
+    refs.clear();
+    ASSERT_EQ(text.num_borrows(), 0);
+}
+
+TEST(tracked_chain_test, borrow_census_while_borrowing)
+{
+    saam::var<std::string> text("Hello world");
+    std::atomic<bool> stop = false;
+
+    std::vector<std::jthread> borrowers;
+    for (int i = 0; i < 2; i++)
+    {
+        borrowers.emplace_back([&]() {
+            while (!stop)
+            {
+                std::vector<saam::ref<std::string>> refs{text.borrow(), text.borrow()};
+            }
+        });
+    }
+
+    // The creation sites are read under the lock, while the other threads register and unregister their refs
+    for (int i = 0; i < 1000; i++)
+    {
+        std::size_t num_references = 0;
+        for (const auto &site : text.borrow_census())
+        {
+            num_references += site.num_references;
+        }
+        ASSERT_LE(num_references, 4);
+    }
+
+    stop = true;
+    borrowers.clear();
+    ASSERT_EQ(text.num_borrows(), 0);
+}
+
+TEST(tracked_chain_test, report_remaining_dangling_refs)
+{
+    auto leave_dangling_refs = []() {
+        saam::dangling_reference_panic = [](const std::type_info &,
+                                            void *,
+                                            const std::stacktrace &,
+                                            std::size_t num_dangling_references,
+                                            const saam::raw_stacktrace &) { std::cerr << num_dangling_references << " dangling\n"; };
+
+        std::vector<std::optional<saam::ref<std::string>>> refs;
+        saam::var<std::string> text("Hello world");
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            refs.emplace_back(text.borrow());
+        }
+        // Only the first and last refs outlive the var
+        refs[1].reset();
+    };
+
+    // Both of them were created at the same site, so they are reported together
+    EXPECT_DEATH({ leave_dangling_refs(); }, "^2 dangling\n$");
+}
+
+}  // namespace saam::test
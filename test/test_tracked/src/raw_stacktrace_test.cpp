@@ -0,0 +1,155 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/detail/stacktrace_site_registry.hpp>
+#include <saam/safe_ref.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace saam::test
+{
+
+TEST(tracked_raw_stacktrace_test, default_constructed_is_empty)
+{
+    saam::raw_stacktrace stacktrace;
+    ASSERT_TRUE(stacktrace.empty());
+    ASSERT_EQ(stacktrace.size(), 0);
+    ASSERT_TRUE(stacktrace.frames().empty());
+}
+
+TEST(tracked_raw_stacktrace_test, capture_and_print)
+{
+    const auto stacktrace = saam::raw_stacktrace::current();
+    ASSERT_FALSE(stacktrace.empty());
+    ASSERT_LE(stacktrace.size(), saam::raw_stacktrace::max_depth);
+
+    std::ostringstream printed;
+    printed << stacktrace;
+    ASSERT_THAT(printed.str(), ::testing::StartsWith("0# "));
+}
+
+TEST(tracked_raw_stacktrace_test, sampled_creation_stacks)
+{
+    auto leave_dangling_refs = []() {
+        saam::creation_stack_sampling_rate = 2;
+        saam::dangling_reference_panic = [](const std::type_info &,
+                                            void *,
+                                            const std::stacktrace &,
+                                            std::size_t num_dangling_references,
+                                            const saam::raw_stacktrace &dangling_ref_creation_stack) {
+            std::cerr << (dangling_ref_creation_stack.empty() ? "unsampled " : "sampled ") << num_dangling_references << '\n';
+        };
+
+        std::vector<saam::ref<std::string>> refs;
+        saam::var<std::string> text("Hello world");
+        for (std::size_t i = 0; i < 4; i++)
+        {
+            refs.emplace_back(text.borrow());
+        }
+    };
+
+    // Every second ref creation stack is captured, the unsampled refs are reported first
+    EXPECT_DEATH({ leave_dangling_refs(); }, "^unsampled 2\nsampled 2\n$");
+}
+
+TEST(tracked_raw_stacktrace_test, disabled_creation_stacks)
+{
+    auto leave_dangling_ref = []() {
+        saam::creation_stack_sampling_rate = 0;
+        saam::dangling_reference_panic = [](const std::type_info &,
+                                            void *,
+                                            const std::stacktrace &,
+                                            std::size_t num_dangling_references,
+                                            const saam::raw_stacktrace &dangling_ref_creation_stack) {
+            std::cerr << (dangling_ref_creation_stack.empty() ? "unsampled " : "sampled ") << num_dangling_references << '\n';
+        };
+
+        std::vector<saam::ref<std::string>> refs;
+        saam::var<std::string> text("Hello world");
+        refs.emplace_back(text.borrow());
+    };
+
+    EXPECT_DEATH({ leave_dangling_ref(); }, "^unsampled 1\n$");
+}
+
+TEST(tracked_raw_stacktrace_test, interned_sites_are_shared)
+{
+    std::vector<saam::raw_stacktrace> stacktraces;
+    for (std::size_t i = 0; i < 2; i++)
+    {
+        stacktraces.push_back(saam::raw_stacktrace::current());
+    }
+    // Captured on the stack of another thread
+    saam::raw_stacktrace other_stacktrace;
+    std::jthread([&other_stacktrace]() { other_stacktrace = saam::raw_stacktrace::current(); }).join();
+
+    const auto site = saam::detail::stacktrace_site_registry::intern(stacktraces[0]);
+    ASSERT_NE(site, saam::no_stacktrace_site);
+    ASSERT_EQ(saam::detail::stacktrace_site_registry::intern(stacktraces[1]), site);
+    ASSERT_NE(saam::detail::stacktrace_site_registry::intern(other_stacktrace), site);
+    ASSERT_EQ(saam::detail::stacktrace_site_registry::site(site), stacktraces[0]);
+
+    ASSERT_EQ(saam::detail::stacktrace_site_registry::intern(saam::raw_stacktrace{}), saam::no_stacktrace_site);
+    ASSERT_TRUE(saam::detail::stacktrace_site_registry::site(saam::no_stacktrace_site).empty());
+}
+
+TEST(tracked_raw_stacktrace_test, parallel_interning)
+{
+    const auto stacktrace = saam::raw_stacktrace::current();
+    const auto site = saam::detail::stacktrace_site_registry::intern(stacktrace);
+
+    std::vector<std::jthread> threads;
+    std::atomic<std::size_t> mismatches = 0;
+    for (std::size_t i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&]() {
+            for (std::size_t j = 0; j < 1000; j++)
+            {
+                const auto local_site = saam::detail::stacktrace_site_registry::intern(saam::raw_stacktrace::current());
+                if (saam::detail::stacktrace_site_registry::intern(stacktrace) != site || local_site == saam::no_stacktrace_site)
+                {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    threads.clear();
+
+    ASSERT_EQ(mismatches, 0);
+}
+
+TEST(tracked_raw_stacktrace_test, dangling_refs_are_reported_per_creation_site)
+{
+    auto leave_dangling_refs = []() {
+        saam::creation_stack_sampling_rate = 1;
+        saam::dangling_reference_panic = [](const std::type_info &,
+                                            void *,
+                                            const std::stacktrace &,
+                                            std::size_t num_dangling_references,
+                                            const saam::raw_stacktrace &dangling_ref_creation_stack) {
+            std::cerr << (dangling_ref_creation_stack.empty() ? "unsampled " : "sampled ") << num_dangling_references << '\n';
+        };
+
+        std::vector<saam::ref<std::string>> refs;
+        saam::var<std::string> text("Hello world");
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            refs.emplace_back(text.borrow());
+        }
+        refs.emplace_back(text.borrow());
+    };
+
+    EXPECT_DEATH({ leave_dangling_refs(); }, "^sampled 3\nsampled 1\n$");
+}
+
+}  // namespace saam::test
@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: Leica Geosystems AG
+//
+// SPDX-License-Identifier: MIT
+
+#include <saam/safe_ref.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace saam::test
+{
+
+template <typename T>
+using striped_var = saam::var<T, saam::striped_tracked_borrow_manager>;
+
+template <typename T>
+using striped_ref = saam::ref<T, saam::striped_tracked_borrow_manager>;
+
+TEST(tracked_striped_test, var_overhead_is_one_pointer)
+{
+    static_assert(sizeof(striped_var<void *>) == 2 * sizeof(void *));
+    static_assert(sizeof(striped_var<void *>) < sizeof(saam::var<void *>));
+}
+
+TEST(tracked_striped_test, borrow_from_many_vars_and_threads)
+{
+    std::array<striped_var<int>, 16> numbers;
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&numbers]() {
+            for (std::size_t i = 0; i < 1000; i++)
+            {
+                for (const auto &number : numbers)
+                {
+                    striped_ref<int> number_ref = number.borrow();
+                    auto copied_ref = number_ref;
+                    auto moved_ref = std::move(copied_ref);
+                    (void)*moved_ref;
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+TEST(tracked_striped_test, dangling_ref_outlives_var)
+{
+    auto dangling_ref_outlives_var = []() {
+        std::optional<striped_ref<const std::string>> text_ref;
+        striped_var<std::string> text{"hello"};
+        text_ref = text;
+    };
+
+    EXPECT_DEATH({ dangling_ref_outlives_var(); }, ".*");
+}
+
+}  // namespace saam::test